@@ -0,0 +1,98 @@
+# Everything but main.cpp, so the tests (see tests/tests.pro) can build the same sources
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/highlighters/highlighter.cpp \
+    $$PWD/highlighters/grammar.cpp \
+    $$PWD/highlighters/grammarregistry.cpp \
+    $$PWD/highlighters/keywordtable.cpp \
+    $$PWD/highlighters/lexer.cpp \
+    $$PWD/highlighters/highlightworker.cpp \
+    $$PWD/highlighters/tokencache.cpp \
+    $$PWD/storage/textstorage.cpp \
+    $$PWD/storage/lineindex.cpp \
+    $$PWD/storage/lineindexer.cpp \
+    $$PWD/storage/mappedfilestorage.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/finddialog.cpp \
+    $$PWD/textsearcher.cpp \
+    $$PWD/regexsearcher.cpp \
+    $$PWD/regexsearchworker.cpp \
+    $$PWD/tabsearch.cpp \
+    $$PWD/searchresultspanel.cpp \
+    $$PWD/filesearch.cpp \
+    $$PWD/findinfilesmodel.cpp \
+    $$PWD/findinfilespanel.cpp \
+    $$PWD/editor.cpp \
+    $$PWD/metricreporter.cpp \
+    $$PWD/metricstracker.cpp \
+    $$PWD/byteoffsetindex.cpp \
+    $$PWD/encodedlength.cpp \
+    $$PWD/indenter.cpp \
+    $$PWD/bracketmatcher.cpp \
+    $$PWD/blockdata.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/utilityfunctions.cpp \
+    $$PWD/searchhistory.cpp \
+    $$PWD/gotodialog.cpp \
+    $$PWD/tabbededitor.cpp \
+    $$PWD/fileviewer.cpp \
+    $$PWD/fileloader.cpp \
+    $$PWD/textencoding.cpp \
+    $$PWD/utf8decoder.cpp \
+    $$PWD/filesaver.cpp \
+    $$PWD/loadprogress.cpp \
+    $$PWD/language.cpp
+
+HEADERS += \
+    $$PWD/highlighters/highlighter.h \
+    $$PWD/highlighters/grammar.h \
+    $$PWD/highlighters/grammarregistry.h \
+    $$PWD/highlighters/keywordtable.h \
+    $$PWD/highlighters/lexer.h \
+    $$PWD/highlighters/highlightworker.h \
+    $$PWD/highlighters/tokencache.h \
+    $$PWD/highlighters/styledrange.h \
+    $$PWD/storage/textstorage.h \
+    $$PWD/storage/lineindex.h \
+    $$PWD/storage/lineindexer.h \
+    $$PWD/storage/mappedfilestorage.h \
+    $$PWD/mainwindow.h \
+    $$PWD/documentmetrics.h \
+    $$PWD/finddialog.h \
+    $$PWD/textsearcher.h \
+    $$PWD/regexsearcher.h \
+    $$PWD/regexsearchworker.h \
+    $$PWD/tabsearch.h \
+    $$PWD/searchresultspanel.h \
+    $$PWD/filesearch.h \
+    $$PWD/findinfilesmodel.h \
+    $$PWD/findinfilespanel.h \
+    $$PWD/editor.h \
+    $$PWD/linenumberarea.h \
+    $$PWD/metricreporter.h \
+    $$PWD/metricstracker.h \
+    $$PWD/byteoffsetindex.h \
+    $$PWD/encodedlength.h \
+    $$PWD/indenter.h \
+    $$PWD/bracketmatcher.h \
+    $$PWD/blockdata.h \
+    $$PWD/settings.h \
+    $$PWD/utilityfunctions.h \
+    $$PWD/searchhistory.h \
+    $$PWD/gotodialog.h \
+    $$PWD/tabbededitor.h \
+    $$PWD/fileviewer.h \
+    $$PWD/fileloader.h \
+    $$PWD/textencoding.h \
+    $$PWD/utf8decoder.h \
+    $$PWD/filesaver.h \
+    $$PWD/loadprogress.h \
+    $$PWD/language.h
+
+FORMS += \
+        $$PWD/mainwindow.ui
+
+RESOURCES += \
+    $$PWD/resources.qrc
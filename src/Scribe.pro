@@ -24,54 +24,16 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 CONFIG += c++11
 
-SOURCES += \
-    highlighters/highlighter.cpp \
-    highlighters/chighlighter.cpp \
-    highlighters/cpphighlighter.cpp \
-    highlighters/javahighlighter.cpp \
-    highlighters/pythonhighlighter.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    finddialog.cpp \
-    editor.cpp \
-    metricreporter.cpp \
-    settings.cpp \
-    utilityfunctions.cpp \
-    searchhistory.cpp \
-    gotodialog.cpp \
-    tabbededitor.cpp \
-    language.cpp
-
-HEADERS += \
-    highlighters/highlighter.h \
-    highlighters/chighlighter.h \
-    highlighters/cpphighlighter.h \
-    highlighters/javahighlighter.h \
-    highlighters/pythonhighlighter.h \
-    mainwindow.h \
-    documentmetrics.h \
-    finddialog.h \
-    editor.h \
-    linenumberarea.h \
-    metricreporter.h \
-    settings.h \
-    utilityfunctions.h \
-    searchhistory.h \
-    gotodialog.h \
-    tabbededitor.h \
-    language.h
+include(Scribe.pri)
 
-FORMS += \
-        mainwindow.ui
+SOURCES += \
+    main.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
-RESOURCES += \
-    resources.qrc
-
 DISTFILES +=
 
 RC_FILE = texteditor.rc
@@ -0,0 +1,30 @@
+#include "blockdata.h"
+#include "metricstracker.h"
+
+
+/* Called by Qt when the owning block is removed from the document.
+ * Gives back this block's words so the running total stays correct.
+ */
+BlockData::~BlockData()
+{
+    if (metricsTracker && wordCount != UNCOUNTED)
+    {
+        metricsTracker->forget(wordCount);
+    }
+}
+
+
+/* Returns the BlockData of the given block, attaching a new one first if needed.
+ */
+BlockData *BlockData::of(QTextBlock block)
+{
+    BlockData *data = static_cast<BlockData*>(block.userData());
+
+    if (!data)
+    {
+        data = new BlockData();
+        block.setUserData(data);
+    }
+
+    return data;
+}
@@ -0,0 +1,44 @@
+#ifndef BLOCKDATA_H
+#define BLOCKDATA_H
+#include "highlighters/styledrange.h"
+#include <QTextBlockUserData>
+#include <QTextBlock>
+#include <QPointer>
+#include <QVector>
+
+class MetricsTracker;
+
+
+/* Bookkeeping attached to every QTextBlock (line) of an Editor's document.
+ * A block can only hold one QTextBlockUserData, so anything that needs to
+ * cache per-line state shares this class. Qt deletes a block's user data
+ * together with the block, which lets us notice lines that were removed.
+ */
+class BlockData : public QTextBlockUserData
+{
+public:
+    ~BlockData() override;
+    static BlockData *of(QTextBlock block);
+
+    const static int UNCOUNTED = -1;
+
+    // Used by MetricsTracker; UNCOUNTED until the tracker has seen this block
+    int wordCount = UNCOUNTED;
+    QPointer<MetricsTracker> metricsTracker;
+
+    // Used by ByteOffsetIndex; the length of this line's text once encoded, or UNCOUNTED
+    qint64 byteLength = UNCOUNTED;
+
+    // Set by Highlighter; the state this line started in when it was last highlighted, or UNCOUNTED
+    int highlightedState = UNCOUNTED;
+
+    // Set by Highlighter; this line's highlighting, which only becomes formats while the line is on screen
+    QVector<StyledRange> styledRanges;
+
+    // Set by Highlighter and used by BracketMatcher; brackets in strings and comments are left out
+    QVector<int> bracketPositions;
+    int bracketBalance = 0;
+    int lowestBracketDepth = 0;
+};
+
+#endif // BLOCKDATA_H
@@ -0,0 +1,201 @@
+#include "bracketmatcher.h"
+#include "blockdata.h"
+
+
+/* Records the given brackets (positions on the line that aren't in a string or a comment)
+ * as the summary of the given block. Called by the Highlighter every time it highlights a line.
+ */
+void BracketMatcher::summarize(QTextBlock block, const QString &text, const QVector<int> &bracketPositions)
+{
+    BlockData *data = BlockData::of(block);
+    int depth = 0;
+    int lowestDepth = 0;
+
+    for (int position : bracketPositions)
+    {
+        depth += isOpening(text.at(position)) ? 1 : -1;
+        lowestDepth = qMin(lowestDepth, depth);
+    }
+
+    data->bracketPositions = bracketPositions;
+    data->bracketBalance = depth;
+    data->lowestBracketDepth = lowestDepth;
+}
+
+
+/* Returns the document position of the bracket matching the one at the given position in the
+ * given block, NOT_FOUND if it has none, or MISMATCHED if the bracket it pairs up with is of
+ * a different kind. Also returns NOT_FOUND if there's no bracket at the given position, or if
+ * it's inside a string or a comment.
+ */
+int BracketMatcher::findMatch(QTextBlock block, int positionInBlock)
+{
+    return findMatch(block, positionInBlock, false);
+}
+
+
+/* Returns the match of the bracket at the given position, like findMatch above. Lines that
+ * haven't been summarized are skipped, unless scanRawText is set, in which case their text is
+ * scanned for brackets; UNKNOWN is returned if more than RAW_SCAN_LIMIT of them would need it.
+ */
+int BracketMatcher::findMatch(QTextBlock block, int positionInBlock, bool scanRawText)
+{
+    if (!isRealBracket(block, positionInBlock))
+    {
+        return NOT_FOUND;
+    }
+
+    QString text = block.text();
+    QChar bracket = text.at(positionInBlock);
+    bool searchForward = isOpening(bracket);
+    int step = searchForward ? 1 : -1;
+
+    // Depth relative to the bracket we're matching; the match is where it would drop below zero
+    int depth = 0;
+    int numRawScans = 0;
+    QVector<int> positions = static_cast<BlockData*>(block.userData())->bracketPositions;
+    int index = positions.indexOf(positionInBlock) + step;
+
+    while (true)
+    {
+        for (; index >= 0 && index < positions.size(); index += step)
+        {
+            QChar candidate = text.at(positions.at(index));
+
+            if (isOpening(candidate) != searchForward)
+            {
+                if (depth == 0)
+                {
+                    return candidate == counterpartOf(bracket) ? block.position() + positions.at(index) : MISMATCHED;
+                }
+
+                depth--;
+            }
+            else
+            {
+                depth++;
+            }
+        }
+
+        // Skip over every line that never dips below where it started by more than our depth
+        do
+        {
+            block = searchForward ? block.next() : block.previous();
+
+            if (!block.isValid())
+            {
+                return NOT_FOUND;
+            }
+
+            if (!isSummarized(block))
+            {
+                if (!scanRawText)
+                {
+                    continue;
+                }
+
+                if (++numRawScans > RAW_SCAN_LIMIT)
+                {
+                    return UNKNOWN;
+                }
+
+                // Without a summary to skip the line by, every bracket on it has to be looked at
+                text = block.text();
+                positions = rawBracketsIn(text);
+                break;
+            }
+
+            const BlockData *data = static_cast<BlockData*>(block.userData());
+            if (data->bracketPositions.isEmpty())
+            {
+                continue;
+            }
+
+            // Read backwards, a line dips to its lowest prefix depth minus its overall balance
+            int lowestDepth = searchForward ? data->lowestBracketDepth : data->lowestBracketDepth - data->bracketBalance;
+            if (depth + lowestDepth < 0)
+            {
+                text = block.text();
+                positions = data->bracketPositions;
+                break;
+            }
+
+            depth += searchForward ? data->bracketBalance : -data->bracketBalance;
+        }
+        while (true);
+
+        index = searchForward ? 0 : positions.size() - 1;
+    }
+}
+
+
+/* Returns true if the bracket at the given position opens a code block that is never closed.
+ * If that can't be told without scanning too much text, it's assumed to be closed.
+ */
+bool BracketMatcher::isUnclosed(QTextBlock block, int positionInBlock)
+{
+    return isRealBracket(block, positionInBlock) && findMatch(block, positionInBlock, true) == NOT_FOUND;
+}
+
+
+/* Returns true if the given character is a bracket, brace, or parenthesis.
+ */
+bool BracketMatcher::isBracket(QChar character)
+{
+    return character == '(' || character == ')' || character == '[' ||
+           character == ']' || character == '{' || character == '}';
+}
+
+
+/* Returns the bracket that pairs up with the given one, e.g. ')' for '('.
+ */
+QChar BracketMatcher::counterpartOf(QChar bracket)
+{
+    switch (bracket.unicode())
+    {
+        case '(': return ')';
+        case ')': return '(';
+        case '[': return ']';
+        case ']': return '[';
+        case '{': return '}';
+        case '}': return '{';
+        default: return QChar();
+    }
+}
+
+
+/* Returns true if the Highlighter has summarized the given block's brackets as its text is now.
+ * Edited blocks keep their old summary until they're highlighted again, so that's checked for too.
+ */
+bool BracketMatcher::isSummarized(QTextBlock block)
+{
+    const BlockData *data = static_cast<BlockData*>(block.userData());
+    return data && data->highlightedState != BlockData::UNCOUNTED;
+}
+
+
+/* Returns the positions of every bracket in the given text, including any in strings or comments.
+ */
+QVector<int> BracketMatcher::rawBracketsIn(const QString &text)
+{
+    QVector<int> positions;
+
+    for (int i = 0; i < text.length(); i++)
+    {
+        if (isBracket(text.at(i)))
+        {
+            positions.append(i);
+        }
+    }
+
+    return positions;
+}
+
+
+/* Returns true if there's a bracket at the given position that isn't in a string or a comment.
+ */
+bool BracketMatcher::isRealBracket(QTextBlock block, int positionInBlock)
+{
+    const BlockData *data = static_cast<BlockData*>(block.userData());
+    return data && data->bracketPositions.contains(positionInBlock);
+}
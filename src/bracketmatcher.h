@@ -0,0 +1,44 @@
+#ifndef BRACKETMATCHER_H
+#define BRACKETMATCHER_H
+#include <QTextBlock>
+#include <QString>
+
+
+/* Finds matching brackets using the per-line bracket summaries that the Highlighter keeps
+ * in each block's BlockData: where a line's brackets are, how many more it opens than it
+ * closes, and how deep below its starting depth it dips. A line whose summary shows it
+ * can't hold the match is skipped without looking at its text, so a search costs little
+ * more than one step per line even across tens of thousands of lines.
+ *
+ * All three kinds of brackets share a single depth; finding a bracket of the wrong kind
+ * where the match should be means the brackets are mismatched.
+ *
+ * Lines the Highlighter hasn't summarized (lines that lazy highlighting hasn't reached, or that
+ * were edited and are waiting on the worker) are skipped when matching, which only costs a match
+ * highlight. Deciding whether to close a code block can't afford that, so isUnclosed scans their
+ * text for brackets instead, as far as RAW_SCAN_LIMIT of them.
+ */
+class BracketMatcher
+{
+public:
+    static void summarize(QTextBlock block, const QString &text, const QVector<int> &bracketPositions);
+    static int findMatch(QTextBlock block, int positionInBlock);
+    static bool isUnclosed(QTextBlock block, int positionInBlock);
+
+    static bool isBracket(QChar character);
+    static bool isOpening(QChar character) { return character == '(' || character == '[' || character == '{'; }
+    static QChar counterpartOf(QChar bracket);
+
+    const static int NOT_FOUND = -1;
+    const static int MISMATCHED = -2;
+    const static int UNKNOWN = -3;
+    const static int RAW_SCAN_LIMIT = 20000;
+
+private:
+    static int findMatch(QTextBlock block, int positionInBlock, bool scanRawText);
+    static bool isSummarized(QTextBlock block);
+    static QVector<int> rawBracketsIn(const QString &text);
+    static bool isRealBracket(QTextBlock block, int positionInBlock);
+};
+
+#endif // BRACKETMATCHER_H
@@ -0,0 +1,176 @@
+#include "byteoffsetindex.h"
+#include "blockdata.h"
+#include <algorithm>
+
+
+/* Initializes this ByteOffsetIndex. The index is parented to the document so it lives exactly as long as it.
+ */
+ByteOffsetIndex::ByteOffsetIndex(QTextDocument *document, TextEncoding encoding) : QObject(document)
+{
+    this->document = document;
+    setEncoding(encoding);
+
+    connect(document, SIGNAL(contentsChange(int, int, int)), this, SLOT(on_contentsChange(int, int, int)));
+}
+
+
+/* Changes the encoding that byte offsets refer to, including the line ending the file was
+ * read with (and will be saved with). Every cached length is thrown away.
+ */
+void ByteOffsetIndex::setEncoding(TextEncoding encoding)
+{
+    encodedLength.reset(new EncodedLength(encoding));
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+        if (data)
+        {
+            data->byteLength = BlockData::UNCOUNTED;
+        }
+    }
+
+    checkpoints = {encodedLength->ofHeader()};
+}
+
+
+/* Takes over the checkpoints a FileLoader recorded while reading this index's document (see
+ * FileLoader::blockCheckpoints), if they go further than the ones recorded so far. They must
+ * have been counted in the encoding last set.
+ */
+void ByteOffsetIndex::adoptCheckpoints(const QVector<qint64> &loadedCheckpoints)
+{
+    bool blocksExist = (loadedCheckpoints.size() - 1) * STRIDE < document->blockCount();
+
+    if (blocksExist && loadedCheckpoints.size() > checkpoints.size())
+    {
+        checkpoints = loadedCheckpoints;
+    }
+}
+
+
+/* Called whenever text is inserted into or removed from the document. Blocks before the
+ * edit start at the same offsets as before; everything from the edited block on is stale.
+ */
+void ByteOffsetIndex::on_contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    QTextBlock block = document->findBlock(position);
+    int endOfEdit = position + charsAdded;
+
+    checkpoints.resize(qMin(checkpoints.size(), block.blockNumber() / STRIDE + 1));
+
+    while (block.isValid() && block.position() <= endOfEdit)
+    {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+        if (data)
+        {
+            data->byteLength = BlockData::UNCOUNTED;
+        }
+
+        block = block.next();
+    }
+}
+
+
+/* Returns the document position at the given byte offset, or -1 if the offset is past the end.
+ * An offset that lands inside a multi-byte character maps to the start of that character,
+ * and one inside a byte order mark maps to the start of the document.
+ */
+int ByteOffsetIndex::positionOf(qint64 byteOffset)
+{
+    if (byteOffset < 0)
+    {
+        return -1;
+    }
+
+    byteOffset = qMax(byteOffset, qint64(encodedLength->ofHeader()));
+
+    // Checkpoints are only recorded as far as a lookup has needed them so far
+    while (checkpoints.last() <= byteOffset && addCheckpoint())
+    {
+    }
+
+    int checkpoint = static_cast<int>(std::upper_bound(checkpoints.begin(), checkpoints.end(), byteOffset) - checkpoints.begin()) - 1;
+    QTextBlock block = document->findBlockByNumber(checkpoint * STRIDE);
+    qint64 blockStart = checkpoints[checkpoint];
+
+    while (block.next().isValid() && byteOffset >= blockStart + lengthOf(block) + encodedLength->ofNewline())
+    {
+        blockStart += lengthOf(block) + encodedLength->ofNewline();
+        block = block.next();
+    }
+
+    qint64 bytesIntoBlock = byteOffset - blockStart;
+    if (!block.next().isValid() && bytesIntoBlock > lengthOf(block))
+    {
+        return -1;
+    }
+
+    // Walk the line until the next character would overshoot; the newline itself counts as the end of the line
+    QString text = block.text();
+    int index = 0;
+
+    while (index < text.length())
+    {
+        int next = index;
+        int length = encodedLength->ofCharAt(text, next);
+
+        if (length > bytesIntoBlock)
+        {
+            break;
+        }
+
+        bytesIntoBlock -= length;
+        index = next;
+    }
+
+    return block.position() + index;
+}
+
+
+/* Records the checkpoint after the last one. Returns false if there are no more blocks to record.
+ */
+bool ByteOffsetIndex::addCheckpoint()
+{
+    QTextBlock block = document->findBlockByNumber((checkpoints.size() - 1) * STRIDE);
+    qint64 offset = checkpoints.last();
+
+    for (int i = 0; i < STRIDE; i++)
+    {
+        if (!block.next().isValid())
+        {
+            return false;
+        }
+
+        offset += lengthOf(block) + encodedLength->ofNewline();
+        block = block.next();
+    }
+
+    checkpoints.append(offset);
+    return true;
+}
+
+
+/* Returns the encoded length of the given block's text, not counting its newline.
+ */
+qint64 ByteOffsetIndex::lengthOf(QTextBlock block)
+{
+    BlockData *data = BlockData::of(block);
+
+    if (data->byteLength == BlockData::UNCOUNTED)
+    {
+        QString text = block.text();
+        qint64 length = 0;
+
+        for (int index = 0; index < text.length(); )
+        {
+            length += encodedLength->ofCharAt(text, index);
+        }
+
+        data->byteLength = length;
+    }
+
+    return data->byteLength;
+}
@@ -0,0 +1,48 @@
+#ifndef BYTEOFFSETINDEX_H
+#define BYTEOFFSETINDEX_H
+#include "textencoding.h"
+#include "encodedlength.h"
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QScopedPointer>
+#include <QVector>
+
+
+/* Maps byte offsets in a document's file (as it would be saved) to positions in the document.
+ * Each block caches its own encoded length (see BlockData), and the starting offset of every
+ * STRIDE-th block is recorded as a checkpoint the first time a lookup gets that far, so a
+ * lookup only ever encodes and walks a handful of blocks once the index is warm. An edit
+ * discards just the checkpoints after it and the cached lengths of the blocks it touched.
+ *
+ * A file that was just opened comes with its checkpoints already recorded by the FileLoader
+ * that read it (see adoptCheckpoints), so even the first lookup stays near its target.
+ */
+class ByteOffsetIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    ByteOffsetIndex(QTextDocument *document, TextEncoding encoding);
+
+    void setEncoding(TextEncoding encoding);
+    void adoptCheckpoints(const QVector<qint64> &loadedCheckpoints);
+    int positionOf(qint64 byteOffset);
+
+    const static int STRIDE = 64;
+
+private slots:
+    void on_contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    qint64 lengthOf(QTextBlock block);
+    bool addCheckpoint();
+
+    QTextDocument *document;
+    QScopedPointer<EncodedLength> encodedLength;
+
+    // checkpoints[i] is the byte offset at which block i * STRIDE starts
+    QVector<qint64> checkpoints;
+};
+
+#endif // BYTEOFFSETINDEX_H
@@ -1,33 +1,40 @@
 #include "editor.h"
 #include "linenumberarea.h"
+#include "bracketmatcher.h"
 #include "utilityfunctions.h"
-#include "highlighters/chighlighter.h"
-#include "highlighters/cpphighlighter.h"
-#include "highlighters/javahighlighter.h"
-#include "highlighters/pythonhighlighter.h"
+#include "highlighters/grammarregistry.h"
 #include <QPainter>
 #include <QTextBlock>
 #include <QFontDialog>
-#include <QTextDocumentFragment>
 #include <QPalette>
 #include <QStack>
 #include <QFileInfo>
+#include <QScrollBar>
+#include <QScopedPointer>
 #include <QtDebug>
+#include <algorithm>
 
 
 const QColor Editor::LINE_COLOR = QColor(Qt::lightGray).lighter(125);
+const QColor Editor::BRACKET_MATCH_COLOR = QColor(Qt::cyan).lighter(160);
+const QColor Editor::BRACKET_MISMATCH_COLOR = QColor(Qt::red).lighter(160);
+const QColor Editor::FIND_ALL_COLOR = QColor(Qt::yellow).lighter(140);
 
 
 /* Initializes this Editor.
  */
 Editor::Editor(QWidget *parent) : QPlainTextEdit (parent)
 {
+    qRegisterMetaType<RegexMatchBatch>("RegexMatchBatch");
+
     readSettings();
     document()->setModified(false);
 
-    setProgrammingLanguage(Language::None);
+    setProgrammingLanguage(NO_LANGUAGE);
     metrics = DocumentMetrics();
-    lineNumberArea = new LineNumberArea(this);
+    metricsTracker = new MetricsTracker(document());
+    byteOffsetIndex = new ByteOffsetIndex(document(), encoding);
+    lineNumberArea = new LineNumberArea<Editor>(this);
     setFont(QFont("Courier", DEFAULT_FONT_SIZE), QFont::Monospace, true, NUM_CHARS_FOR_TAB);
 
     connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth()));
@@ -36,6 +43,7 @@ Editor::Editor(QWidget *parent) : QPlainTextEdit (parent)
     connect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
     connect(this, SIGNAL(undoAvailable(bool)), this, SLOT(setUndoAvailable(bool)));
     connect(this, SIGNAL(redoAvailable(bool)), this, SLOT(setRedoAvailable(bool)));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateVisibleBlocks()));
 
     installEventFilter(this);
     updateLineNumberAreaWidth();
@@ -47,6 +55,26 @@ Editor::Editor(QWidget *parent) : QPlainTextEdit (parent)
  */
 Editor::~Editor()
 {
+    // Don't leave the loader thread running (or blocked) once its document is gone
+    if (loader)
+    {
+        loader->requestInterruption();
+        loader->wait();
+    }
+
+    // Searches that were canceled but haven't exited yet are still children of this Editor
+    for (RegexSearchWorker *child : findChildren<RegexSearchWorker*>())
+    {
+        child->requestInterruption();
+        child->wait();
+    }
+
+    // But do let a save finish, or the user's changes would be lost
+    if (saver)
+    {
+        saver->wait();
+    }
+
     delete lineNumberArea;
 }
 
@@ -56,11 +84,178 @@ Editor::~Editor()
 void Editor::reset()
 {
     currentFilePath.clear();
+    encoding = TextEncoding::localeDefault();
+    byteOffsetIndex->setEncoding(encoding);
+    indenter.setIndentUnit("\t");
     document()->setModified(false);
     setPlainText(QString());
 }
 
 
+/* Loads the file at the given path into this Editor in the background (see FileLoader).
+ * The editor is read-only until loading completes, but the part of the file that has
+ * already arrived can be viewed and scrolled in the meantime.
+ */
+void Editor::load(QString filePath)
+{
+    setCurrentFilePath(filePath);
+
+    // Loading isn't something the user should be able to undo
+    document()->setUndoRedoEnabled(false);
+    setPlainText(QString());
+    setReadOnly(true);
+    loadCanceled = false;
+
+    loader = new FileLoader(filePath, this);
+    loadProgress = new LoadProgress(this);
+    positionLoadProgress();
+    loadProgress->show();
+
+    connect(loader, SIGNAL(chunkLoaded(QString)), this, SLOT(on_chunkLoaded(QString)));
+    connect(loader, SIGNAL(loadFailed(QString)), this, SLOT(on_loadFailed(QString)));
+    connect(loader, SIGNAL(finished()), this, SLOT(on_loadFinished()));
+    connect(loader, SIGNAL(progressChanged(int)), loadProgress, SLOT(setProgress(int)));
+    connect(loadProgress, SIGNAL(canceled()), this, SLOT(cancelLoading()));
+
+    loader->start();
+}
+
+
+/* Called for every chunk of text the loader has read. Appends the chunk to the end of the document.
+ */
+void Editor::on_chunkLoaded(QString text)
+{
+    if (!loadCanceled)
+    {
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(text);
+        setModifiedState(false);
+    }
+
+    loader->chunkConsumed();
+}
+
+
+/* Called when the loader fails to read the file. The partially loaded document is discarded.
+ */
+void Editor::on_loadFailed(QString error)
+{
+    loadCanceled = true;
+    QMessageBox::warning(this, "Warning", "Cannot open file: " + error);
+}
+
+
+/* Stops loading the current file. The partially loaded document is discarded
+ * once the loader has stopped (see on_loadFinished).
+ */
+void Editor::cancelLoading()
+{
+    if (!loader)
+    {
+        return;
+    }
+
+    loadCanceled = true;
+    loadProgress->setEnabled(false);
+    loader->requestInterruption();
+}
+
+
+/* Called when the loader thread exits, whether or not it loaded the entire file.
+ */
+void Editor::on_loadFinished()
+{
+    encoding = loader->detectedEncoding();
+    byteOffsetIndex->setEncoding(encoding);
+    indenter.setIndentUnit(Indenter::detectIndentUnit(document()));
+    loader->deleteLater();
+    loader = nullptr;
+    loadProgress->deleteLater();
+    loadProgress = nullptr;
+
+    setReadOnly(false);
+    document()->setUndoRedoEnabled(true);
+
+    // A partial file must never be saved over the original, so leave an empty, untitled tab instead
+    if (loadCanceled)
+    {
+        reset();
+    }
+    else
+    {
+        byteOffsetIndex->adoptCheckpoints(loader->blockCheckpoints());
+    }
+
+    setModifiedState(false);
+    on_cursorPositionChanged();
+
+    if (!loadCanceled && lineAfterLoading > 0)
+    {
+        goTo(lineAfterLoading, columnAfterLoading);
+    }
+
+    lineAfterLoading = 0;
+    emit(fileContentsChanged());
+}
+
+
+/* Saves this Editor's contents to the given path in the background (see FileSaver),
+ * in the same encoding the file was opened with. The text of each line is snapshotted first,
+ * so the user can keep editing while the save runs.
+ * Emits saveFinished once the file has been written.
+ */
+void Editor::save(QString filePath)
+{
+    revisionAtSave = document()->revision();
+    saver = new FileSaver(FileSaver::snapshotOf(document()), filePath, encoding, this);
+    connect(saver, SIGNAL(finished()), this, SLOT(on_saveFinished()));
+    saver->start();
+}
+
+
+/* Called when the saver thread exits, whether or not the save succeeded.
+ */
+void Editor::on_saveFinished()
+{
+    bool succeeded = saver->succeeded();
+    QString error = saver->errorString();
+    saver->deleteLater();
+    saver = nullptr;
+
+    if (succeeded)
+    {
+        // Anything typed while the save was running still needs saving
+        if (document()->revision() == revisionAtSave)
+        {
+            setModifiedState(false);
+        }
+    }
+    else
+    {
+        QMessageBox::warning(this, "Warning", "Cannot save file: " + error);
+    }
+
+    emit(saveFinished(succeeded));
+    emit(fileContentsChanged());
+}
+
+
+/* Places the load progress indicator in the bottom-right corner of the viewport.
+ */
+void Editor::positionLoadProgress()
+{
+    if (!loadProgress)
+    {
+        return;
+    }
+
+    QRect area = viewport()->geometry();
+    QSize size = loadProgress->sizeHint();
+    loadProgress->setGeometry(area.right() - size.width(), area.bottom() - size.height(), size.width(), size.height());
+}
+
+
 /* Sets this Editor's current file path.
  * @newPath - the file path associated with the file this Editor represents
  */
@@ -116,26 +311,23 @@ void Editor::setProgrammingLanguage(Language language)
     }
 
     this->programmingLanguage = language;
+
+    // Removes the old language's highlighting from the document
+    delete syntaxHighlighter;
     this->syntaxHighlighter = generateHighlighterFor(language);
+    updateVisibleBlocks();
 }
 
 
-/* Returns a Highlighter corresponding to the given language.
+/* Returns a Highlighter corresponding to the given language, or nullptr if
+ * the language isn't one that can be highlighted.
  * @param language - the programming language for which a
  * syntax highlighter should be generated
  */
 Highlighter *Editor::generateHighlighterFor(Language language)
 {
-    QTextDocument *doc = document();
-
-    switch (language)
-    {
-        case (Language::C): return new CHighlighter(doc);
-        case (Language::CPP): return new CPPHighlighter(doc);
-        case (Language::Java): return new JavaHighlighter(doc);
-        case (Language::Python): return new PythonHighlighter(doc);
-        default: return nullptr;
-    }
+    QSharedPointer<const Grammar> grammar = GrammarRegistry::instance().grammarFor(language);
+    return grammar ? new Highlighter(grammar, document()) : nullptr;
 }
 
 
@@ -158,6 +350,45 @@ QTextDocument::FindFlags Editor::getSearchOptionsFromFlags(bool caseSensitive, b
 }
 
 
+/* Selects the next match of the query after the cursor, if there is one. Regular expressions are
+ * matched with the given searcher (see RegexSearcher), and plain queries when it's null. This runs
+ * on the GUI thread, so a regular expression is only searched for until the given deadline, one
+ * line at a time, and not found if it isn't found by then.
+ */
+bool Editor::findNextMatch(const QString &query, QTextDocument::FindFlags searchOptions, const RegexSearcher *searcher, QDeadlineTimer deadline)
+{
+    if (!searcher)
+    {
+        return QPlainTextEdit::find(query, searchOptions);
+    }
+
+    int position = textCursor().selectionEnd();
+    QTextBlock block = document()->findBlock(position);
+    int from = position - block.position();
+
+    for (; block.isValid(); block = block.next(), from = 0)
+    {
+        QRegularExpressionMatch match;
+
+        if (searcher->findFirstInLine(block.text(), from, match, deadline) == RegexSearcher::OutOfTime)
+        {
+            return false;
+        }
+
+        if (match.hasMatch())
+        {
+            QTextCursor cursor(document());
+            cursor.setPosition(block.position() + match.capturedStart());
+            cursor.setPosition(block.position() + match.capturedEnd(), QTextCursor::KeepAnchor);
+            setTextCursor(cursor);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
 /* Called when the findDialog object emits its queryReady signal. Initiates the
  * actual searching within the editor. First searches for a match from the current
  * position to the end of the document. If nothing is found, the search proceeds
@@ -166,23 +397,40 @@ QTextDocument::FindFlags Editor::getSearchOptionsFromFlags(bool caseSensitive, b
  * @param query - the text the user wants to search for
  * @param caseSensitive - flag denoting whether the search should heed the case of results
  * @param wholeWords - flag denoting whether the search should look for whole word matches or partials
+ * @param regex - flag denoting whether the query is a regular expression
  */
-bool Editor::find(QString query, bool caseSensitive, bool wholeWords)
+bool Editor::find(QString query, bool caseSensitive, bool wholeWords, bool regex)
 {
     // Keep track of the cursor position prior to this search so we can return to it if no match is found
     int cursorPositionBeforeCurrentSearch = textCursor().position();
 
     // Specify the options we'll be searching with
     QTextDocument::FindFlags searchOptions = getSearchOptionsFromFlags(caseSensitive, wholeWords);
+    QScopedPointer<RegexSearcher> searcher(regex ? new RegexSearcher(query, caseSensitive, wholeWords) : nullptr);
+
+    if (searcher && !searcher->isValid())
+    {
+        emit(findResultReady("Invalid regular expression: " + searcher->getErrorString()));
+        return false;
+    }
 
     // Search from the current position until the end of the document
-    bool matchFound = QPlainTextEdit::find(query, searchOptions);
+    QDeadlineTimer deadline(FIND_NEXT_TIMEOUT);
+    bool matchFound = findNextMatch(query, searchOptions, searcher.data(), deadline);
 
     // If we didn't find a match, search from the top of the document
-    if (!matchFound)
+    if (!matchFound && !deadline.hasExpired())
     {
         moveCursor(QTextCursor::Start);
-        matchFound = QPlainTextEdit::find(query, searchOptions);
+        matchFound = findNextMatch(query, searchOptions, searcher.data(), deadline);
+    }
+
+    // A regular expression that takes too long is given up on rather than freezing the editor
+    if (!matchFound && searcher && deadline.hasExpired())
+    {
+        moveCursorTo(cursorPositionBeforeCurrentSearch);
+        emit(findResultReady("The search took too long and was stopped. Try Find All, which searches in the background."));
+        return false;
     }
 
     // If we found a match...
@@ -232,68 +480,314 @@ bool Editor::find(QString query, bool caseSensitive, bool wholeWords)
 }
 
 
+/* Called when the user clicks the Find All button in FindDialog. Searches a snapshot of the whole
+ * document at once (see TextSearcher), highlights every match that's on screen, and reports how
+ * many there are. The matches stay highlighted until the document is edited. Regular expressions
+ * are searched for on a worker thread instead (see startRegexSearch).
+ * @param query - the text the user wants to search for
+ * @param caseSensitive - flag denoting whether the search should heed the case of results
+ * @param wholeWords - flag denoting whether the search should look for whole word matches or partials
+ * @param regex - flag denoting whether the query is a regular expression
+ */
+void Editor::findAll(QString query, bool caseSensitive, bool wholeWords, bool regex)
+{
+    if (regex)
+    {
+        startRegexSearch(query, QString(), caseSensitive, wholeWords, false);
+        return;
+    }
+
+    cancelSearch();
+
+    TextSearcher searcher(query, caseSensitive, wholeWords);
+    findAllMatches = searcher.findAll(document()->toPlainText());
+    findAllMatchLengths = QVector<int>(findAllMatches.size(), searcher.getQueryLength());
+    highlightCurrentLine();
+
+    if (findAllMatches.isEmpty())
+    {
+        emit(findResultReady("No results found."));
+        return;
+    }
+
+    selectFindAllMatchAfterCursor();
+    emit(findResultReady(QString::number(findAllMatches.size()) + (findAllMatches.size() == 1 ? " match." : " matches.")));
+}
+
+
+/* Selects the first Find All match after the cursor, as Find Next would, wrapping around to the
+ * first one in the document if there are none.
+ */
+void Editor::selectFindAllMatchAfterCursor()
+{
+    auto next = std::lower_bound(findAllMatches.begin(), findAllMatches.end(), textCursor().position());
+    int match = next == findAllMatches.end() ? 0 : static_cast<int>(next - findAllMatches.begin());
+
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(findAllMatches[match]);
+    cursor.setPosition(findAllMatches[match] + findAllMatchLengths[match], QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+}
+
+
+/* Starts searching a snapshot of the document for the given regular expression on a worker thread
+ * (see RegexSearchWorker), canceling any search that's still running. Matches are highlighted as
+ * they come in, and the search is reported on (or its matches replaced) once it's done; see
+ * on_regexSearchDone.
+ */
+void Editor::startRegexSearch(const QString &pattern, const QString &with, bool caseSensitive, bool wholeWords, bool replacing)
+{
+    cancelSearch();
+
+    RegexSearcher searcher(pattern, caseSensitive, wholeWords);
+
+    if (!searcher.isValid())
+    {
+        emit(findResultReady("Invalid regular expression: " + searcher.getErrorString()));
+        return;
+    }
+
+    searcher.setReplacement(with);
+
+    findAllMatches.clear();
+    findAllMatchLengths.clear();
+    searchReplacements.clear();
+    highlightCurrentLine();
+
+    searchIsReplacing = replacing;
+    revisionAtSearch = document()->revision();
+    searchTimer.start();
+
+    regexWorker = new RegexSearchWorker(searcher, document()->toPlainText(), replacing, ++searchGeneration, this);
+    connect(regexWorker, SIGNAL(batchReady(RegexMatchBatch)), this, SLOT(on_regexBatchReady(RegexMatchBatch)));
+    connect(regexWorker, SIGNAL(done(int, int, int)), this, SLOT(on_regexSearchDone(int, int, int)));
+    connect(regexWorker, SIGNAL(finished()), regexWorker, SLOT(deleteLater()));
+    regexWorker->start(QThread::LowPriority);
+
+    emit(searchProgress("Searching..."));
+}
+
+
+/* Stops the regular expression search (if any) that's running. Called when the user changes the
+ * query, starts another search, or edits the document. The worker deletes itself once it has exited.
+ */
+void Editor::cancelSearch()
+{
+    if (!regexWorker)
+    {
+        return;
+    }
+
+    regexWorker->requestInterruption();
+    regexWorker = nullptr;
+
+    // Anything the worker still has queued up is stale
+    searchGeneration++;
+    emit(searchProgress("Search canceled."));
+}
+
+
+/* Called when the regular expression search has found another batch of matches. Highlights them
+ * (if they're on screen) and reports how far along the search is.
+ */
+void Editor::on_regexBatchReady(RegexMatchBatch batch)
+{
+    if (batch.generation != searchGeneration)
+    {
+        return;
+    }
+
+    findAllMatches += batch.starts;
+    findAllMatchLengths += batch.lengths;
+    searchReplacements += batch.replacements;
+
+    if (!batch.starts.isEmpty())
+    {
+        highlightCurrentLine();
+    }
+
+    emit(searchProgress(QString("Searching... %1 matches so far (%2%)").arg(findAllMatches.size()).arg(batch.percentDone)));
+}
+
+
+/* Called when the regular expression search has handed over all of its matches. Replaces them if
+ * the search was for Replace All, or selects the first one after the cursor if it was for Find All,
+ * and reports how it went, including whether it timed out or skipped any lines.
+ */
+void Editor::on_regexSearchDone(int generation, int outcome, int numSkippedLines)
+{
+    if (generation != searchGeneration)
+    {
+        return;
+    }
+
+    regexWorker = nullptr;
+    emit(searchProgress(QString()));
+
+    QString message;
+    bool timedOut = outcome == RegexSearchWorker::TimedOut;
+    int numMatches = findAllMatches.size();
+
+    if (searchIsReplacing && timedOut)
+    {
+        message = QString("The search was stopped after %1 seconds; nothing was replaced.").arg(RegexSearchWorker::TIMEOUT / 1000);
+    }
+    else if (numMatches == 0)
+    {
+        message = "No results found.";
+    }
+    else if (searchIsReplacing)
+    {
+        // Copies, since replacing them clears the matches (see on_textChanged)
+        QVector<int> starts = findAllMatches;
+        QVector<int> lengths = findAllMatchLengths;
+        QVector<QString> replacements = searchReplacements;
+        searchReplacements.clear();
+
+        replaceMatches(starts, lengths, replacements);
+        message = QString("Document searched. Replaced %1 instances in %2 ms.").arg(numMatches).arg(searchTimer.elapsed());
+    }
+    else
+    {
+        selectFindAllMatchAfterCursor();
+        message = QString::number(numMatches) + (numMatches == 1 ? " match." : " matches.");
+    }
+
+    if (timedOut && !searchIsReplacing)
+    {
+        message += QString(" The search was stopped after %1 seconds, so these are only the matches found until then.").arg(RegexSearchWorker::TIMEOUT / 1000);
+    }
+
+    if (numSkippedLines > 0)
+    {
+        message += QString(" %1 lines were skipped because the expression took too many steps on them.").arg(numSkippedLines);
+    }
+
+    emit(findResultReady(message));
+}
+
+
 /* Called when the user clicks the Replace button in FindDialog.
  * @param what - the string to find and replace
  * @param with - the string with which to replace any match
  * @param caseSensitive - flag denoting whether the search should heed the case of results
  * @param wholeWords - flag denoting whether the search should look for whole word matches or partials
+ * @param regex - flag denoting whether what to find is a regular expression (with may then refer to its groups)
  */
-void Editor::replace(QString what, QString with, bool caseSensitive, bool wholeWords)
+void Editor::replace(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex)
 {
-    bool found = find(what, caseSensitive, wholeWords);
+    bool found = find(what, caseSensitive, wholeWords, regex);
 
     if (found)
     {
         QTextCursor cursor = textCursor();
+        QString replacement = with;
+
+        // Match the expression again where it was found, to see what its groups captured
+        if (regex)
+        {
+            RegexSearcher searcher(what, caseSensitive, wholeWords);
+            searcher.setReplacement(with);
+
+            QTextBlock block = document()->findBlock(cursor.selectionStart());
+            QRegularExpressionMatch match = searcher.getExpression().match(block.text(), cursor.selectionStart() - block.position(),
+                                                                           QRegularExpression::NormalMatch, QRegularExpression::AnchoredMatchOption);
+            replacement = searcher.replacementFor(match);
+        }
+
         cursor.beginEditBlock();
-        cursor.insertText(with);
+        cursor.insertText(replacement);
         cursor.endEditBlock();
     }
 }
 
 
-/* Called when the user clicks the Replace All button in FindDialog.
+/* Called when the user clicks the Replace All button in FindDialog. Finds every match at once and
+ * replaces them with one edit per line that has any, all of which are undone as one step. Regular
+ * expressions are searched for on a worker thread first (see startRegexSearch).
  * @param what - the string to find and replace
  * @param with - the string with which to replace all matches
  * @param caseSensitive - flag denoting whether the search should heed the case of results
  * @param wholeWords - flag denoting whether the search should look for whole word matches or partials
+ * @param regex - flag denoting whether what to find is a regular expression (with may then refer to its groups)
  */
-void Editor::replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords)
+void Editor::replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex)
 {
-    // Optimization, don't update screen until the end of all replacements
-    disconnect(this, SIGNAL(cursorPositionChanged()), this, SLOT(on_cursorPositionChanged()));
-    disconnect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
+    if (regex)
+    {
+        startRegexSearch(what, with, caseSensitive, wholeWords, true);
+        return;
+    }
 
-    // Search the entire document from the very beginning
-    moveCursorTo(0);
+    cancelSearch();
 
-    // Conduct an initial search; don't rely on our custom find
-    QTextDocument::FindFlags searchOptions = getSearchOptionsFromFlags(caseSensitive, wholeWords);
-    bool found = QPlainTextEdit::find(what, searchOptions);
-    int replacements = 0;
+    QElapsedTimer timer;
+    timer.start();
 
-    // Keep replacing while there are matches left
-    QTextCursor cursor(document());
-    cursor.beginEditBlock();
-    while (found)
-    {
-        QTextCursor currentPosition = textCursor();
-        currentPosition.insertText(with);
-        replacements++;
-        found = QPlainTextEdit::find(what, searchOptions);
-    }
-    cursor.endEditBlock();
+    // Find every match in one pass over a snapshot of the document (see TextSearcher)
+    TextSearcher searcher(what, caseSensitive, wholeWords);
+    QVector<int> matches = searcher.findAll(document()->toPlainText());
 
-    // End-of-operation feedback
-    if (replacements == 0)
+    if (matches.isEmpty())
     {
         emit(findResultReady("No results found."));
+        return;
     }
-    else
+
+    replaceMatches(matches, QVector<int>(matches.size(), searcher.getQueryLength()), QVector<QString>(matches.size(), with));
+
+    // End-of-operation feedback
+    emit(findResultReady(QString("Document searched. Replaced %1 instances in %2 ms.").arg(matches.size()).arg(timer.elapsed())));
+}
+
+
+/* Replaces the text at each of the given positions and lengths with the corresponding replacement.
+ * The matches must be in order, and none of them may span lines. Each line with any matches is
+ * rebuilt in one pass and changed with a single edit, from the start of its first match to the end
+ * of its last, and all of the edits are undone (and reported to the document's listeners) as one.
+ */
+void Editor::replaceMatches(const QVector<int> &starts, const QVector<int> &lengths, const QVector<QString> &replacements)
+{
+    // Optimization, don't update screen until the end of all replacements
+    disconnect(this, SIGNAL(cursorPositionChanged()), this, SLOT(on_cursorPositionChanged()));
+    disconnect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
+
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+
+    // Working back from the end keeps the positions of the matches before each edit valid
+    for (int last = starts.size() - 1; last >= 0; )
     {
-        emit(findResultReady("Document searched. Replaced " + QString::number(replacements) + " instances."));
+        QTextBlock block = document()->findBlock(starts[last]);
+        QString text = block.text();
+        int first = last;
+
+        while (first > 0 && starts[first - 1] >= block.position())
+        {
+            first--;
+        }
+
+        QString replacement;
+        for (int i = first; i <= last; i++)
+        {
+            replacement += replacements[i];
+
+            if (i < last)
+            {
+                int end = starts[i] + lengths[i];
+                replacement += text.midRef(end - block.position(), starts[i + 1] - end);
+            }
+        }
+
+        cursor.setPosition(starts[first]);
+        cursor.setPosition(starts[last] + lengths[last], QTextCursor::KeepAnchor);
+        cursor.insertText(replacement);
+
+        last = first - 1;
     }
 
+    cursor.endEditBlock();
+
     // Reset here and calculate the metrics in one go
     connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(on_cursorPositionChanged()));
     connect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
@@ -302,9 +796,11 @@ void Editor::replaceAll(QString what, QString with, bool caseSensitive, bool who
 }
 
 
-/* Called when the user clicks the Go button in the GotoDialog.
+/* Called when the user asks the GotoDialog for a line (and optionally a column) number.
+ * Blocks are numbered in the document's own index, so this takes the same time on any line
+ * of any file, and unlike QTextDocument::findBlockByLineNumber it isn't thrown off by wrapping.
  */
-void Editor::goTo(int line)
+void Editor::goTo(int line, int column)
 {
     if (line > blockCount() || line < 1)
     {
@@ -312,8 +808,62 @@ void Editor::goTo(int line)
         return;
     }
 
-    int beginningOfLine = document()->findBlockByLineNumber(line - 1).position();
-    moveCursorTo(beginningOfLine);
+    QTextBlock block = document()->findBlockByNumber(line - 1);
+
+    if (column > block.length() || column < 1)
+    {
+        emit(gotoResultReady("Invalid column number."));
+        return;
+    }
+
+    moveCursorTo(block.position() + column - 1);
+}
+
+
+/* Goes to the given line and column once the file that's being loaded is in, or right away
+ * if nothing is being loaded. Nowhere is gone to if the load fails or is canceled.
+ */
+void Editor::goToAfterLoading(int line, int column)
+{
+    if (!isLoading())
+    {
+        goTo(line, column);
+        return;
+    }
+
+    lineAfterLoading = line;
+    columnAfterLoading = column;
+}
+
+
+/* Called when the user asks the GotoDialog for a byte offset into the file (see ByteOffsetIndex).
+ */
+void Editor::goToOffset(qint64 byteOffset)
+{
+    int position = byteOffsetIndex->positionOf(byteOffset);
+
+    if (position == -1)
+    {
+        emit(gotoResultReady("Invalid offset."));
+        return;
+    }
+
+    moveCursorTo(position);
+}
+
+
+/* Called when the user asks the GotoDialog to go some percentage of the way through the file.
+ * Goes to the start of the line that many percent of the way down.
+ */
+void Editor::goToPercent(int percent)
+{
+    if (percent > 100 || percent < 0)
+    {
+        emit(gotoResultReady("Invalid percentage."));
+        return;
+    }
+
+    goTo(qMax(1, static_cast<int>(qint64(blockCount()) * percent / 100)));
 }
 
 
@@ -395,64 +945,38 @@ void Editor::toggleWrapMode(bool wrap)
 void Editor::on_textChanged()
 {
     searchHistory.clear();
-    updateCharCount();
-    updateWordCount();
-    emit(fileContentsChanged());
-}
-
 
-/* Manually parses the document to update the word count. Emits the word count.
- */
-void Editor::updateWordCount()
-{
-    metrics.wordCount = 0;
-    QString documentContents = toPlainText().toUtf8();
-    int documentLength = documentContents.length();
-    QString currentWord = "";
-
-    for (int i = 0; i < documentLength; i++)
+    // A search of the text as it was is of no more use
+    if (regexWorker && document()->revision() != revisionAtSearch)
     {
-        // Convert to unsigned char to avoid running into debug assertion problems
-        unsigned char character = qvariant_cast<unsigned char>(documentContents[i].toLatin1());
+        cancelSearch();
+    }
 
-        // Newline
-        if (character == '\n')
-        {
-            // Special case: newline following a word
-            if (!currentWord.isEmpty())
-            {
-                metrics.wordCount++;
-                currentWord.clear();
-            }
-        }
-        // All other valid characters
-        else
-        {
-            // Alphanumeric character
-            if (isalnum(character))
-            {
-                currentWord += qvariant_cast<char>(character);
-            }
-            // Whitespace (excluding newline, handled separately above)
-            else if (isspace(character))
-            {
-                // Whitespace following a word means we completed a word
-                if (!currentWord.isEmpty())
-                {
-                    metrics.wordCount++;
-                    currentWord.clear();
-                }
-            }
-        }
+    // The matches' positions no longer hold
+    if (!findAllMatches.isEmpty())
+    {
+        findAllMatches.clear();
+        findAllMatchLengths.clear();
+        highlightCurrentLine();
     }
 
-    // e.g., if we stopped typing and still had a word in progress, we need to count it
-    if (!currentWord.isEmpty())
+    updateCharCount();
+    updateWordCount();
+
+    // Text arriving from the loader doesn't count as a change to the file
+    if (!isLoading())
     {
-        metrics.wordCount++;
-        currentWord.clear();
+        emit(fileContentsChanged());
     }
+}
 
+
+/* Updates and emits the word count. The count itself is maintained
+ * incrementally by this Editor's MetricsTracker.
+ */
+void Editor::updateWordCount()
+{
+    metrics.wordCount = metricsTracker->wordCount();
     emit(wordCountChanged(metrics.wordCount));
 }
 
@@ -461,90 +985,62 @@ void Editor::updateWordCount()
  */
 void Editor::updateCharCount()
 {
-    metrics.charCount = toPlainText().length();
+    metrics.charCount = metricsTracker->charCount();
     emit(charCountChanged(metrics.charCount));
 }
 
 
-/* Returns the indentation level of the current line of text.
+/* Indents (or dedents) every line the selection touches by one level (see Indenter). The lines
+ * are edited in place, one at a time, as a single undo step, so this takes time proportional to
+ * the number of lines and leaves the formatting untouched. The selection still covers the same lines.
  */
-int Editor::indentationLevelOfCurrentLine()
+void Editor::indentSelection(bool dedent)
 {
-    QTextCursor originalCursor = textCursor();
-    moveCursorToStartOfCurrentLine();
-
-    QString documentContents = document()->toPlainText();
-    int indentationLevel = 0;
-
-    int index = textCursor().position();
-    if (index >= documentContents.length())
+    QTextCursor selection = textCursor();
+    QTextBlock firstBlock = document()->findBlock(selection.selectionStart());
+    QTextBlock lastBlock = document()->findBlock(selection.selectionEnd());
+    bool startsAtLineStart = selection.selectionStart() == firstBlock.position();
+    bool anchorIsStart = selection.anchor() < selection.position();
+
+    // A selection that ends at the very start of a line doesn't really include that line
+    if (lastBlock != firstBlock && selection.selectionEnd() == lastBlock.position())
     {
-        index--;
+        lastBlock = lastBlock.previous();
     }
 
-    while (index < documentContents.length())
+    QTextCursor editor(document());
+    editor.beginEditBlock();
+
+    for (QTextBlock block = firstBlock; block.isValid(); block = block.next())
     {
-        if (documentContents.at(index) == '\t')
+        if (dedent)
         {
-            indentationLevel++;
-            index++;
+            QString indentation = Indenter::leadingWhitespaceOf(block.text());
+            editor.setPosition(block.position() + indenter.dedented(indentation).length());
+            editor.setPosition(block.position() + indentation.length(), QTextCursor::KeepAnchor);
+            editor.removeSelectedText();
         }
         else
         {
-            break;
+            editor.setPosition(block.position());
+            editor.insertText(indenter.getIndentUnit());
         }
-    }
-
-    setTextCursor(originalCursor);
-    return indentationLevel;
-}
-
-
-/* Inserts the specified number of tabs in the document.
- */
-void Editor::insertTabs(int numTabs)
-{
-    for (int i = 0; i < numTabs; i++)
-    {
-        insertPlainText("\t");
-    }
-}
-
 
-/* Moves the cursor to the start of the current line.
- */
-void Editor::moveCursorToStartOfCurrentLine()
-{
-    QTextCursor cursor = textCursor();
-
-    do
-    {
-        cursor.movePosition(QTextCursor::Left);
-        setTextCursor(cursor);
-    }
-    while (metrics.currentColumn != 1);
-}
-
-
-/* Indents the selected text, if the cursor has a selection.
- * Returns true if it succeeds and false otherwise.
- */
-void Editor::indentSelection(QTextDocumentFragment selection)
-{
-    QString text = selection.toPlainText();
-
-    text.insert(0, '\t');
-    for (int i = 1; i < text.length(); i++)
-    {
-        // Insert a tab after each newline
-        if (text.at(i) == '\n' && i + 1 < text.length())
+        if (block == lastBlock)
         {
-            text.insert(i + 1, '\t');
+            break;
         }
     }
 
-    // Replace the selection with the new tabbed text
-    insertPlainText(text);
+    editor.endEditBlock();
+
+    // The selection's own cursor was moved along with the text it was next to, except that a selection starting
+    // right at the start of a line would be pushed past the indentation inserted there, so it's put back
+    int start = startsAtLineStart ? firstBlock.position() : selection.selectionStart();
+    int end = selection.selectionEnd();
+    selection.setPosition(anchorIsStart ? start : end);
+    selection.setPosition(anchorIsStart ? end : start, QTextCursor::KeepAnchor);
+    setTextCursor(selection);
 }
 
 
@@ -558,95 +1054,96 @@ void Editor::moveCursorTo(int positionInText)
 }
 
 
+/* Breaks the current line at the cursor and indents the new line (see Indenter). After a code block
+ * start that hasn't been closed yet, the end delimiter is inserted on a line of its own as well.
+ * Everything is inserted as one edit, so a single undo takes it all back.
+ */
 bool Editor::handleEnterKeyPress()
 {
-    QString documentContents = document()->toPlainText();
-    int indexToLeftOfCursor = textCursor().position() - 1;
-
-    // Edge cases
-    if (documentContents.length() < 1 ||
-        indexToLeftOfCursor < 0 ||
-        indexToLeftOfCursor >= documentContents.length())
+    if (isReadOnly())
     {
         return false;
     }
 
-    int currentIndent = indentationLevelOfCurrentLine();
-    QChar characterToLeftOfCursor = documentContents.at(indexToLeftOfCursor);
-
-    // Did the user hit ENTER right after a code block start, like an opening brace in C++?
-    if (syntaxHighlighter && characterToLeftOfCursor == syntaxHighlighter->getCodeBlockStartDelimiter())
-    {
-        QChar codeBlockStartDelimiter = syntaxHighlighter->getCodeBlockStartDelimiter();
-        QChar codeBlockEndDelimiter = syntaxHighlighter->getCodeBlockEndDelimiter();
+    QTextCursor cursor = textCursor();
+    cursor.beginEditBlock();
+    cursor.removeSelectedText();
 
-        insertPlainText("\n");
-        if (autoIndentEnabled)
-        {
-            insertTabs(currentIndent + 1);
-        }
+    QString textBeforeCursor = cursor.block().text().left(cursor.positionInBlock());
+    QString currentIndentation = Indenter::leadingWhitespaceOf(textBeforeCursor);
+    int codeBlockStart = Indenter::codeBlockStartIn(textBeforeCursor, syntaxHighlighter);
 
-        // Note: Some languages, like Python, don't have a code block end delimiter.
-        if (codeBlockEndDelimiter != NULL &&
-            Utility::codeBlockNotClosed(documentContents, codeBlockStartDelimiter, codeBlockEndDelimiter))
-        {
-            insertPlainText("\n");
-            insertTabs(currentIndent);
-            insertPlainText(codeBlockEndDelimiter);
+    // Note: Some languages, like Python, don't have a code block end delimiter.
+    bool mustCloseCodeBlock = codeBlockStart != -1 && syntaxHighlighter->getCodeBlockEndDelimiter() != NULL &&
+                              BracketMatcher::isUnclosed(cursor.block(), codeBlockStart);
 
-            // Set the cursor so it's right after the nested tab
-            moveCursorTo(textCursor().position() - 2 - currentIndent);
-        }
+    cursor.insertText("\n");
 
-        return true;
+    if (autoIndentEnabled)
+    {
+        cursor.insertText(indenter.indentationAfter(textBeforeCursor, syntaxHighlighter));
     }
 
-    // If the user hit ENTER after anything else, just take them to the next line but at the current indentation level
-    else
+    // Did the user hit ENTER right after a code block start, like an opening brace in C++, that has no match yet?
+    if (mustCloseCodeBlock)
     {
-        insertPlainText("\n");
-        if (autoIndentEnabled)
-        {
-            insertTabs(currentIndent);
-        }
-
-        return true;
+        int positionInsideBlock = cursor.position();
+        cursor.insertText("\n" + currentIndentation + syntaxHighlighter->getCodeBlockEndDelimiter());
+        cursor.setPosition(positionInsideBlock);
     }
+
+    cursor.endEditBlock();
+    setTextCursor(cursor);
+    return true;
 }
 
 
-/* Defines all the logic for what should happen when a user presses tab.
- * Currently, the only thing the editor will check for is if tab was
- * pressed while text was highlighted. If so, the text will be indented.
+/* Defines all the logic for what should happen when a user presses tab (or shift+tab, to dedent).
+ * With a selection, every selected line is indented or dedented. Without one, the current line
+ * is dedented, or one level of indentation is inserted at the cursor.
  */
-bool Editor::handleTabKeyPress()
+bool Editor::handleTabKeyPress(bool dedent)
 {
-    if (textCursor().hasSelection())
+    if (isReadOnly())
     {
-        indentSelection(textCursor().selection());
-        return true;
+        return false;
     }
 
-    return false;
+    if (textCursor().hasSelection() || dedent)
+    {
+        indentSelection(dedent);
+    }
+    else
+    {
+        insertPlainText(indenter.getIndentUnit());
+    }
+
+    return true;
 }
 
 
 /* Custom handler for events. Used to handle the case of Enter being pressed after an opening brace
- * or the tab key being used on a selection of text.
+ * or the tab keys being used to indent and dedent.
  */
 bool Editor::eventFilter(QObject* obj, QEvent* event)
 {
     if (event->type() == QEvent::KeyPress)
     {
+        // Keystrokes that come in before the next paint are all painted by it
+        if (!inputTimer.isValid())
+        {
+            inputTimer.start();
+        }
+
         int key = static_cast<QKeyEvent*>(event)->key();
 
         if (key == Qt::Key_Enter || key == Qt::Key_Return)
         {
             return handleEnterKeyPress();
         }
-        else if (key == Qt::Key_Tab)
+        else if (key == Qt::Key_Tab || key == Qt::Key_Backtab)
         {
-            return handleTabKeyPress();
+            return handleTabKeyPress(key == Qt::Key_Backtab);
         }
         else
         {
@@ -660,6 +1157,26 @@ bool Editor::eventFilter(QObject* obj, QEvent* event)
 }
 
 
+/* Paints the editor's text. The first paint after a keystroke records how long the keystroke
+ * took to show up (see getInputLatencies).
+ */
+void Editor::paintEvent(QPaintEvent *event)
+{
+    QPlainTextEdit::paintEvent(event);
+
+    if (inputTimer.isValid())
+    {
+        if (inputLatencies.size() == MAX_LATENCY_SAMPLES)
+        {
+            inputLatencies.removeFirst();
+        }
+
+        inputLatencies.append(inputTimer.nsecsElapsed() / 1000);
+        inputTimer.invalidate();
+    }
+}
+
+
 /* Preserves current settings for the editor so they can be
  * persisted into the next execution.
  */
@@ -745,6 +1262,29 @@ void Editor::resizeEvent(QResizeEvent *event)
 
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), getLineNumberAreaWidth(), cr.height()));
+    positionLoadProgress();
+    updateVisibleBlocks();
+}
+
+
+/* Called whenever the lines on screen may have changed. Highlights the Find All matches (if any)
+ * that are now on screen, and tells the syntax highlighter (if any) which lines are on screen so it
+ * can highlight those first.
+ */
+void Editor::updateVisibleBlocks()
+{
+    if (!findAllMatches.isEmpty())
+    {
+        highlightCurrentLine();
+    }
+
+    if (!syntaxHighlighter)
+    {
+        return;
+    }
+
+    int lastVisibleBlock = cursorForPosition(viewport()->rect().bottomLeft()).blockNumber();
+    syntaxHighlighter->setVisibleBlocks(firstVisibleBlock().blockNumber(), lastVisibleBlock);
 }
 
 
@@ -763,7 +1303,7 @@ void Editor::on_cursorPositionChanged()
 void Editor::updateLineCount()
 {
     metrics.currentLine = textCursor().blockNumber() + 1;
-    metrics.totalLines = document()->lineCount();
+    metrics.totalLines = blockCount();
     emit(lineCountChanged(metrics.currentLine, metrics.totalLines));
 }
 
@@ -791,10 +1331,121 @@ void Editor::highlightCurrentLine()
        selection.cursor.clearSelection();
        extraSelections.append(selection);
     }
+
+    highlightFindAllMatches(extraSelections);
+    highlightMatchingBrackets(extraSelections);
     setExtraSelections(extraSelections);
 }
 
 
+/* Adds highlights for the matches from the last Find All that are on screen to the given selections.
+ * There can be millions of matches, so only the ones between the first and last visible blocks are
+ * looked up (the matches are in order), and they're looked up again whenever the editor scrolls.
+ */
+void Editor::highlightFindAllMatches(QList<QTextEdit::ExtraSelection> &extraSelections)
+{
+    if (findAllMatches.isEmpty())
+    {
+        return;
+    }
+
+    int first = firstVisibleBlock().position();
+    QTextBlock lastBlock = cursorForPosition(viewport()->rect().bottomRight()).block();
+    int last = lastBlock.position() + lastBlock.length();
+
+    // Matches never span lines, so none that starts before the first visible block is on screen
+    auto match = std::lower_bound(findAllMatches.begin(), findAllMatches.end(), first);
+    for (; match != findAllMatches.end() && *match < last; ++match)
+    {
+        int length = findAllMatchLengths[static_cast<int>(match - findAllMatches.begin())];
+
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(FIND_ALL_COLOR);
+        selection.cursor = QTextCursor(document());
+        selection.cursor.setPosition(*match);
+        selection.cursor.setPosition(*match + length, QTextCursor::KeepAnchor);
+        extraSelections.append(selection);
+    }
+}
+
+
+/* Adds highlights for the bracket next to the cursor and its match (see BracketMatcher) to the given
+ * selections. A bracket without a proper match is highlighted on its own in a different color.
+ * Plain text has no highlighter to tell which brackets are real, so nothing is highlighted there.
+ */
+void Editor::highlightMatchingBrackets(QList<QTextEdit::ExtraSelection> &extraSelections)
+{
+    int bracketInBlock = bracketNextToCursor();
+    if (!syntaxHighlighter || bracketInBlock == -1)
+    {
+        return;
+    }
+
+    QTextBlock block = textCursor().block();
+    int match = BracketMatcher::findMatch(block, bracketInBlock);
+    QList<int> positionsToHighlight = {block.position() + bracketInBlock};
+
+    if (match >= 0)
+    {
+        positionsToHighlight.append(match);
+    }
+
+    for (int position : positionsToHighlight)
+    {
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(match >= 0 ? BRACKET_MATCH_COLOR : BRACKET_MISMATCH_COLOR);
+        selection.cursor = QTextCursor(document());
+        selection.cursor.setPosition(position);
+        selection.cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+        extraSelections.append(selection);
+    }
+}
+
+
+/* Returns the position within the current line of the bracket right after the cursor, or if
+ * there isn't one, of the bracket right before it. Returns -1 if there's neither.
+ */
+int Editor::bracketNextToCursor()
+{
+    QString line = textCursor().block().text();
+    int positionInBlock = textCursor().positionInBlock();
+
+    if (positionInBlock < line.length() && BracketMatcher::isBracket(line.at(positionInBlock)))
+    {
+        return positionInBlock;
+    }
+
+    if (positionInBlock > 0 && BracketMatcher::isBracket(line.at(positionInBlock - 1)))
+    {
+        return positionInBlock - 1;
+    }
+
+    return -1;
+}
+
+
+/* Moves the cursor to the bracket matching the one next to it. The cursor ends up on the same
+ * side of the match as it was of the original bracket, so jumping twice returns to where it started.
+ */
+void Editor::jumpToMatchingBracket()
+{
+    int bracketInBlock = bracketNextToCursor();
+    if (bracketInBlock == -1)
+    {
+        return;
+    }
+
+    int match = BracketMatcher::findMatch(textCursor().block(), bracketInBlock);
+    if (match < 0)
+    {
+        return;
+    }
+
+    bool cursorWasAfterBracket = bracketInBlock == textCursor().positionInBlock() - 1;
+    moveCursorTo(cursorWasAfterBracket ? match + 1 : match);
+}
+
+
 /* See linenumberarea.h for the call. Loops through each block (paragraph/line) in the
  * editor and paints the corresponding line numbers in the lineNumberArea.
  */
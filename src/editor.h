@@ -4,10 +4,21 @@
 #include "gotodialog.h"
 #include "searchhistory.h"
 #include "documentmetrics.h"
+#include "metricstracker.h"
+#include "byteoffsetindex.h"
+#include "indenter.h"
 #include "language.h"
 #include "highlighters/highlighter.h"
 #include "settings.h"
+#include "fileloader.h"
+#include "filesaver.h"
+#include "textencoding.h"
+#include "loadprogress.h"
+#include "textsearcher.h"
+#include "regexsearchworker.h"
 #include <QPlainTextEdit>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
 #include <QFont>
 #include <QMessageBox>
 
@@ -39,7 +50,13 @@ public:
     inline QString getCurrentFilePath() const { return currentFilePath; }
     void setProgrammingLanguage(Language language);
     inline Language getProgrammingLanguage() const { return programmingLanguage; }
+    inline Highlighter *getHighlighter() const { return syntaxHighlighter; }
+    inline QVector<qint64> getInputLatencies() const { return inputLatencies; }
     inline bool isUntitled() const { return fileIsUntitled; }
+    void load(QString filePath);
+    inline bool isLoading() const { return loader != nullptr; }
+    void save(QString filePath);
+    inline bool isSaving() const { return saver != nullptr; }
 
     inline DocumentMetrics getDocumentMetrics() const { return metrics; }
     QFont getFont() { return font; }
@@ -48,6 +65,7 @@ public:
     inline bool isUnsaved() const { return document()->isModified(); }
     void setModifiedState(bool modified) { document()->setModified(modified); }
 
+    void replaceMatches(const QVector<int> &starts, const QVector<int> &lengths, const QVector<QString> &replacements);
     void formatSubtext(int startIndex, int endIndex, QTextCharFormat format, bool unformatAllFirst = false);
     void toggleAutoIndent(bool autoIndent);
     bool textIsAutoIndented() const { return autoIndentEnabled; }
@@ -63,34 +81,53 @@ public:
     void setLineWrapMode(LineWrapMode lineWrapMode);
 
     const static int DEFAULT_FONT_SIZE = 10;
+    const static int MAX_LATENCY_SAMPLES = 1000;
     const static int NUM_CHARS_FOR_TAB = 5;
+    const static int FIND_NEXT_TIMEOUT = 2000;
 
     bool autoIndentEnabled = true;
     LineWrapMode lineWrapMode = Editor::LineWrapMode::NoWrap;
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
     bool eventFilter(QObject* obj, QEvent* event) override;
 
 signals:
     void findResultReady(QString message);
+    void searchProgress(QString message);
     void gotoResultReady(QString message);
     void wordCountChanged(int words);
     void charCountChanged(int chars);
     void lineCountChanged(int current, int total);
     void columnCountChanged(int col);
     void fileContentsChanged();
+    void saveFinished(bool succeeded);
 
 public slots:
-    bool find(QString query, bool caseSensitive, bool wholeWords);
-    void replace(QString what, QString with, bool caseSensitive, bool wholeWords);
-    void replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords);
-    void goTo(int line);
+    bool find(QString query, bool caseSensitive, bool wholeWords, bool regex = false);
+    void findAll(QString query, bool caseSensitive, bool wholeWords, bool regex = false);
+    void replace(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex = false);
+    void replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex = false);
+    void cancelSearch();
+    void goTo(int line, int column = 1);
+    void goToAfterLoading(int line, int column = 1);
+    void goToOffset(qint64 byteOffset);
+    void goToPercent(int percent);
+    void jumpToMatchingBracket();
+    void cancelLoading();
 
 private slots:
     void on_textChanged();
     void updateLineNumberAreaWidth();
     void on_cursorPositionChanged();
+    void on_chunkLoaded(QString text);
+    void on_loadFailed(QString error);
+    void on_loadFinished();
+    void on_saveFinished();
+    void updateVisibleBlocks();
+    void on_regexBatchReady(RegexMatchBatch batch);
+    void on_regexSearchDone(int generation, int outcome, int numSkippedLines);
 
     void redrawLineNumberArea(const QRect &rectToBeRedrawn, int numPixelsScrolledVertically);
 
@@ -101,42 +138,80 @@ private:
     Highlighter *generateHighlighterFor(Language language);
     QString getFileNameFromPath();
     QTextDocument::FindFlags getSearchOptionsFromFlags(bool caseSensitive, bool wholeWords);
+    bool findNextMatch(const QString &query, QTextDocument::FindFlags searchOptions, const RegexSearcher *searcher, QDeadlineTimer deadline);
+    void startRegexSearch(const QString &pattern, const QString &with, bool caseSensitive, bool wholeWords, bool replacing);
+    void selectFindAllMatchAfterCursor();
     bool handleEnterKeyPress();
-    bool handleTabKeyPress();
+    bool handleTabKeyPress(bool dedent);
     void moveCursorTo(int positionInText);
+    void positionLoadProgress();
 
     void highlightCurrentLine();
+    void highlightMatchingBrackets(QList<QTextEdit::ExtraSelection> &extraSelections);
+    void highlightFindAllMatches(QList<QTextEdit::ExtraSelection> &extraSelections);
+    int bracketNextToCursor();
     void updateWordCount();
     void updateCharCount();
     void updateColumnCount();
     void updateLineCount();
 
-    int indentationLevelOfCurrentLine();
-    void moveCursorToStartOfCurrentLine();
-    void insertTabs(int numTabs);
-    void indentSelection(QTextDocumentFragment selection);
+    void indentSelection(bool dedent);
 
     void writeSettings();
     void readSettings();
 
     Language programmingLanguage;
-    Highlighter *syntaxHighlighter;
+    Highlighter *syntaxHighlighter = nullptr;
     const static QColor LINE_COLOR;
+    const static QColor BRACKET_MATCH_COLOR;
+    const static QColor BRACKET_MISMATCH_COLOR;
+    const static QColor FIND_ALL_COLOR;
 
     DocumentMetrics metrics;
+    MetricsTracker *metricsTracker;
+    ByteOffsetIndex *byteOffsetIndex;
+    Indenter indenter;
     QString currentFilePath;
+    TextEncoding encoding = TextEncoding::localeDefault();
     bool fileIsUntitled = true;
 
     QFont font;
     QTextCharFormat defaultCharFormat;
     SearchHistory searchHistory;
 
+    // The positions and lengths of the matches from the last Find All, until the document is next edited
+    QVector<int> findAllMatches;
+    QVector<int> findAllMatchLengths;
+
+    // The regular expression search (if any) that's running on a snapshot of the document
+    RegexSearchWorker *regexWorker = nullptr;
+    int searchGeneration = 0;
+    int revisionAtSearch = 0;
+    bool searchIsReplacing = false;
+    QVector<QString> searchReplacements;
+    QElapsedTimer searchTimer;
+
     QWidget *lineNumberArea;
     const int lineNumberAreaPadding = 30;
 
+    FileLoader *loader = nullptr;
+    LoadProgress *loadProgress = nullptr;
+    bool loadCanceled = false;
+
+    // Where to go once the file being loaded is in (see goToAfterLoading); 0 for nowhere
+    int lineAfterLoading = 0;
+    int columnAfterLoading = 1;
+
+    FileSaver *saver = nullptr;
+    int revisionAtSave = 0;
+
     bool canRedo = false;
     bool canUndo = false;
 
+    // How many microseconds each of the last MAX_LATENCY_SAMPLES keystrokes took to be painted
+    QElapsedTimer inputTimer;
+    QVector<qint64> inputLatencies;
+
     Settings *settings = Settings::instance();
 
     const QString AUTO_INDENT_KEY = "auto_indent";
@@ -0,0 +1,50 @@
+#include "encodedlength.h"
+
+
+/* Initializes this EncodedLength for text saved in the given encoding, with its line ending.
+ */
+EncodedLength::EncodedLength(const TextEncoding &encoding)
+{
+    QTextCodec *codec = encoding.codec();
+    encoder.reset(codec->makeEncoder(QTextCodec::IgnoreHeader));
+    codecMib = codec->mibEnum();
+
+    bool isUtf16 = codecMib == 1013 || codecMib == 1014 || codecMib == 1015;
+    headerLength = !encoding.hasByteOrderMark ? 0 : isUtf16 ? 2 : codecMib == 106 ? 3 : 0;
+    newlineLength = isUtf16 ? 2 * encoding.lineEnding.length() : encoder->fromUnicode(encoding.lineEnding).size();
+}
+
+
+/* Returns the encoded length of the character at the given index (both halves of a surrogate pair)
+ * and advances the index past it. UTF-8 and UTF-16 are worked out directly; any other encoding
+ * is asked of the codec.
+ */
+int EncodedLength::ofCharAt(const QString &text, int &index)
+{
+    QChar ch = text[index];
+    bool isPair = ch.isHighSurrogate() && index + 1 < text.length() && text[index + 1].isLowSurrogate();
+    int numUnits = isPair ? 2 : 1;
+    index += numUnits;
+
+    // A line separator is saved as a line ending, and a no-break space as a space (see FileSaver)
+    if (ch == QChar::LineSeparator)
+    {
+        return newlineLength;
+    }
+    else if (ch == QChar::Nbsp)
+    {
+        ch = ' ';
+    }
+
+    if (codecMib == 106)
+    {
+        return isPair ? 4 : ch.unicode() < 0x80 ? 1 : ch.unicode() < 0x800 ? 2 : 3;
+    }
+
+    if (codecMib == 1013 || codecMib == 1014 || codecMib == 1015)
+    {
+        return 2 * numUnits;
+    }
+
+    return isPair ? encoder->fromUnicode(text.constData() + index - 2, 2).size() : encoder->fromUnicode(&ch, 1).size();
+}
@@ -0,0 +1,29 @@
+#ifndef ENCODEDLENGTH_H
+#define ENCODEDLENGTH_H
+#include "textencoding.h"
+#include <QTextCodec>
+#include <QScopedPointer>
+#include <QString>
+
+
+/* Works out how many bytes text takes up once saved in a given encoding (see FileSaver), one
+ * character at a time, without encoding more than it has to. Needs no document, so the same
+ * counting can be done by a FileLoader on its own thread and by a ByteOffsetIndex on the GUI's.
+ */
+class EncodedLength
+{
+public:
+    EncodedLength(const TextEncoding &encoding);
+
+    int ofCharAt(const QString &text, int &index);
+    inline int ofHeader() const { return headerLength; }
+    inline int ofNewline() const { return newlineLength; }
+
+private:
+    QScopedPointer<QTextEncoder> encoder;
+    int codecMib;
+    int headerLength;
+    int newlineLength;
+};
+
+#endif // ENCODEDLENGTH_H
@@ -0,0 +1,162 @@
+#include "fileloader.h"
+#include "utf8decoder.h"
+#include "byteoffsetindex.h"
+#include <QFile>
+#include <QTextCodec>
+#include <QScopedPointer>
+
+
+/* Initializes this FileLoader. Call start() to begin loading.
+ */
+FileLoader::FileLoader(QString filePath, QObject *parent)
+    : QThread(parent), filePath(filePath), chunksInFlight(MAX_CHUNKS_IN_FLIGHT),
+      encoding(TextEncoding::localeDefault())
+{
+}
+
+
+/* Blocks until the consumer is ready for another chunk. Returns false if
+ * loading was interrupted (see QThread::requestInterruption) in the meantime.
+ */
+bool FileLoader::waitForConsumer()
+{
+    while (!chunksInFlight.tryAcquire(1, 50))
+    {
+        if (isInterruptionRequested())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* Runs on the worker thread. Reads the file one chunk at a time and emits
+ * each decoded chunk along with the overall progress. The encoding is
+ * detected from the first chunk (see TextEncoding::detect), and the line
+ * ending from the first line break. Checkpoints are recorded as the text
+ * goes by (see recordCheckpoints).
+ */
+void FileLoader::run()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        emit(loadFailed(file.errorString()));
+        return;
+    }
+
+    qint64 fileSize = file.size();
+    qint64 bytesRead = 0;
+    QString carriedOver;
+    bool lineEndingDetected = false;
+
+    // The decoders are stateful, so multi-byte characters split across two chunks come out whole
+    Utf8Decoder utf8Decoder;
+    QScopedPointer<QTextDecoder> decoder;
+
+    while (!file.atEnd())
+    {
+        if (isInterruptionRequested())
+        {
+            return;
+        }
+
+        QByteArray bytes = file.read(CHUNK_SIZE);
+        if (bytes.isEmpty() && file.error() != QFile::NoError)
+        {
+            emit(loadFailed(file.errorString()));
+            return;
+        }
+
+        if (bytesRead == 0)
+        {
+            encoding = TextEncoding::detect(bytes);
+            if (!encoding.isUtf8())
+            {
+                decoder.reset(encoding.codec()->makeDecoder());
+            }
+
+            encodedLength.reset(new EncodedLength(encoding));
+            checkpoints = {encodedLength->ofHeader()};
+        }
+
+        bytesRead += bytes.size();
+        QString text = carriedOver + (decoder ? decoder->toUnicode(bytes) : utf8Decoder.toUnicode(bytes));
+        carriedOver.clear();
+
+        if (file.atEnd() && !decoder)
+        {
+            text += utf8Decoder.flush();
+        }
+
+        // Hold back a trailing \r in case it's the first half of a \r\n split across chunks
+        if (text.endsWith('\r') && !file.atEnd())
+        {
+            text.chop(1);
+            carriedOver = "\r";
+        }
+
+        // The first line break found is taken to be the one the whole file uses
+        if (!lineEndingDetected)
+        {
+            QString lineEnding = TextEncoding::detectLineEnding(text);
+            if (!lineEnding.isNull())
+            {
+                encoding.lineEnding = lineEnding;
+                lineEndingDetected = true;
+                encodedLength.reset(new EncodedLength(encoding));
+            }
+        }
+
+        recordCheckpoints(text);
+
+        if (!waitForConsumer())
+        {
+            return;
+        }
+
+        emit(chunkLoaded(text));
+        emit(progressChanged(static_cast<int>(bytesRead * 100 / qMax(fileSize, qint64(1)))));
+    }
+}
+
+
+/* Counts the encoded length of the given text, which comes right after the text counted so far, and
+ * records the offset of every ByteOffsetIndex::STRIDE-th line that starts in it. The document breaks
+ * lines where this does (see QTextCursor::insertText), and run() never splits a \r\n between chunks.
+ */
+void FileLoader::recordCheckpoints(const QString &text)
+{
+    // A surrogate pair split between two chunks is counted once both halves have arrived
+    QString counted = heldSurrogate.isEmpty() ? text : heldSurrogate + text;
+    heldSurrogate.clear();
+
+    if (!counted.isEmpty() && counted.at(counted.length() - 1).isHighSurrogate())
+    {
+        heldSurrogate = counted.right(1);
+        counted.chop(1);
+    }
+
+    for (int index = 0; index < counted.length(); )
+    {
+        QChar ch = counted.at(index);
+        bool isLineBreak = ch == '\n' || ch == '\r' || ch == QChar::ParagraphSeparator;
+
+        if (!isLineBreak && ch != QChar::LineSeparator)
+        {
+            bytesCounted += encodedLength->ofCharAt(counted, index);
+            continue;
+        }
+
+        bool isCrLf = ch == '\r' && index + 1 < counted.length() && counted.at(index + 1) == '\n';
+        index += isCrLf ? 2 : 1;
+        lineEndingsCounted++;
+
+        if (isLineBreak && ++linesCounted % ByteOffsetIndex::STRIDE == 0)
+        {
+            checkpoints.append(encodedLength->ofHeader() + bytesCounted + lineEndingsCounted * encodedLength->ofNewline());
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+#include <QThread>
+#include <QSemaphore>
+#include <QString>
+#include <QVector>
+#include <QScopedPointer>
+#include "textencoding.h"
+#include "encodedlength.h"
+
+
+/* Reads and decodes a file on a worker thread, handing it over in fixed-size
+ * chunks so the GUI can show the beginning of a file before the rest has been
+ * read. At most MAX_CHUNKS_IN_FLIGHT chunks are ever waiting to be consumed,
+ * so the loader can't run ahead of the document and pile up copies of the file.
+ *
+ * While it reads, the loader also records where every ByteOffsetIndex::STRIDE-th line
+ * starts in the file, so that the GUI never has to encode the whole document to find
+ * out (see ByteOffsetIndex::adoptCheckpoints).
+ */
+class FileLoader : public QThread
+{
+    Q_OBJECT
+
+public:
+    FileLoader(QString filePath, QObject *parent = nullptr);
+    void chunkConsumed() { chunksInFlight.release(); }
+    inline TextEncoding detectedEncoding() const { return encoding; }
+    inline QVector<qint64> blockCheckpoints() const { return checkpoints; }
+
+    const static int CHUNK_SIZE = 256 * 1024;
+    const static int MAX_CHUNKS_IN_FLIGHT = 4;
+
+signals:
+    void chunkLoaded(QString text);
+    void progressChanged(int percent);
+    void loadFailed(QString error);
+
+protected:
+    void run() override;
+
+private:
+    bool waitForConsumer();
+    void recordCheckpoints(const QString &text);
+
+    QString filePath;
+    QSemaphore chunksInFlight;
+    TextEncoding encoding;
+
+    // See ByteOffsetIndex; line endings are counted apart from the rest, since which one the file uses isn't known at first
+    QScopedPointer<EncodedLength> encodedLength;
+    QVector<qint64> checkpoints;
+    qint64 bytesCounted = 0;
+    qint64 lineEndingsCounted = 0;
+    qint64 linesCounted = 0;
+    QString heldSurrogate;
+};
+
+#endif // FILELOADER_H
@@ -0,0 +1,101 @@
+#include "filesaver.h"
+#include <QSaveFile>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCodec>
+#include <QScopedPointer>
+
+
+/* Initializes this FileSaver with the lines to write (see snapshotOf).
+ */
+FileSaver::FileSaver(const QStringList &lines, QString filePath, TextEncoding encoding, QObject *parent)
+    : QThread(parent), lines(lines), filePath(filePath), encoding(encoding)
+{
+}
+
+
+/* Performs all necessary memory cleanup operations.
+ */
+FileSaver::~FileSaver()
+{
+    wait();
+}
+
+
+/* Returns the text of every block of the given document, in order. Unlike QTextDocument::clone,
+ * this copies nothing but the characters, and once per block, so it's cheap enough for the GUI thread.
+ */
+QStringList FileSaver::snapshotOf(QTextDocument *document)
+{
+    QStringList lines;
+    lines.reserve(document->blockCount());
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        lines.append(block.text());
+    }
+
+    return lines;
+}
+
+
+/* Runs on the worker thread. Writes every line of the snapshot to a temporary file
+ * in the document's encoding (line endings included) and then atomically renames it over the target.
+ */
+void FileSaver::run()
+{
+    QSaveFile file(filePath);
+    // Not in Text mode, which would put a \r before every 0x0A byte, even inside UTF-16 characters
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        error = file.errorString();
+        return;
+    }
+
+    // Only write a byte order mark if the file had one to begin with
+    QTextCodec::ConversionFlags flags = encoding.hasByteOrderMark ? QTextCodec::DefaultConversion : QTextCodec::IgnoreHeader;
+    QScopedPointer<QTextEncoder> encoder(encoding.codec()->makeEncoder(flags));
+    QByteArray buffer;
+    buffer.reserve(BUFFER_SIZE);
+
+    for (int i = 0; i < lines.size(); i++)
+    {
+        QString line = lines[i];
+        bool isLastLine = i == lines.size() - 1;
+
+        // Match what QTextDocument::toPlainText produces for these, but with the file's own line ending
+        line.replace(QChar::Nbsp, ' ');
+        line.replace(QChar::LineSeparator, encoding.lineEnding);
+
+        if (!isLastLine)
+        {
+            line += encoding.lineEnding;
+        }
+
+        buffer += encoder->fromUnicode(line);
+
+        // Each line's copy can go as soon as it's encoded
+        lines[i] = QString();
+
+        if (buffer.size() >= BUFFER_SIZE || isLastLine)
+        {
+            if (file.write(buffer) != buffer.size())
+            {
+                error = file.errorString();
+                file.cancelWriting();
+                return;
+            }
+
+            buffer.resize(0);
+        }
+    }
+
+    // Flushes, syncs to disk, and renames the temporary file over the target
+    if (!file.commit())
+    {
+        error = file.errorString();
+        return;
+    }
+
+    saveSucceeded = true;
+}
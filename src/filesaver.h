@@ -0,0 +1,43 @@
+#ifndef FILESAVER_H
+#define FILESAVER_H
+#include <QThread>
+#include <QStringList>
+#include <QString>
+#include "textencoding.h"
+
+class QTextDocument;
+
+
+/* Writes a snapshot of a document to disk on a worker thread. The snapshot is just the text of
+ * each block (see snapshotOf), which is quick to take on the GUI thread; the lines are encoded
+ * one at a time into a small buffer, so no full-size encoded copy is ever built, and it goes
+ * to a temporary file that only replaces the target once it has
+ * been written and synced in full (see QSaveFile). A crash part-way through a save
+ * therefore leaves the original file untouched.
+ */
+class FileSaver : public QThread
+{
+    Q_OBJECT
+
+public:
+    FileSaver(const QStringList &lines, QString filePath, TextEncoding encoding, QObject *parent = nullptr);
+    ~FileSaver() override;
+
+    inline bool succeeded() const { return saveSucceeded; }
+    inline QString errorString() const { return error; }
+    static QStringList snapshotOf(QTextDocument *document);
+
+    const static int BUFFER_SIZE = 1024 * 1024;
+
+protected:
+    void run() override;
+
+private:
+    QStringList lines;
+    QString filePath;
+    TextEncoding encoding;
+    bool saveSucceeded = false;
+    QString error;
+};
+
+#endif // FILESAVER_H
@@ -0,0 +1,678 @@
+#include "filesearch.h"
+#include "textencoding.h"
+#include "searchresultspanel.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <cstring>
+#include <climits>
+
+
+/* Lists one directory on a FileSearch's thread pool.
+ */
+class DirectoryTask : public QRunnable
+{
+public:
+    DirectoryTask(FileSearch *search, const QString &path) : search(search), path(path) {}
+
+    void run() override
+    {
+        search->walkDirectory(path);
+        search->taskFinished();
+    }
+
+private:
+    FileSearch *search;
+    QString path;
+};
+
+
+/* Searches one file on a FileSearch's thread pool.
+ */
+class FileTask : public QRunnable
+{
+public:
+    FileTask(FileSearch *search, const QString &path) : search(search), path(path) {}
+
+    void run() override
+    {
+        search->searchFile(path);
+        search->taskFinished();
+    }
+
+private:
+    FileSearch *search;
+    QString path;
+};
+
+
+namespace
+{
+    // A line with matches, as found in a file's bytes or decoded text
+    struct MatchedLine
+    {
+        int start;
+        int end;
+        int number;
+        int column;
+        int numMatches;
+    };
+
+    QString lineText(const char *data, int start, int end)
+    {
+        // A character takes at most 4 bytes, so this is always enough to fill the listed length
+        int numBytes = qMin(end - start, ListedMatch::MAX_LINE_LENGTH * 4);
+        return QString::fromUtf8(data + start, numBytes).left(ListedMatch::MAX_LINE_LENGTH);
+    }
+
+    QString lineText(const QChar *data, int start, int end)
+    {
+        return QString(data + start, qMin(end - start, static_cast<int>(ListedMatch::MAX_LINE_LENGTH)));
+    }
+
+    template <typename Char>
+    int countNewlines(const Char *data, int from, int to)
+    {
+        int count = 0;
+
+        for (int i = from; i < to; i++)
+        {
+            count += data[i] == Char('\n') ? 1 : 0;
+        }
+
+        return count;
+    }
+
+    template <typename Char>
+    int startOfLine(const Char *data, int position)
+    {
+        while (position > 0 && data[position - 1] != Char('\n'))
+        {
+            position--;
+        }
+
+        return position;
+    }
+
+    template <typename Char>
+    int endOfLine(const Char *data, int length, int position)
+    {
+        while (position < length && data[position] != Char('\n'))
+        {
+            position++;
+        }
+
+        return position;
+    }
+
+    // A line with matches as it's to be listed, with up to CONTEXT_LINES lines of context on either side
+    struct ListedLine
+    {
+        int number;
+        int column;
+        QString text;
+        QVector<QString> before;
+        QVector<QString> after;
+    };
+
+    // The lines with matches found in a file so far. Only the first MAX_LISTED_LINES are listed.
+    struct FileListing
+    {
+        QVector<ListedLine> lines;
+        int firstUnlistedLine = INT_MAX;
+        int numMatches = 0;
+    };
+
+    /* Adds the given line with matches to the listing, with as much context as the given data has
+     * around it. A line that's already been listed (because it was cut, see FileSearch::searchText)
+     * only has its matches counted.
+     */
+    template <typename Char>
+    void addMatchedLine(const Char *data, int length, const MatchedLine &matched, FileListing &listing)
+    {
+        listing.numMatches += matched.numMatches;
+
+        if (!listing.lines.isEmpty() && listing.lines.last().number == matched.number)
+        {
+            return;
+        }
+
+        if (listing.lines.size() == FileSearch::MAX_LISTED_LINES)
+        {
+            listing.firstUnlistedLine = qMin(listing.firstUnlistedLine, matched.number);
+            return;
+        }
+
+        ListedLine listed = {matched.number, matched.column, lineText(data, matched.start, matched.end), {}, {}};
+        int start = matched.start;
+
+        // Working backwards from the matched line, then listing them in order
+        for (int k = 0; k < FileSearch::CONTEXT_LINES && start > 0; k++)
+        {
+            int end = start - 1;
+            start = startOfLine(data, end);
+            listed.before.prepend(lineText(data, start, end));
+        }
+
+        int end = matched.end;
+
+        for (int k = 0; k < FileSearch::CONTEXT_LINES && end < length; k++)
+        {
+            int start = end + 1;
+            end = endOfLine(data, length, start);
+            listed.after.append(lineText(data, start, end));
+        }
+
+        listing.lines.append(listed);
+    }
+
+    /* Lists the listed lines in the given hits, each with its context. Context is never listed
+     * twice, nor in place of a line with matches.
+     */
+    void collectHits(const FileListing &listing, FileHits &hits)
+    {
+        int lastListedLine = 0;
+        hits.numMatches = listing.numMatches;
+
+        for (int i = 0; i < listing.lines.size(); i++)
+        {
+            const ListedLine &listed = listing.lines[i];
+            int numBefore = qMin(listed.before.size(), listed.number - 1 - lastListedLine);
+
+            for (int k = listed.before.size() - numBefore; k < listed.before.size(); k++)
+            {
+                hits.lines.append({listed.number - (listed.before.size() - k), 0, listed.before[k]});
+            }
+
+            hits.lines.append({listed.number, listed.column, listed.text});
+            lastListedLine = listed.number;
+
+            int nextMatchedLine = i + 1 < listing.lines.size() ? listing.lines[i + 1].number : listing.firstUnlistedLine;
+
+            for (int k = 0; k < listed.after.size() && listed.number + k + 1 < nextMatchedLine; k++)
+            {
+                hits.lines.append({listed.number + k + 1, 0, listed.after[k]});
+                lastListedLine = listed.number + k + 1;
+            }
+        }
+    }
+}
+
+
+/* Initializes this FileSearch of everything under the given directory. Call start() to begin.
+ * A regular expression must be valid (see RegexSearcher::isValid).
+ */
+FileSearch::FileSearch(const QString &root, const QString &query, bool caseSensitive, bool wholeWords, bool regex,
+                       const QStringList &includeGlobs, const QStringList &excludeGlobs, QObject *parent)
+    : QObject(parent), root(root), query(query), caseSensitive(caseSensitive), wholeWords(wholeWords), regex(regex),
+      includeGlobs(includeGlobs), excludeGlobs(excludeGlobs), textSearcher(query, caseSensitive, wholeWords),
+      byteMatcher(query.toUtf8())
+{
+}
+
+
+/* Cancels the search, waiting for the tasks that are still running to stop.
+ */
+FileSearch::~FileSearch()
+{
+    canceled.storeRelease(1);
+    pool.waitForDone();
+    qDeleteAll(idleSearchers);
+}
+
+
+/* Starts walking the root directory.
+ */
+void FileSearch::start()
+{
+    timer.start();
+    startTask(new DirectoryTask(this, root));
+}
+
+
+/* Returns the hits that have been found since the last call, in no particular order.
+ */
+QVector<FileHits> FileSearch::takeHits()
+{
+    QMutexLocker locker(&hitsMutex);
+    QVector<FileHits> hits;
+    hits.swap(pendingHits);
+    return hits;
+}
+
+
+/* Returns true if the given glob matches the whole of the given name, ignoring case as QDir does.
+ * A * matches any run of characters and a ? matches any one character.
+ */
+bool FileSearch::globMatches(const QString &glob, const QString &name)
+{
+    int g = 0;
+    int n = 0;
+
+    // Where to pick up again if what follows the last * turns out not to match here
+    int starGlob = -1;
+    int starName = 0;
+
+    while (n < name.length())
+    {
+        if (g < glob.length() && glob.at(g) == '*')
+        {
+            starGlob = g++;
+            starName = n;
+        }
+        else if (g < glob.length() && (glob.at(g) == '?' || glob.at(g).toCaseFolded() == name.at(n).toCaseFolded()))
+        {
+            g++;
+            n++;
+        }
+        else if (starGlob != -1)
+        {
+            g = starGlob + 1;
+            n = ++starName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (g < glob.length() && glob.at(g) == '*')
+    {
+        g++;
+    }
+
+    return g == glob.length();
+}
+
+
+/* Returns true if any of the given globs matches the given name.
+ */
+bool FileSearch::matchesAny(const QStringList &globs, const QString &name) const
+{
+    for (const QString &glob : globs)
+    {
+        if (globMatches(glob, name))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/* Hands the given task to the pool, counting it as pending until it's finished.
+ */
+void FileSearch::startTask(QRunnable *task)
+{
+    pendingTasks.ref();
+    pool.start(task);
+}
+
+
+/* Called by every task once it's done. The search is done once no tasks are left, since every
+ * task that could start another one does so before it finishes.
+ */
+void FileSearch::taskFinished()
+{
+    if (!pendingTasks.deref())
+    {
+        QMetaObject::invokeMethod(this, "on_walkDone", Qt::QueuedConnection);
+    }
+}
+
+
+/* Runs on a pooled thread. Hands the given directory's subdirectories and files to the pool,
+ * leaving out the ones the globs rule out.
+ */
+void FileSearch::walkDirectory(const QString &path)
+{
+    const QFileInfoList entries = QDir(path).entryInfoList(QDir::Dirs | QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDir::NoSort);
+
+    for (const QFileInfo &entry : entries)
+    {
+        if (canceled.loadAcquire())
+        {
+            return;
+        }
+
+        QString name = entry.fileName();
+
+        if (matchesAny(excludeGlobs, name))
+        {
+            continue;
+        }
+
+        if (entry.isDir())
+        {
+            // Following links to directories could walk in circles
+            if (!entry.isSymLink())
+            {
+                startTask(new DirectoryTask(this, entry.filePath()));
+            }
+        }
+        else if (includeGlobs.isEmpty() || matchesAny(includeGlobs, name))
+        {
+            startTask(new FileTask(this, entry.filePath()));
+        }
+    }
+}
+
+
+/* Runs on a pooled thread. Maps the given file, skips it if it's binary, searches it, and hands
+ * over whatever was found.
+ */
+void FileSearch::searchFile(const QString &path)
+{
+    if (canceled.loadAcquire())
+    {
+        return;
+    }
+
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        numUnreadableFiles.ref();
+        return;
+    }
+
+    qint64 size = file.size();
+
+    if (size > MAX_FILE_SIZE)
+    {
+        numSkippedFiles.ref();
+        return;
+    }
+
+    // Mapping an empty file fails, but there's nothing to search anyway
+    if (size == 0)
+    {
+        numFilesSearched.ref();
+        return;
+    }
+
+    uchar *mapping = file.map(0, size);
+
+    if (!mapping)
+    {
+        numUnreadableFiles.ref();
+        return;
+    }
+
+    const char *data = reinterpret_cast<const char*>(mapping);
+    const int length = static_cast<int>(size);
+
+    // Like grep, take a NUL byte near the start to mean binary, unless it's UTF-16
+    QByteArray sample = QByteArray::fromRawData(data, qMin(length, static_cast<int>(BINARY_SAMPLE_SIZE)));
+    TextEncoding encoding = TextEncoding::detect(sample);
+
+    if (!encoding.codecName.startsWith("UTF-16") && sample.contains('\0'))
+    {
+        numSkippedFiles.ref();
+        return;
+    }
+
+    FileHits hits;
+    hits.path = path;
+
+    if (!regex && caseSensitive && encoding.isUtf8())
+    {
+        searchBytes(data, length, hits);
+    }
+    else
+    {
+        searchText(encoding.codec(), data, length, hits);
+    }
+
+    numFilesSearched.ref();
+    bytesSearched.fetchAndAddRelaxed(size);
+
+    if (hits.numMatches == 0)
+    {
+        return;
+    }
+
+    numMatches.fetchAndAddRelaxed(hits.numMatches);
+
+    QMutexLocker locker(&hitsMutex);
+    pendingHits.append(hits);
+
+    // One notification covers everything that piles up before the GUI gets to it
+    if (pendingHits.size() == 1)
+    {
+        QMetaObject::invokeMethod(this, "hitsReady", Qt::QueuedConnection);
+    }
+}
+
+
+/* Searches the raw bytes of a UTF-8 file for the query's UTF-8 bytes, CHUNK_SIZE bytes at a time
+ * so that canceling never waits for a whole file. Only the lines those are found on are decoded,
+ * to make sure of the match (e.g., that it's a whole word) and find its column.
+ */
+void FileSearch::searchBytes(const char *data, int length, FileHits &hits)
+{
+    const int overlap = qMax(0, byteMatcher.pattern().size() - 1);
+    FileListing listing;
+    int lineNumber = 1;
+    int countedUpTo = 0;
+    int position = 0;
+
+    while (position < length && !canceled.loadAcquire())
+    {
+        int windowEnd = qMin(length, position + CHUNK_SIZE + overlap);
+        int found = byteMatcher.indexIn(data, windowEnd, position);
+
+        if (found == -1)
+        {
+            // A match could start in the last few bytes of the window and end past it
+            position = windowEnd == length ? length : windowEnd - overlap;
+            continue;
+        }
+
+        int lineStart = startOfLine(data, found);
+        const char *newline = static_cast<const char*>(std::memchr(data + found, '\n', static_cast<size_t>(length - found)));
+        int lineEnd = newline ? static_cast<int>(newline - data) : length;
+
+        QVector<int> matches = textSearcher.findAll(QString::fromUtf8(data + lineStart, lineEnd - lineStart));
+
+        if (!matches.isEmpty())
+        {
+            lineNumber += countNewlines(data, countedUpTo, lineStart);
+            countedUpTo = lineStart;
+            addMatchedLine(data, length, {lineStart, lineEnd, lineNumber, matches.first() + 1, matches.size()}, listing);
+        }
+
+        position = lineEnd + 1;
+    }
+
+    collectHits(listing, hits);
+}
+
+
+/* Decodes a file with the given codec and searches it, one line at a time for a regular expression
+ * (see RegexSearcher), or a stretch of lines at a time for a plain query (see TextSearcher).
+ *
+ * The file is decoded CHUNK_SIZE bytes at a time, and only the lines that haven't been searched yet
+ * are kept, along with the CONTEXT_LINES lines before them. Lines are searched once the CONTEXT_LINES
+ * lines after them have been decoded too, so that every line is listed with its context. Canceling
+ * is checked for after every chunk (and every line of a regular expression).
+ *
+ * A line that runs on for more than CHUNK_SIZE characters is cut, and searched a piece at a time. The
+ * pieces overlap by one character less than a plain query, so no match is missed, but a regular
+ * expression (or whole word) is only matched within a piece.
+ */
+void FileSearch::searchText(QTextCodec *codec, const char *data, int length, FileHits &hits)
+{
+    QScopedPointer<QTextDecoder> decoder(codec->makeDecoder());
+    RegexSearcher *searcher = regex ? acquireRegexSearcher() : nullptr;
+    const int overlap = regex ? 0 : qMax(0, textSearcher.getQueryLength() - 1);
+    FileListing listing;
+
+    QString text;
+    int searchFrom = 0;     // Where the part of the text that hasn't been searched yet starts
+    int lineNumber = 1;     // The number of the line the text starts in
+    int columnOffset = 0;   // How much of that line came before the text, if it was cut
+    int offset = 0;
+
+    while (offset < length && !canceled.loadAcquire())
+    {
+        int numBytes = qMin(length - offset, static_cast<int>(CHUNK_SIZE));
+        text += decoder->toUnicode(data + offset, numBytes);
+        offset += numBytes;
+
+        const QChar *chars = text.constData();
+        int searchTo = text.length();
+        bool cut = false;
+
+        if (offset < length)
+        {
+            // Back from the line that hasn't been decoded in full, past the lines of context it needs
+            searchTo = startOfLine(chars, text.length());
+            for (int k = 0; k < CONTEXT_LINES && searchTo > 0; k++)
+            {
+                searchTo = startOfLine(chars, searchTo - 1);
+            }
+
+            // Decode more unless it's the line that hasn't been decoded in full that's too long
+            if (searchTo <= searchFrom)
+            {
+                if (text.length() - startOfLine(chars, text.length()) < CHUNK_SIZE)
+                {
+                    continue;
+                }
+
+                searchTo = text.length();
+                cut = true;
+            }
+        }
+
+        QVector<MatchedLine> matchedLines;
+        int number = lineNumber;
+        int countedUpTo = 0;
+
+        if (!regex)
+        {
+            for (int match : textSearcher.findAll(QString::fromRawData(chars + searchFrom, searchTo - searchFrom)))
+            {
+                match += searchFrom;
+
+                if (!matchedLines.isEmpty() && match < matchedLines.last().end)
+                {
+                    matchedLines.last().numMatches++;
+                    continue;
+                }
+
+                int lineStart = startOfLine(chars, match);
+                number += countNewlines(chars, countedUpTo, lineStart);
+                countedUpTo = lineStart;
+                int column = match - lineStart + 1 + (lineStart == 0 ? columnOffset : 0);
+                matchedLines.append({lineStart, endOfLine(chars, text.length(), match), number, column, 1});
+            }
+        }
+        else
+        {
+            RegexMatchBatch batch;
+            number += countNewlines(chars, 0, searchFrom);
+
+            for (int lineStart = searchFrom; lineStart < searchTo && !canceled.loadAcquire(); number++)
+            {
+                int lineEnd = endOfLine(chars, searchTo, lineStart);
+                int numBefore = batch.starts.size();
+
+                if (searcher->findInLine(QString::fromRawData(chars + lineStart, lineEnd - lineStart), lineStart, batch, false,
+                                         QDeadlineTimer(LINE_TIMEOUT)) != RegexSearcher::Searched)
+                {
+                    numSkippedLines.ref();
+                }
+
+                if (batch.starts.size() > numBefore)
+                {
+                    int column = batch.starts[numBefore] - lineStart + 1 + (lineStart == 0 ? columnOffset : 0);
+                    matchedLines.append({lineStart, endOfLine(chars, text.length(), lineStart), number, column, batch.starts.size() - numBefore});
+                }
+
+                lineStart = lineEnd + 1;
+            }
+        }
+
+        for (const MatchedLine &matched : matchedLines)
+        {
+            addMatchedLine(chars, text.length(), matched, listing);
+        }
+
+        // Keep the lines of context the next lines searched need, or the end of a query cut in half
+        int keepFrom = searchTo;
+        if (cut)
+        {
+            keepFrom = qMax(0, keepFrom - overlap);
+        }
+        else
+        {
+            for (int k = 0; k < CONTEXT_LINES && keepFrom > 0; k++)
+            {
+                keepFrom = startOfLine(chars, keepFrom - 1);
+            }
+        }
+
+        int numDroppedLines = countNewlines(chars, 0, keepFrom);
+        columnOffset = numDroppedLines == 0 ? columnOffset + keepFrom : keepFrom - startOfLine(chars, keepFrom);
+        lineNumber += numDroppedLines;
+        searchFrom = cut ? 0 : searchTo - keepFrom;
+        text.remove(0, keepFrom);
+    }
+
+    if (searcher)
+    {
+        releaseRegexSearcher(searcher);
+    }
+
+    collectHits(listing, hits);
+}
+
+
+/* Returns a RegexSearcher for the calling thread to use on its own until it gives it back.
+ * There are never more of them than there are threads searching at once.
+ */
+RegexSearcher *FileSearch::acquireRegexSearcher()
+{
+    QMutexLocker locker(&searchersMutex);
+
+    if (!idleSearchers.isEmpty())
+    {
+        return idleSearchers.takeLast();
+    }
+
+    locker.unlock();
+    return new RegexSearcher(query, caseSensitive, wholeWords);
+}
+
+
+/* Takes back a RegexSearcher from acquireRegexSearcher, for another task to use.
+ */
+void FileSearch::releaseRegexSearcher(RegexSearcher *searcher)
+{
+    QMutexLocker locker(&searchersMutex);
+    idleSearchers.append(searcher);
+}
+
+
+/* Called once every task has finished. Hands over any hits that are left and reports the search done.
+ */
+void FileSearch::on_walkDone()
+{
+    elapsedTime = timer.elapsed();
+
+    QMutexLocker locker(&hitsMutex);
+    bool hitsLeft = !pendingHits.isEmpty();
+    locker.unlock();
+
+    if (hitsLeft)
+    {
+        emit(hitsReady());
+    }
+
+    emit(done());
+}
@@ -0,0 +1,146 @@
+#ifndef FILESEARCH_H
+#define FILESEARCH_H
+#include "textsearcher.h"
+#include "regexsearcher.h"
+#include <QObject>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QByteArrayMatcher>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QMutex>
+#include <QVector>
+#include <QTextCodec>
+
+
+/* A line listed in a FileHits: either one with matches (column is that of the first of them)
+ * or one of the context lines around it (column is 0). Numbers start at 1.
+ */
+struct HitLine
+{
+    int number;
+    int column;
+    QString text;
+};
+
+
+/* What a FileSearch found in one file: the lines with matches (up to MAX_LISTED_LINES of them)
+ * and up to CONTEXT_LINES lines on either side of each, in order, without repeats.
+ */
+struct FileHits
+{
+    QString path;
+    int numMatches = 0;
+    QVector<HitLine> lines;
+};
+
+
+/* Searches every file under a directory at once, on a thread pool with a thread per core.
+ * Directories are walked in parallel too: each one is listed by its own task, which hands its
+ * subdirectories and files to the pool as tasks of their own.
+ *
+ * Files whose names match an exclude glob (as do directories, which aren't walked) or don't
+ * match any of the include globs (if there are any) are left out. Globs support * and ?.
+ * Binary files, which have a NUL byte in their first BINARY_SAMPLE_SIZE bytes without looking
+ * like UTF-16, are skipped, as are files over MAX_FILE_SIZE bytes.
+ *
+ * Each file is memory-mapped rather than read. A plain, case-sensitive query in a UTF-8 (or
+ * ASCII) file is searched for in the raw bytes, and only the lines it's found on are decoded.
+ * Anything else is decoded (see TextEncoding) and searched CHUNK_SIZE bytes at a time, so only
+ * about a chunk of text is held at once however big the file is, with TextSearcher or, for
+ * regular expressions, RegexSearcher. Since a RegexSearcher is never shared between threads, each thread
+ * borrows one of its own from a pool of them. A regular expression is given up on for any line
+ * it takes more than LINE_TIMEOUT milliseconds on. Canceling is checked for between chunks and
+ * lines, so it has to wait for one of those at most.
+ *
+ * Hits are handed over a file at a time: hitsReady is emitted whenever there are some waiting
+ * to be taken (see takeHits). Deleting a FileSearch cancels it, waiting for its tasks to stop.
+ */
+class FileSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileSearch(const QString &root, const QString &query, bool caseSensitive, bool wholeWords, bool regex,
+               const QStringList &includeGlobs, const QStringList &excludeGlobs, QObject *parent = nullptr);
+    ~FileSearch() override;
+
+    void start();
+    QVector<FileHits> takeHits();
+
+    inline QString getRoot() const { return root; }
+    inline int getNumFilesSearched() const { return numFilesSearched.loadAcquire(); }
+    inline int getNumSkippedFiles() const { return numSkippedFiles.loadAcquire(); }
+    inline int getNumUnreadableFiles() const { return numUnreadableFiles.loadAcquire(); }
+    inline int getNumSkippedLines() const { return numSkippedLines.loadAcquire(); }
+    inline int getNumMatches() const { return numMatches.loadAcquire(); }
+    inline qint64 getBytesSearched() const { return bytesSearched.loadAcquire(); }
+    inline int getNumThreads() const { return pool.maxThreadCount(); }
+    inline qint64 getElapsedTime() const { return elapsedTime == -1 ? timer.elapsed() : elapsedTime; }
+
+    static bool globMatches(const QString &glob, const QString &name);
+
+    const static int CONTEXT_LINES = 2;
+    const static int MAX_LISTED_LINES = 1000;
+    const static int BINARY_SAMPLE_SIZE = 8 * 1024;
+    const static qint64 MAX_FILE_SIZE = 1024LL * 1024 * 1024;
+    const static int LINE_TIMEOUT = 1000;
+    const static int CHUNK_SIZE = 16 * 1024 * 1024;
+
+signals:
+    void hitsReady();
+    void done();
+
+private slots:
+    void on_walkDone();
+
+private:
+    friend class DirectoryTask;
+    friend class FileTask;
+
+    void startTask(QRunnable *task);
+    void taskFinished();
+    void walkDirectory(const QString &path);
+    void searchFile(const QString &path);
+    void searchBytes(const char *data, int length, FileHits &hits);
+    void searchText(QTextCodec *codec, const char *data, int length, FileHits &hits);
+    bool matchesAny(const QStringList &globs, const QString &name) const;
+
+    RegexSearcher *acquireRegexSearcher();
+    void releaseRegexSearcher(RegexSearcher *searcher);
+
+    QString root;
+    QString query;
+    bool caseSensitive;
+    bool wholeWords;
+    bool regex;
+    QStringList includeGlobs;
+    QStringList excludeGlobs;
+
+    TextSearcher textSearcher;
+    QByteArrayMatcher byteMatcher;
+
+    QMutex searchersMutex;
+    QVector<RegexSearcher*> idleSearchers;
+
+    QMutex hitsMutex;
+    QVector<FileHits> pendingHits;
+
+    QThreadPool pool;
+    QAtomicInt pendingTasks;
+    QAtomicInt canceled;
+
+    QAtomicInt numFilesSearched;
+    QAtomicInt numSkippedFiles;
+    QAtomicInt numUnreadableFiles;
+    QAtomicInt numSkippedLines;
+    QAtomicInt numMatches;
+    QAtomicInteger<qint64> bytesSearched;
+
+    QElapsedTimer timer;
+    qint64 elapsedTime = -1;
+};
+
+#endif // FILESEARCH_H
@@ -0,0 +1,300 @@
+#include "fileviewer.h"
+#include "editor.h"
+#include "linenumberarea.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QFileInfo>
+#include <climits>
+
+
+/* Initializes this FileViewer with nothing to show.
+ */
+FileViewer::FileViewer(QWidget *parent) : QAbstractScrollArea(parent)
+{
+    qRegisterMetaType<LineIndex>("LineIndex");
+
+    font = QFont("Courier", Editor::DEFAULT_FONT_SIZE);
+    font.setStyleHint(QFont::Monospace);
+    font.setFixedPitch(true);
+    setFont(font);
+    setFocusPolicy(Qt::StrongFocus);
+
+    lineNumberArea = new LineNumberArea<FileViewer>(this);
+    updateLineNumberAreaWidth();
+    updateScrollBars();
+}
+
+
+/* Performs all necessary memory cleanup operations. Waits for the file to stop being indexed.
+ */
+FileViewer::~FileViewer()
+{
+    stopIndexing();
+    delete lineNumberArea;
+}
+
+
+/* Stops indexing the file's lines, waiting for the indexer to be done with the mapping.
+ */
+void FileViewer::stopIndexing()
+{
+    if (!indexer)
+    {
+        return;
+    }
+
+    indexer->requestInterruption();
+    indexer->wait();
+    delete indexer;
+    indexer = nullptr;
+}
+
+
+/* Maps the file at the given path and shows it from the top. Returns false
+ * on failure, in which case errorString() describes what went wrong.
+ */
+bool FileViewer::open(const QString &filePath)
+{
+    // Loading unmaps the file that was open before, which the indexer may still be reading
+    stopIndexing();
+
+    if (!storage.load(filePath))
+    {
+        return false;
+    }
+
+    indexer = new LineIndexer(storage.data(), storage.size(), ++indexGeneration);
+    connect(indexer, SIGNAL(progress(LineIndex, int)), this, SLOT(on_linesIndexed(LineIndex, int)));
+    indexer->start(QThread::LowPriority);
+
+    fileName = QFileInfo(filePath).fileName();
+    lastLineCountEstimate = 0;
+    widestLineSeen = 0;
+
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+    lineNumberArea->update();
+
+    return true;
+}
+
+
+/* Returns the number of lines that fit in the viewport, counting a partially visible last line.
+ */
+int FileViewer::numVisibleLines() const
+{
+    return viewport()->height() / fontMetrics().height() + 1;
+}
+
+
+/* Called when the indexer has indexed more of the file. Lines that were estimated can now be shown exactly.
+ */
+void FileViewer::on_linesIndexed(LineIndex index, int generation)
+{
+    if (generation != indexGeneration)
+    {
+        return;
+    }
+
+    storage.adoptLineIndex(index);
+    updateScrollBars();
+    updateLineNumberAreaWidth();
+    viewport()->update();
+    lineNumberArea->update();
+}
+
+
+/* Returns the position at which the first line in view starts, or -1 if it's past the end.
+ * Lines past what's been indexed are only estimated (see MappedFileStorage::estimatedLineStart),
+ * unless they're close enough to scan up to.
+ */
+qint64 FileViewer::firstVisibleLineStart(bool &estimated)
+{
+    qint64 line = verticalScrollBar()->value();
+    estimated = line > storage.linesIndexed() + MAX_SCANNED_LINES;
+
+    return estimated ? storage.estimatedLineStart(line) : storage.lineStart(line);
+}
+
+
+/* Returns the (possibly truncated) text of the line starting at the given position as it should be painted.
+ */
+QString FileViewer::displayTextAt(qint64 position)
+{
+    QByteArray bytes = storage.bytes(position, MAX_DISPLAYED_BYTES);
+    int lineBreak = bytes.indexOf('\n');
+
+    if (lineBreak != -1)
+    {
+        bytes.truncate(lineBreak > 0 && bytes.at(lineBreak - 1) == '\r' ? lineBreak - 1 : lineBreak);
+    }
+
+    QString text = QString::fromUtf8(bytes);
+    return text.replace('\t', QString(Editor::NUM_CHARS_FOR_TAB, ' '));
+}
+
+
+/* Paints the lines currently scrolled into view, and nothing else.
+ */
+void FileViewer::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+
+    int widestLineBefore = widestLineSeen;
+    int lineHeight = fontMetrics().height();
+    int left = -horizontalScrollBar()->value();
+    bool estimated;
+    qint64 lineStart = firstVisibleLineStart(estimated);
+
+    for (int row = 0; row < numVisibleLines() && lineStart != -1; row++, lineStart = storage.nextLineStart(lineStart))
+    {
+        int top = row * lineHeight;
+
+        if (top > event->rect().bottom())
+        {
+            break;
+        }
+
+        QString text = displayTextAt(lineStart);
+        painter.drawText(left, top + fontMetrics().ascent(), text);
+        widestLineSeen = qMax(widestLineSeen, fontMetrics().width(text));
+    }
+
+    // Painting may have revealed more of the file's lines, so refine the scroll range, but only
+    // once this paint is over: changing the range from here would schedule yet another paint
+    bool rangeChanged = widestLineSeen != widestLineBefore || storage.lineCountEstimate() != lastLineCountEstimate;
+
+    if (rangeChanged && !scrollBarsUpdatePending)
+    {
+        scrollBarsUpdatePending = true;
+        QMetaObject::invokeMethod(this, "updateScrollBars", Qt::QueuedConnection);
+    }
+}
+
+
+/* Called when the viewer is resized. Resizes the line number area and the scroll ranges accordingly.
+ */
+void FileViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+
+    QRect cr = contentsRect();
+    lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), getLineNumberAreaWidth(), cr.height()));
+    updateScrollBars();
+}
+
+
+/* Called when the viewer's font changes, which changes how many lines fit and how wide they are.
+ */
+void FileViewer::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+
+    // The constructor sets the font before there's a line number area to resize
+    if (event->type() == QEvent::FontChange && lineNumberArea)
+    {
+        widestLineSeen = 0;
+        updateLineNumberAreaWidth();
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+
+/* Called when either scroll bar moves. Everything is painted from the scroll bar
+ * positions, so all that's needed is a repaint.
+ */
+void FileViewer::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+
+    viewport()->update();
+    lineNumberArea->update();
+}
+
+
+/* Sets the scroll bar ranges from the (estimated) number of lines and the widest line painted so far.
+ * Called on open, resize and font changes, and after a paint that found more lines (see paintEvent).
+ */
+void FileViewer::updateScrollBars()
+{
+    scrollBarsUpdatePending = false;
+
+    qint64 lineCountEstimate = storage.lineCountEstimate();
+    int visibleLines = numVisibleLines();
+
+    qint64 lastTopLine = qBound(qint64(0), lineCountEstimate - visibleLines + 1, qint64(INT_MAX));
+    verticalScrollBar()->setPageStep(visibleLines);
+    verticalScrollBar()->setRange(0, static_cast<int>(lastTopLine));
+
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, widestLineSeen - viewport()->width()));
+
+    if (lineCountEstimate != lastLineCountEstimate)
+    {
+        lastLineCountEstimate = lineCountEstimate;
+        updateLineNumberAreaWidth();
+    }
+}
+
+
+/* -----------------------------------------------------------
+ * All functions below this line are used for lineNumberArea
+ * -----------------------------------------------------------
+ */
+
+
+/* Returns the width of the line number area, based on the number of digits in the
+ * (estimated) last line number, plus room for the ~ of estimated line numbers while
+ * there can be any (see firstVisibleLineStart). See Editor::getLineNumberAreaWidth.
+ */
+int FileViewer::getLineNumberAreaWidth()
+{
+    int numDigitsInLastLine = QString::number(qMax(lastLineCountEstimate, qint64(1))).length();
+    int maxWidthOfAnyDigit = fontMetrics().width(QLatin1Char('9'));
+    int estimateMarkWidth = lastLineCountEstimate > storage.linesIndexed() + MAX_SCANNED_LINES ? fontMetrics().width(QLatin1Char('~')) : 0;
+    return numDigitsInLastLine * maxWidthOfAnyDigit + estimateMarkWidth + lineNumberAreaPadding;
+}
+
+
+/* Sets the left margin of the viewport so that it leaves room for the widest line number.
+ */
+void FileViewer::updateLineNumberAreaWidth()
+{
+    setViewportMargins(getLineNumberAreaWidth() + lineNumberAreaPadding, 0, 0, 0);
+
+    QRect cr = contentsRect();
+    lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), getLineNumberAreaWidth(), cr.height()));
+}
+
+
+/* See linenumberarea.h for the call. Paints the numbers of the lines currently in view,
+ * marked with a ~ if they're estimates (see firstVisibleLineStart).
+ */
+void FileViewer::lineNumberAreaPaintEvent(QPaintEvent *event)
+{
+    QPainter painter(lineNumberArea);
+    painter.setPen(Qt::black);
+
+    int lineHeight = fontMetrics().height();
+    qint64 firstVisibleLine = verticalScrollBar()->value();
+    bool estimated;
+    qint64 lineStart = firstVisibleLineStart(estimated);
+
+    for (int row = 0; row < numVisibleLines() && lineStart != -1; row++, lineStart = storage.nextLineStart(lineStart))
+    {
+        int top = row * lineHeight;
+
+        if (top > event->rect().bottom())
+        {
+            break;
+        }
+
+        QString number = QString::number(firstVisibleLine + row + 1);
+        painter.drawText(0, top, lineNumberArea->width(), lineHeight, Qt::AlignRight, estimated ? "~" + number : number);
+    }
+}
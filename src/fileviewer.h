@@ -0,0 +1,70 @@
+#ifndef FILEVIEWER_H
+#define FILEVIEWER_H
+#include "storage/mappedfilestorage.h"
+#include "storage/lineindexer.h"
+#include <QAbstractScrollArea>
+#include <QFont>
+
+
+/* Read-only view of a file that may be far too large for an Editor. The file is
+ * memory-mapped (see MappedFileStorage) and only the lines currently on screen are ever
+ * decoded and painted, so opening and scrolling cost the same no matter how big
+ * the file is. No QTextDocument is involved.
+ *
+ * The file's lines are indexed in the background (see LineIndexer). Scrolling to a line
+ * past what's been indexed shows roughly where that line would be instead of scanning up
+ * to it, with its line numbers marked as estimates, until the index catches up.
+ */
+class FileViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit FileViewer(QWidget *parent = nullptr);
+    ~FileViewer() override;
+
+    bool open(const QString &filePath);
+    inline QString errorString() const { return storage.errorString(); }
+    inline QString getFileName() const { return fileName; }
+
+    void lineNumberAreaPaintEvent(QPaintEvent *event);
+    int getLineNumberAreaWidth();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void changeEvent(QEvent *event) override;
+
+private slots:
+    void updateScrollBars();
+    void on_linesIndexed(LineIndex index, int generation);
+
+private:
+    void updateLineNumberAreaWidth();
+    int numVisibleLines() const;
+    qint64 firstVisibleLineStart(bool &estimated);
+    QString displayTextAt(qint64 position);
+    void stopIndexing();
+
+    MappedFileStorage storage;
+    LineIndexer *indexer = nullptr;
+    int indexGeneration = 0;
+    QString fileName;
+    QFont font;
+
+    QWidget *lineNumberArea = nullptr;
+    const int lineNumberAreaPadding = 30;
+
+    qint64 lastLineCountEstimate = 0;
+    int widestLineSeen = 0;
+    bool scrollBarsUpdatePending = false;
+
+    // Anything past this many bytes of a single line is not displayed
+    const static int MAX_DISPLAYED_BYTES = 4096;
+
+    // Lines this far past the index are still found exactly, by scanning up to them
+    const static int MAX_SCANNED_LINES = 10000;
+};
+
+#endif // FILEVIEWER_H
@@ -18,8 +18,17 @@ FindDialog::FindDialog(QWidget *parent)
     setWindowTitle(tr("Find and Replace"));
 
     connect(findNextButton, SIGNAL(clicked()), this, SLOT(on_findNextButton_clicked()));
+    connect(findAllButton, SIGNAL(clicked()), this, SLOT(on_findNextButton_clicked()));
     connect(replaceButton, SIGNAL(clicked()), this, SLOT(on_replaceOperation_initiated()));
     connect(replaceAllButton, SIGNAL(clicked()), this, SLOT(on_replaceOperation_initiated()));
+    connect(findInTabsButton, SIGNAL(clicked()), this, SLOT(on_findNextButton_clicked()));
+    connect(replaceInTabsButton, SIGNAL(clicked()), this, SLOT(on_replaceOperation_initiated()));
+
+    // A search that's still running is for a query the user no longer wants
+    connect(findLineEdit, SIGNAL(textEdited(QString)), this, SIGNAL(queryChanged()));
+    connect(caseSensitiveCheckBox, SIGNAL(toggled(bool)), this, SIGNAL(queryChanged()));
+    connect(wholeWordsCheckBox, SIGNAL(toggled(bool)), this, SIGNAL(queryChanged()));
+    connect(regexCheckBox, SIGNAL(toggled(bool)), this, SIGNAL(queryChanged()));
 }
 
 
@@ -29,16 +38,22 @@ FindDialog::~FindDialog()
 {
     delete findLabel;
     delete replaceLabel;
+    delete statusLabel;
     delete findLineEdit;
     delete replaceLineEdit;
     delete findNextButton;
+    delete findAllButton;
     delete replaceButton;
     delete replaceAllButton;
+    delete findInTabsButton;
+    delete replaceInTabsButton;
     delete caseSensitiveCheckBox;
     delete wholeWordsCheckBox;
+    delete regexCheckBox;
     delete findHorizontalLayout;
     delete replaceHorizontalLayout;
     delete optionsLayout;
+    delete scopeLayout;
     delete verticalLayout;
 }
 
@@ -49,13 +64,18 @@ void FindDialog::initializeWidgets()
 {
     findLabel = new QLabel(tr("Find what:    "));
     replaceLabel = new QLabel(tr("Replace with:"));
+    statusLabel = new QLabel();
     findLineEdit = new QLineEdit();
     replaceLineEdit = new QLineEdit();
     findNextButton = new QPushButton(tr("&Find next"));
+    findAllButton = new QPushButton(tr("Find &all"));
     replaceButton = new QPushButton(tr("&Replace"));
     replaceAllButton = new QPushButton(tr("&Replace all"));
+    findInTabsButton = new QPushButton(tr("Find in &open tabs"));
+    replaceInTabsButton = new QPushButton(tr("Replace in open ta&bs"));
     caseSensitiveCheckBox = new QCheckBox(tr("&Match case"));
     wholeWordsCheckBox = new QCheckBox(tr("&Whole words"));
+    regexCheckBox = new QCheckBox(tr("Regular e&xpression"));
 }
 
 
@@ -67,11 +87,14 @@ void FindDialog::initializeLayout()
     findHorizontalLayout = new QHBoxLayout();
     replaceHorizontalLayout = new QHBoxLayout();
     optionsLayout = new QHBoxLayout();
+    scopeLayout = new QHBoxLayout();
     verticalLayout = new QVBoxLayout();
 
     verticalLayout->addLayout(findHorizontalLayout);
     verticalLayout->addLayout(replaceHorizontalLayout);
     verticalLayout->addLayout(optionsLayout);
+    verticalLayout->addLayout(scopeLayout);
+    verticalLayout->addWidget(statusLabel);
 
     findHorizontalLayout->addWidget(findLabel);
     findHorizontalLayout->addWidget(findLineEdit);
@@ -80,16 +103,24 @@ void FindDialog::initializeLayout()
 
     optionsLayout->addWidget(caseSensitiveCheckBox);
     optionsLayout->addWidget(wholeWordsCheckBox);
+    optionsLayout->addWidget(regexCheckBox);
     optionsLayout->addWidget(findNextButton);
+    optionsLayout->addWidget(findAllButton);
     optionsLayout->addWidget(replaceButton);
     optionsLayout->addWidget(replaceAllButton);
 
+    scopeLayout->addStretch();
+    scopeLayout->addWidget(findInTabsButton);
+    scopeLayout->addWidget(replaceInTabsButton);
+
     setLayout(verticalLayout);
 }
 
 
-/* Called when the user clicks the Find Next button. If the query is empty, it informs the user.
- * Otherwise, it emits an appropriate signal for startFinding with all relevant search criteria.
+/* Called when the user clicks the Find Next, Find All or Find in Open Tabs button. If the query is empty, it
+ * informs the user. Otherwise, it emits the appropriate signal (startFinding, startFindingAll or
+ * startFindingInTabs, respectively) with all relevant search criteria. With Regular Expression checked, the query is a QRegularExpression pattern
+ * and the replacement may refer to its groups (see RegexSearcher).
  */
 void FindDialog::on_findNextButton_clicked()
 {
@@ -103,13 +134,26 @@ void FindDialog::on_findNextButton_clicked()
 
     bool caseSensitive = caseSensitiveCheckBox->isChecked();
     bool wholeWords = wholeWordsCheckBox->isChecked();
-    emit(startFinding(query, caseSensitive, wholeWords));
+    bool regex = regexCheckBox->isChecked();
+
+    if (sender() == findAllButton)
+    {
+        emit(startFindingAll(query, caseSensitive, wholeWords, regex));
+    }
+    else if (sender() == findInTabsButton)
+    {
+        emit(startFindingInTabs(query, caseSensitive, wholeWords, regex));
+    }
+    else
+    {
+        emit(startFinding(query, caseSensitive, wholeWords, regex));
+    }
 }
 
 
-/* Called when the user clicks the Replace or Replace All button. Emits the appropriate
- * signal (startReplacing or startReplacingAll, respectively), passing along all relevant
- * search and replace information.
+/* Called when the user clicks the Replace, Replace All or Replace in Open Tabs button. Emits the
+ * appropriate signal (startReplacing, startReplacingAll or startReplacingInTabs, respectively),
+ * passing along all relevant search and replace information.
  */
 void FindDialog::on_replaceOperation_initiated()
 {
@@ -124,15 +168,20 @@ void FindDialog::on_replaceOperation_initiated()
     QString with = replaceLineEdit->text();
     bool caseSensitive = caseSensitiveCheckBox->isChecked();
     bool wholeWords = wholeWordsCheckBox->isChecked();
+    bool regex = regexCheckBox->isChecked();
     bool replace = sender() == replaceButton;
 
     if (replace)
     {
-        emit(startReplacing(what, with, caseSensitive, wholeWords));
+        emit(startReplacing(what, with, caseSensitive, wholeWords, regex));
+    }
+    else if (sender() == replaceInTabsButton)
+    {
+        emit(startReplacingInTabs(what, with, caseSensitive, wholeWords, regex));
     }
     else
     {
-        emit(startReplacingAll(what, with, caseSensitive, wholeWords));
+        emit(startReplacingAll(what, with, caseSensitive, wholeWords, regex));
     }
 
 }
@@ -20,15 +20,20 @@ public:
 
 signals:
 
-    void startFinding(QString queryText, bool caseSensitive, bool wholeWords);
-    void startReplacing(QString what, QString with, bool caseSensitive, bool wholeWords);
-    void startReplacingAll(QString what, QString with, bool caseSensitive, bool wholeWords);
+    void startFinding(QString queryText, bool caseSensitive, bool wholeWords, bool regex);
+    void startFindingAll(QString queryText, bool caseSensitive, bool wholeWords, bool regex);
+    void startReplacing(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex);
+    void startReplacingAll(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex);
+    void startFindingInTabs(QString queryText, bool caseSensitive, bool wholeWords, bool regex);
+    void startReplacingInTabs(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex);
+    void queryChanged();
 
 public slots:
 
     void on_findNextButton_clicked();
     void on_replaceOperation_initiated();
     void onFindResultReady(QString message) { QMessageBox::information(this, "Find and Replace", message); }
+    void onSearchProgress(QString message) { statusLabel->setText(message); }
 
 private:
 
@@ -37,17 +42,23 @@ private:
 
     QLabel *findLabel;
     QLabel *replaceLabel;
+    QLabel *statusLabel;
     QPushButton *findNextButton;
+    QPushButton *findAllButton;
     QPushButton *replaceButton;
     QPushButton *replaceAllButton;
+    QPushButton *findInTabsButton;
+    QPushButton *replaceInTabsButton;
     QLineEdit *findLineEdit;
     QLineEdit *replaceLineEdit;
     QCheckBox *caseSensitiveCheckBox;
     QCheckBox *wholeWordsCheckBox;
+    QCheckBox *regexCheckBox;
 
     QHBoxLayout *findHorizontalLayout;
     QHBoxLayout *replaceHorizontalLayout;
     QHBoxLayout *optionsLayout;
+    QHBoxLayout *scopeLayout;
     QVBoxLayout *verticalLayout;
 };
 
@@ -0,0 +1,163 @@
+#include "findinfilesmodel.h"
+#include <QDir>
+#include <QBrush>
+#include <QPalette>
+#include <QApplication>
+
+
+/* Initializes this FindInFilesModel, empty.
+ */
+FindInFilesModel::FindInFilesModel(QObject *parent) : QAbstractListModel(parent)
+{
+}
+
+
+/* Removes every row, ready for the results of a search under the given directory.
+ * File names are shown relative to that directory.
+ */
+void FindInFilesModel::clear(const QString &root)
+{
+    beginResetModel();
+    this->root = root;
+    files.clear();
+    rows.clear();
+    endResetModel();
+}
+
+
+/* Adds rows for the given files' hits to the end of the list.
+ */
+void FindInFilesModel::append(const QVector<FileHits> &hits)
+{
+    QVector<Row> newRows;
+
+    for (int f = 0; f < hits.size(); f++)
+    {
+        const FileHits &fileHits = hits[f];
+        int file = files.size() + f;
+        int lastLine = 0;
+
+        newRows.append({file, -1, FileRow});
+
+        for (int i = 0; i < fileHits.lines.size(); i++)
+        {
+            if (lastLine != 0 && fileHits.lines[i].number > lastLine + 1)
+            {
+                newRows.append({file, -1, GapRow});
+            }
+
+            newRows.append({file, i, LineRow});
+            lastLine = fileHits.lines[i].number;
+        }
+    }
+
+    if (newRows.isEmpty())
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + newRows.size() - 1);
+    files += hits;
+    rows += newRows;
+    endInsertRows();
+}
+
+
+/* Sets the path, line, and column the given row refers to, and returns true, unless it's a gap.
+ * A file's own row refers to its first match.
+ */
+bool FindInFilesModel::locationOf(const QModelIndex &index, QString &path, int &line, int &column) const
+{
+    if (!index.isValid() || index.row() >= rows.size())
+    {
+        return false;
+    }
+
+    const Row &row = rows[index.row()];
+    const FileHits &fileHits = files[row.file];
+
+    if (row.type == GapRow)
+    {
+        return false;
+    }
+
+    const HitLine *hitLine = nullptr;
+
+    if (row.type == LineRow)
+    {
+        hitLine = &fileHits.lines[row.line];
+    }
+    else
+    {
+        for (const HitLine &listed : fileHits.lines)
+        {
+            if (listed.column != 0)
+            {
+                hitLine = &listed;
+                break;
+            }
+        }
+    }
+
+    path = fileHits.path;
+    line = hitLine ? hitLine->number : 1;
+    column = hitLine && hitLine->column != 0 ? hitLine->column : 1;
+    return true;
+}
+
+
+/* Returns the number of rows; there are no children.
+ */
+int FindInFilesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+
+/* Makes a row's text as it's drawn. Lines with matches are numbered as "12: ..." and context
+ * lines as "12- ...", like grep does, and context lines are grayed out.
+ */
+QVariant FindInFilesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size())
+    {
+        return QVariant();
+    }
+
+    const Row &row = rows[index.row()];
+    const FileHits &fileHits = files[row.file];
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (row.type)
+        {
+            case FileRow:
+                // One multi-arg call, so a %1 in the path isn't taken for a placeholder
+                return QString("%1 (%2)").arg(QDir(root).relativeFilePath(fileHits.path), QString::number(fileHits.numMatches));
+
+            case GapRow:
+                return QString("    ...");
+
+            case LineRow:
+            {
+                const HitLine &hitLine = fileHits.lines[row.line];
+                QString separator = hitLine.column != 0 ? ": " : "- ";
+                QString text = hitLine.text;
+
+                // Tabs and carriage returns would throw off the uniform rows
+                text.replace('\t', "    ").remove('\r');
+                return QString("%1%2%3").arg(QString::number(hitLine.number).rightJustified(6), separator, text);
+            }
+        }
+    }
+    else if (role == Qt::ForegroundRole && row.type != FileRow && (row.type == GapRow || fileHits.lines[row.line].column == 0))
+    {
+        return QApplication::palette().brush(QPalette::Disabled, QPalette::Text);
+    }
+    else if (role == Qt::ToolTipRole && row.type == FileRow)
+    {
+        return QDir::toNativeSeparators(fileHits.path);
+    }
+
+    return QVariant();
+}
@@ -0,0 +1,44 @@
+#ifndef FINDINFILESMODEL_H
+#define FINDINFILESMODEL_H
+#include "filesearch.h"
+#include <QAbstractListModel>
+#include <QVector>
+#include <QString>
+
+
+/* The results of a Find in Files, as one flat list: a row for each file with hits, then a row for
+ * each of its listed lines, with a "..." row wherever lines are skipped. Rows only point into the
+ * hits, and their text is made as they're drawn, so a QListView with uniform item sizes can show
+ * any number of them without creating a widget or an item per row.
+ */
+class FindInFilesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    FindInFilesModel(QObject *parent = nullptr);
+
+    void clear(const QString &root);
+    void append(const QVector<FileHits> &hits);
+    bool locationOf(const QModelIndex &index, QString &path, int &line, int &column) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    enum RowType { FileRow, LineRow, GapRow };
+
+    // Which file a row is in and, for a LineRow, which of the file's listed lines it is
+    struct Row
+    {
+        int file;
+        int line;
+        RowType type;
+    };
+
+    QString root;
+    QVector<FileHits> files;
+    QVector<Row> rows;
+};
+
+#endif // FINDINFILESMODEL_H
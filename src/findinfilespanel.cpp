@@ -0,0 +1,312 @@
+#include "findinfilespanel.h"
+#include "editor.h"
+#include "regexsearcher.h"
+#include <QFileDialog>
+#include <QDir>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QRegularExpression>
+
+
+/* Initializes this FindInFilesPanel, with the directory and globs it was last used with.
+ */
+FindInFilesPanel::FindInFilesPanel(QWidget *parent) : QDockWidget(tr("Find in Files"), parent)
+{
+    setObjectName("findInFilesPanel");
+
+    contents = new QWidget();
+    layout = new QVBoxLayout();
+    fieldsLayout = new QGridLayout();
+    optionsLayout = new QHBoxLayout();
+
+    queryLabel = new QLabel(tr("Find what:"));
+    queryLineEdit = new QLineEdit();
+    directoryLabel = new QLabel(tr("In folder:"));
+    directoryLineEdit = new QLineEdit(settings->value(DIRECTORY_KEY).toString());
+    browseButton = new QPushButton(tr("&Browse..."));
+    includeLabel = new QLabel(tr("Include:"));
+    includeLineEdit = new QLineEdit(settings->value(INCLUDE_KEY).toString());
+    excludeLabel = new QLabel(tr("Exclude:"));
+    excludeLineEdit = new QLineEdit(settings->value(EXCLUDE_KEY, DEFAULT_EXCLUDE).toString());
+
+    includeLineEdit->setPlaceholderText(tr("All files, or e.g. *.cpp, *.h"));
+    excludeLineEdit->setPlaceholderText(tr("Nothing, or e.g. .git, build"));
+
+    fieldsLayout->addWidget(queryLabel, 0, 0);
+    fieldsLayout->addWidget(queryLineEdit, 0, 1, 1, 2);
+    fieldsLayout->addWidget(directoryLabel, 1, 0);
+    fieldsLayout->addWidget(directoryLineEdit, 1, 1);
+    fieldsLayout->addWidget(browseButton, 1, 2);
+    fieldsLayout->addWidget(includeLabel, 2, 0);
+    fieldsLayout->addWidget(includeLineEdit, 2, 1, 1, 2);
+    fieldsLayout->addWidget(excludeLabel, 3, 0);
+    fieldsLayout->addWidget(excludeLineEdit, 3, 1, 1, 2);
+
+    caseSensitiveCheckBox = new QCheckBox(tr("Match &case"));
+    wholeWordsCheckBox = new QCheckBox(tr("&Whole words"));
+    regexCheckBox = new QCheckBox(tr("Regular e&xpression"));
+    searchButton = new QPushButton(tr("&Find"));
+
+    optionsLayout->addWidget(caseSensitiveCheckBox);
+    optionsLayout->addWidget(wholeWordsCheckBox);
+    optionsLayout->addWidget(regexCheckBox);
+    optionsLayout->addStretch();
+    optionsLayout->addWidget(searchButton);
+
+    summaryLabel = new QLabel();
+    model = new FindInFilesModel(this);
+    resultsView = new QListView();
+    resultsView->setModel(model);
+
+    // Every row is the same height, so the view never has to measure rows that are off screen
+    resultsView->setUniformItemSizes(true);
+    resultsView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    QFont font("Courier", Editor::DEFAULT_FONT_SIZE);
+    font.setStyleHint(QFont::Monospace);
+    font.setFixedPitch(true);
+    resultsView->setFont(font);
+
+    layout->addLayout(fieldsLayout);
+    layout->addLayout(optionsLayout);
+    layout->addWidget(summaryLabel);
+    layout->addWidget(resultsView);
+    contents->setLayout(layout);
+    setWidget(contents);
+
+    connect(browseButton, SIGNAL(clicked()), this, SLOT(on_browseButtonClicked()));
+    connect(searchButton, SIGNAL(clicked()), this, SLOT(on_searchButtonClicked()));
+    connect(queryLineEdit, SIGNAL(returnPressed()), this, SLOT(startSearch()));
+    connect(resultsView, SIGNAL(activated(QModelIndex)), this, SLOT(on_resultActivated(QModelIndex)));
+}
+
+
+/* Performs all required memory cleanup operations. Stops the search, if one is running.
+ */
+FindInFilesPanel::~FindInFilesPanel()
+{
+    delete search;
+
+    delete queryLabel;
+    delete queryLineEdit;
+    delete directoryLabel;
+    delete directoryLineEdit;
+    delete browseButton;
+    delete includeLabel;
+    delete includeLineEdit;
+    delete excludeLabel;
+    delete excludeLineEdit;
+    delete caseSensitiveCheckBox;
+    delete wholeWordsCheckBox;
+    delete regexCheckBox;
+    delete searchButton;
+    delete summaryLabel;
+    delete resultsView;
+    delete optionsLayout;
+    delete fieldsLayout;
+    delete layout;
+    delete contents;
+}
+
+
+/* Sets the directory to search under.
+ */
+void FindInFilesPanel::setDirectory(const QString &directory)
+{
+    directoryLineEdit->setText(QDir::toNativeSeparators(directory));
+}
+
+
+/* Gives the query field focus, with its text selected so it can be typed over.
+ */
+void FindInFilesPanel::focusQuery()
+{
+    queryLineEdit->setFocus();
+    queryLineEdit->selectAll();
+}
+
+
+/* Called when the user clicks Browse. Lets them pick the directory to search under.
+ */
+void FindInFilesPanel::on_browseButtonClicked()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Find in Folder"), directoryLineEdit->text());
+
+    // Don't do anything if the user hit Cancel
+    if (!directory.isNull())
+    {
+        setDirectory(directory);
+    }
+}
+
+
+/* Called when the user clicks Find, which reads Stop while a search is running.
+ */
+void FindInFilesPanel::on_searchButtonClicked()
+{
+    if (search)
+    {
+        stopSearch();
+    }
+    else
+    {
+        startSearch();
+    }
+}
+
+
+/* Splits the given globs at commas and semicolons, leaving out the blanks.
+ */
+QStringList FindInFilesPanel::splitGlobs(const QString &globs)
+{
+    QStringList split;
+
+    for (const QString &glob : globs.split(QRegularExpression("[,;]")))
+    {
+        if (!glob.trimmed().isEmpty())
+        {
+            split.append(glob.trimmed());
+        }
+    }
+
+    return split;
+}
+
+
+/* Starts searching the directory for the query, stopping the previous search first.
+ */
+void FindInFilesPanel::startSearch()
+{
+    QString query = queryLineEdit->text();
+    QString directory = QDir::fromNativeSeparators(directoryLineEdit->text().trimmed());
+
+    if (query.isEmpty())
+    {
+        QMessageBox::information(this, "Empty field", "The search field cannot be empty.");
+        return;
+    }
+
+    if (directory.isEmpty() || !QFileInfo(directory).isDir())
+    {
+        QMessageBox::warning(this, "Warning", "Cannot search in folder: " + QDir::toNativeSeparators(directory));
+        return;
+    }
+
+    if (regexCheckBox->isChecked())
+    {
+        RegexSearcher searcher(query, caseSensitiveCheckBox->isChecked(), wholeWordsCheckBox->isChecked());
+
+        if (!searcher.isValid())
+        {
+            QMessageBox::warning(this, "Warning", "Invalid regular expression: " + searcher.getErrorString());
+            return;
+        }
+    }
+
+    stopSearch();
+
+    settings->setValue(DIRECTORY_KEY, directoryLineEdit->text());
+    settings->setValue(INCLUDE_KEY, includeLineEdit->text());
+    settings->setValue(EXCLUDE_KEY, excludeLineEdit->text());
+
+    search = new FileSearch(directory, query, caseSensitiveCheckBox->isChecked(), wholeWordsCheckBox->isChecked(),
+                            regexCheckBox->isChecked(), splitGlobs(includeLineEdit->text()), splitGlobs(excludeLineEdit->text()));
+
+    connect(search, SIGNAL(hitsReady()), this, SLOT(on_hitsReady()));
+    connect(search, SIGNAL(done()), this, SLOT(on_searchDone()));
+
+    model->clear(directory);
+    numFilesWithHits = 0;
+    searchButton->setText(tr("&Stop"));
+    summaryLabel->setText("Searching...");
+    search->start();
+}
+
+
+/* Stops the search that's running, if any, keeping whatever it has listed so far.
+ */
+void FindInFilesPanel::stopSearch()
+{
+    if (!search)
+    {
+        return;
+    }
+
+    // Waits for the files being searched to be done with, which doesn't take long
+    FileSearch *stopped = search;
+    search = nullptr;
+    delete stopped;
+
+    searchButton->setText(tr("&Find"));
+    summaryLabel->setText(summaryLabel->text() + " Stopped.");
+}
+
+
+/* Called whenever the search has found hits in more files. Lists them.
+ */
+void FindInFilesPanel::on_hitsReady()
+{
+    if (!search)
+    {
+        return;
+    }
+
+    QVector<FileHits> hits = search->takeHits();
+    numFilesWithHits += hits.size();
+    model->append(hits);
+    showSummary();
+}
+
+
+/* Called once every file has been searched.
+ */
+void FindInFilesPanel::on_searchDone()
+{
+    showSummary();
+    search->deleteLater();
+    search = nullptr;
+    searchButton->setText(tr("&Find"));
+}
+
+
+/* Shows how far the search has gotten, or what it found once it's done.
+ */
+void FindInFilesPanel::showSummary()
+{
+    double megabytes = search->getBytesSearched() / (1024.0 * 1024.0);
+    QString summary = QString("%1 matches in %2 files. Searched %3 files (%4 MB) in %5 ms on %6 threads.")
+            .arg(search->getNumMatches()).arg(numFilesWithHits).arg(search->getNumFilesSearched())
+            .arg(megabytes, 0, 'f', 1).arg(search->getElapsedTime()).arg(search->getNumThreads());
+
+    if (search->getNumSkippedFiles() > 0)
+    {
+        summary += QString(" Skipped %1 binary or oversized files.").arg(search->getNumSkippedFiles());
+    }
+
+    if (search->getNumUnreadableFiles() > 0)
+    {
+        summary += QString(" Could not read %1 files.").arg(search->getNumUnreadableFiles());
+    }
+
+    if (search->getNumSkippedLines() > 0)
+    {
+        summary += QString(" Skipped %1 lines that took too long to search.").arg(search->getNumSkippedLines());
+    }
+
+    summaryLabel->setText(summary);
+}
+
+
+/* Called when the user activates a listed line (or a file, which stands for its first match).
+ */
+void FindInFilesPanel::on_resultActivated(const QModelIndex &index)
+{
+    QString path;
+    int line;
+    int column;
+
+    if (model->locationOf(index, path, line, column))
+    {
+        emit(fileHitActivated(path, line, column));
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef FINDINFILESPANEL_H
+#define FINDINFILESPANEL_H
+#include "filesearch.h"
+#include "findinfilesmodel.h"
+#include "settings.h"
+#include <QDockWidget>
+#include <QListView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+
+/* Searches every file under a directory (see FileSearch) and lists the hits as they come in,
+ * with a couple of lines of context around each (see FindInFilesModel). Activating a listed
+ * line (double-clicking it, or pressing Enter on it) emits fileHitActivated with where it is.
+ *
+ * The directory and the globs are remembered between runs. Globs are separated by commas or
+ * semicolons, e.g. "*.cpp, *.h".
+ */
+class FindInFilesPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    FindInFilesPanel(QWidget *parent = nullptr);
+    ~FindInFilesPanel() override;
+
+    void setDirectory(const QString &directory);
+    inline QString getDirectory() const { return directoryLineEdit->text(); }
+    void focusQuery();
+
+signals:
+    void fileHitActivated(QString path, int line, int column);
+
+public slots:
+    void startSearch();
+    void stopSearch();
+
+private slots:
+    void on_browseButtonClicked();
+    void on_searchButtonClicked();
+    void on_hitsReady();
+    void on_searchDone();
+    void on_resultActivated(const QModelIndex &index);
+
+private:
+    static QStringList splitGlobs(const QString &globs);
+    void showSummary();
+
+    QWidget *contents;
+    QVBoxLayout *layout;
+    QGridLayout *fieldsLayout;
+    QHBoxLayout *optionsLayout;
+
+    QLabel *queryLabel;
+    QLineEdit *queryLineEdit;
+    QLabel *directoryLabel;
+    QLineEdit *directoryLineEdit;
+    QPushButton *browseButton;
+    QLabel *includeLabel;
+    QLineEdit *includeLineEdit;
+    QLabel *excludeLabel;
+    QLineEdit *excludeLineEdit;
+
+    QCheckBox *caseSensitiveCheckBox;
+    QCheckBox *wholeWordsCheckBox;
+    QCheckBox *regexCheckBox;
+    QPushButton *searchButton;
+
+    QLabel *summaryLabel;
+    QListView *resultsView;
+    FindInFilesModel *model;
+
+    FileSearch *search = nullptr;
+    int numFilesWithHits = 0;
+    Settings *settings = Settings::instance();
+
+    const QString DIRECTORY_KEY = "find_in_files_directory";
+    const QString INCLUDE_KEY = "find_in_files_include";
+    const QString EXCLUDE_KEY = "find_in_files_exclude";
+    const QString DEFAULT_EXCLUDE = ".git, .svn, .hg, node_modules";
+};
+
+#endif // FINDINFILESPANEL_H
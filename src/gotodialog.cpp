@@ -6,8 +6,9 @@
  */
 GotoDialog::GotoDialog(QWidget *parent) : QDialog(parent)
 {
-    gotoLabel = new QLabel(tr("Line: "));
+    gotoLabel = new QLabel(tr("Go to: "));
     gotoLineEdit = new QLineEdit();
+    gotoLineEdit->setPlaceholderText(tr("line[:column], @offset or percent%"));
     gotoButton = new QPushButton("Go");
     layout = new QHBoxLayout();
 
@@ -36,17 +37,50 @@ GotoDialog::~GotoDialog()
 }
 
 
-/* Called when the user clicks the Go button.
+/* Called when the user clicks the Go button. Accepts a line number optionally followed by
+ * a column (12 or 12:5), a byte offset into the file (@1024), or a percentage of the way
+ * through the file (50%).
  */
 void GotoDialog::on_gotoButton_clicked()
 {
-    QString line = gotoLineEdit->text();
+    QString target = gotoLineEdit->text().trimmed();
+    bool isNumber = false;
 
-    if (line.isEmpty())
+    if (target.endsWith('%'))
     {
-        QMessageBox::information(this, tr("Go"), tr("Must enter a line number."));
-        return;
+        int percent = target.left(target.length() - 1).toInt(&isNumber);
+        if (isNumber)
+        {
+            emit(gotoPercent(percent));
+            return;
+        }
+    }
+    else if (target.startsWith('@'))
+    {
+        qint64 byteOffset = target.mid(1).toLongLong(&isNumber);
+        if (isNumber)
+        {
+            emit(gotoOffset(byteOffset));
+            return;
+        }
+    }
+    else
+    {
+        QStringList lineAndColumn = target.split(':');
+        int line = lineAndColumn[0].toInt(&isNumber);
+        int column = 1;
+
+        if (isNumber && lineAndColumn.size() == 2)
+        {
+            column = lineAndColumn[1].toInt(&isNumber);
+        }
+
+        if (isNumber && lineAndColumn.size() <= 2)
+        {
+            emit(gotoLine(line, column));
+            return;
+        }
     }
 
-    emit(gotoLine(line.toInt()));
+    QMessageBox::information(this, tr("Go"), tr("Must enter a line number, line:column, @offset, or percent%."));
 }
@@ -28,7 +28,9 @@ private slots:
     void on_gotoButton_clicked();
 
 signals:
-    void gotoLine(int);
+    void gotoLine(int line, int column);
+    void gotoOffset(qint64 byteOffset);
+    void gotoPercent(int percent);
 };
 
 #endif // GOTODIALOG_H
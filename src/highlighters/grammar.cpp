@@ -0,0 +1,115 @@
+#include "grammar.h"
+#include <QVector>
+#include <QJsonArray>
+
+
+/* Returns roughly how many bytes this Grammar takes up.
+ */
+int Grammar::getMemoryUsage() const
+{
+    return static_cast<int>(sizeof(Grammar) - sizeof(Lexer)) + lexer.getMemoryUsage() +
+           dedentAfter.pattern().size() * static_cast<int>(sizeof(QChar));
+}
+
+
+/* Builds a grammar from the rules in a language definition (see GrammarRegistry). Every rule is optional:
+ *   "keywords": the words highlighted as keywords
+ *   "caseInsensitive": whether keywords are highlighted regardless of case
+ *   "lineComment": what starts a comment that runs to the end of the line
+ *   "blockComment": what starts and ends a comment that may span lines, as a pair
+ *   "quotes": the characters that start (and end) a string; both kinds of quotes by default
+ *   "tripleQuotedStrings": whether ''' and """ start strings that may span lines
+ *   "nestedBlockComments": whether block comments can contain other block comments
+ *   "rawStrings": "parenthesized" for C++'s R"delimiter(...)delimiter", or "hashed" for Rust's r#"..."#
+ *   "codeBlock": what starts and ends a code block, as a pair, for auto-indentation
+ *   "dedentAfter": a pattern for lines that end a code block without an end delimiter
+ */
+Grammar Grammar::fromDefinition(const QJsonObject &definition)
+{
+    Grammar grammar;
+    QStringList keywords;
+
+    for (const QJsonValue &keyword : definition["keywords"].toArray())
+    {
+        keywords << keyword.toString();
+    }
+
+    grammar.lexer.setCaseInsensitiveKeywords(definition["caseInsensitive"].toBool());
+    grammar.lexer.addKeywords(keywords);
+    grammar.lexer.setLineCommentStart(definition["lineComment"].toString());
+    grammar.lexer.setTripleQuotedStrings(definition["tripleQuotedStrings"].toBool());
+    grammar.lexer.setNestedBlockComments(definition["nestedBlockComments"].toBool());
+
+    QString rawStrings = definition["rawStrings"].toString();
+    grammar.lexer.setRawStrings(rawStrings == "parenthesized" ? Lexer::ParenthesizedRawStrings :
+                                rawStrings == "hashed" ? Lexer::HashedRawStrings : Lexer::NoRawStrings);
+
+    QJsonArray blockComment = definition["blockComment"].toArray();
+    if (blockComment.size() == 2)
+    {
+        grammar.lexer.setBlockCommentDelimiters(blockComment[0].toString(), blockComment[1].toString());
+    }
+
+    if (definition.contains("quotes"))
+    {
+        grammar.lexer.setQuoteCharacters(definition["quotes"].toString());
+    }
+
+    QJsonArray codeBlock = definition["codeBlock"].toArray();
+    QString codeBlockStart = codeBlock.size() > 0 ? codeBlock[0].toString() : QString();
+    QString codeBlockEnd = codeBlock.size() > 1 ? codeBlock[1].toString() : QString();
+    grammar.codeBlockStart = codeBlockStart.isEmpty() ? QChar() : codeBlockStart[0];
+    grammar.codeBlockEnd = codeBlockEnd.isEmpty() ? QChar() : codeBlockEnd[0];
+
+    if (definition.contains("dedentAfter"))
+    {
+        grammar.dedentAfter = QRegularExpression(definition["dedentAfter"].toString());
+    }
+
+    return grammar;
+}
+
+
+/* Writes the given grammar to a binary stream (see GrammarRegistry).
+ */
+QDataStream &operator<<(QDataStream &out, const Grammar &grammar)
+{
+    return out << grammar.lexer << grammar.codeBlockStart << grammar.codeBlockEnd << grammar.dedentAfter.pattern();
+}
+
+
+/* Reads a grammar back from a binary stream written by operator<<.
+ */
+QDataStream &operator>>(QDataStream &in, Grammar &grammar)
+{
+    QString dedentPattern;
+    in >> grammar.lexer >> grammar.codeBlockStart >> grammar.codeBlockEnd >> dedentPattern;
+
+    grammar.dedentAfter = dedentPattern.isEmpty() ? QRegularExpression() : QRegularExpression(dedentPattern);
+    return in;
+}
+
+
+/* Returns the format that tokens of the given type are highlighted with. Every language uses
+ * the same formats, so there's only ever one of each.
+ */
+const QTextCharFormat &Grammar::formatFor(Token::Type type)
+{
+    static const QVector<QTextCharFormat> formats = []()
+    {
+        QVector<QTextCharFormat> formats(Token::Bracket + 1);
+
+        formats[Token::Keyword].setForeground(Qt::darkBlue);
+        formats[Token::Keyword].setFontWeight(QFont::Bold);
+        formats[Token::Class].setFontWeight(QFont::Bold);
+        formats[Token::Class].setForeground(Qt::darkMagenta);
+        formats[Token::Function].setFontItalic(true);
+        formats[Token::Function].setForeground(Qt::blue);
+        formats[Token::String].setForeground(Qt::darkGreen);
+        formats[Token::Comment].setForeground(Qt::darkGreen);
+
+        return formats;
+    }();
+
+    return formats[type];
+}
@@ -0,0 +1,35 @@
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+#include "lexer.h"
+#include <QChar>
+#include <QRegularExpression>
+#include <QTextCharFormat>
+#include <QJsonObject>
+#include <QDataStream>
+
+
+/* Everything there is to know about highlighting and indenting one language. A language's Grammar
+ * is built once (see GrammarRegistry), from its definition file or the binary cache of those,
+ * and then shared, read-only, by every Highlighter for that language, including their worker threads.
+ */
+struct Grammar
+{
+    // Splits lines into tokens; each language configures its own keywords and comment syntax
+    Lexer lexer;
+
+    // For auto-indentation after a user hits ENTER
+    QChar codeBlockStart;
+    QChar codeBlockEnd;
+
+    // Lines matching this end a code block in languages without an end delimiter (e.g., return in Python)
+    QRegularExpression dedentAfter;
+
+    int getMemoryUsage() const;
+    static Grammar fromDefinition(const QJsonObject &definition);
+    static const QTextCharFormat &formatFor(Token::Type type);
+};
+
+QDataStream &operator<<(QDataStream &out, const Grammar &grammar);
+QDataStream &operator>>(QDataStream &in, Grammar &grammar);
+
+#endif // GRAMMAR_H
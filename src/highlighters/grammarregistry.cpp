@@ -0,0 +1,299 @@
+#include "grammarregistry.h"
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDir>
+#include <QtDebug>
+
+
+/* Returns the registry, loading every language definition (or the cache of them) the first time.
+ */
+GrammarRegistry &GrammarRegistry::instance()
+{
+    static GrammarRegistry registry;
+    return registry;
+}
+
+
+/* Loads the languages from the cache if it's up to date, and otherwise from their definitions
+ * (rewriting the cache).
+ */
+GrammarRegistry::GrammarRegistry()
+{
+    QStringList files = definitionFiles();
+    QByteArray fingerprint = fingerprintOf(files);
+
+    if (!loadCache(fingerprint))
+    {
+        compile(files);
+        writeCache(fingerprint);
+    }
+
+    for (auto language = languages.constBegin(); language != languages.constEnd(); ++language)
+    {
+        for (const QString &extension : language.value().extensions)
+        {
+            extensionToLanguage.insert(extension, language.key());
+        }
+    }
+}
+
+
+/* Returns the language that the file with the given name is written in, judging by its extension,
+ * or NO_LANGUAGE (an empty string) if it isn't one of the known languages.
+ */
+QString GrammarRegistry::languageOf(const QString &fileName) const
+{
+    return extensionToLanguage.value(QFileInfo(fileName).suffix().toLower());
+}
+
+
+/* Returns the Grammar for the given language, or a null pointer if there's no such language.
+ */
+QSharedPointer<const Grammar> GrammarRegistry::grammarFor(const QString &language)
+{
+    auto entry = languages.find(language);
+
+    if (entry == languages.end())
+    {
+        return QSharedPointer<const Grammar>();
+    }
+
+    if (!entry->grammar && entry->offset != -1)
+    {
+        QDataStream in(cache);
+        in.setVersion(QDataStream::Qt_5_6);
+        in.device()->seek(entry->offset);
+
+        QSharedPointer<Grammar> grammar(new Grammar());
+        in >> *grammar;
+
+        if (in.status() != QDataStream::Ok)
+        {
+            qWarning() << "Grammar cache is corrupt; cannot load" << language;
+            return QSharedPointer<const Grammar>();
+        }
+
+        entry->grammar = grammar;
+    }
+
+    return entry->grammar;
+}
+
+
+/* Returns how many grammars have been built so far.
+ */
+int GrammarRegistry::getNumGrammars() const
+{
+    int numGrammars = 0;
+
+    for (const Entry &entry : languages)
+    {
+        numGrammars += entry.grammar ? 1 : 0;
+    }
+
+    return numGrammars;
+}
+
+
+/* Returns roughly how many bytes all of the grammars built so far take up.
+ */
+int GrammarRegistry::getMemoryUsage() const
+{
+    int memoryUsage = 0;
+
+    for (const Entry &entry : languages)
+    {
+        memoryUsage += entry.grammar ? entry.grammar->getMemoryUsage() : 0;
+    }
+
+    return memoryUsage;
+}
+
+
+/* Returns the directory that the user's own language definitions go in.
+ */
+QString GrammarRegistry::definitionsDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/languages";
+}
+
+
+/* Returns where the compiled definitions are cached.
+ */
+QString GrammarRegistry::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/grammars.bin";
+}
+
+
+/* Returns the paths of every language definition, the built-in ones first.
+ */
+QStringList GrammarRegistry::definitionFiles()
+{
+    QStringList files;
+
+    for (const QString &directory : {QString(":/languages"), definitionsDirectory()})
+    {
+        for (const QFileInfo &file : QDir(directory).entryInfoList({"*.json"}, QDir::Files, QDir::Name))
+        {
+            files << file.absoluteFilePath();
+        }
+    }
+
+    return files;
+}
+
+
+/* Returns a fingerprint of the given definition files that changes whenever any of them is added,
+ * removed or modified, without having to read them.
+ */
+QByteArray GrammarRegistry::fingerprintOf(const QStringList &files)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    for (const QString &file : files)
+    {
+        QFileInfo info(file);
+        hash.addData(file.toUtf8());
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    }
+
+    return hash.result();
+}
+
+
+/* Maps the cache into memory and reads its index (every language's name, extensions, and where
+ * its Grammar starts). Returns false if there's no cache, or if it's stale or unreadable.
+ */
+bool GrammarRegistry::loadCache(const QByteArray &fingerprint)
+{
+    cacheFile.setFileName(cachePath());
+
+    if (!cacheFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    uchar *mapping = cacheFile.map(0, cacheFile.size());
+
+    if (!mapping)
+    {
+        cacheFile.close();
+        return false;
+    }
+
+    cache = QByteArray::fromRawData(reinterpret_cast<const char*>(mapping), static_cast<int>(cacheFile.size()));
+
+    QDataStream in(cache);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic;
+    quint32 version;
+    QByteArray cachedFingerprint;
+    qint32 numLanguages;
+    in >> magic >> version >> cachedFingerprint >> numLanguages;
+
+    bool isCurrent = in.status() == QDataStream::Ok && magic == CACHE_MAGIC &&
+                     version == CACHE_VERSION && cachedFingerprint == fingerprint;
+
+    for (int i = 0; isCurrent && i < numLanguages; i++)
+    {
+        QString name;
+        Entry entry;
+        in >> name >> entry.extensions >> entry.offset;
+        languages.insert(name, entry);
+    }
+
+    // Offsets are relative to the end of the index
+    qint64 indexEnd = in.device()->pos();
+
+    if (!isCurrent || in.status() != QDataStream::Ok)
+    {
+        languages.clear();
+        cache.clear();
+        cacheFile.close();
+        return false;
+    }
+
+    for (Entry &entry : languages)
+    {
+        entry.offset += indexEnd;
+    }
+
+    return true;
+}
+
+
+/* Parses every language definition and builds its Grammar. A definition that can't be parsed
+ * is skipped (with a warning); one with the same name as an earlier one replaces it.
+ */
+void GrammarRegistry::compile(const QStringList &files)
+{
+    for (const QString &path : files)
+    {
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            qWarning() << "Cannot read language definition" << path << file.errorString();
+            continue;
+        }
+
+        QJsonParseError error;
+        QJsonDocument definition = QJsonDocument::fromJson(file.readAll(), &error);
+        QString name = definition.object()["name"].toString();
+
+        if (name.isEmpty())
+        {
+            qWarning() << "Skipping language definition" << path << (definition.isNull() ? error.errorString() : "(it has no name)");
+            continue;
+        }
+
+        Entry entry;
+        entry.grammar.reset(new Grammar(Grammar::fromDefinition(definition.object())));
+
+        for (const QJsonValue &extension : definition.object()["extensions"].toArray())
+        {
+            entry.extensions << extension.toString().toLower();
+        }
+
+        languages.insert(name, entry);
+    }
+}
+
+
+/* Writes every language (and its Grammar) to the cache. The cache is only ever replaced whole,
+ * so a failed write leaves the old one intact; it's simply rebuilt on the next run.
+ */
+void GrammarRegistry::writeCache(const QByteArray &fingerprint)
+{
+    QByteArray index;
+    QByteArray grammars;
+    QDataStream indexOut(&index, QIODevice::WriteOnly);
+    QDataStream grammarsOut(&grammars, QIODevice::WriteOnly);
+    indexOut.setVersion(QDataStream::Qt_5_6);
+    grammarsOut.setVersion(QDataStream::Qt_5_6);
+
+    indexOut << CACHE_MAGIC << CACHE_VERSION << fingerprint << qint32(languages.size());
+
+    for (auto language = languages.constBegin(); language != languages.constEnd(); ++language)
+    {
+        indexOut << language.key() << language.value().extensions << qint64(grammars.size());
+        grammarsOut << *language.value().grammar;
+    }
+
+    QDir().mkpath(QFileInfo(cachePath()).path());
+    QSaveFile file(cachePath());
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(index) != index.size() ||
+        file.write(grammars) != grammars.size() || !file.commit())
+    {
+        qWarning() << "Cannot write grammar cache:" << file.errorString();
+    }
+}
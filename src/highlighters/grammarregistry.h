@@ -0,0 +1,71 @@
+#ifndef GRAMMARREGISTRY_H
+#define GRAMMARREGISTRY_H
+#include "grammar.h"
+#include <QSharedPointer>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+
+
+/* Knows every language the editor can highlight and holds one Grammar per language for the whole
+ * application. Languages are defined in JSON files: the built-in ones (see resources.qrc) and any
+ * in the user's languages directory (see definitionsDirectory), which take precedence. Besides the
+ * rules that Grammar::fromDefinition reads, each definition has a "name" and the file "extensions"
+ * the language is used for.
+ *
+ * Parsing the definitions and building their keyword tables only happens when the definitions have
+ * changed. The result is written to a binary cache, which later runs map into memory; a language's
+ * Grammar is then read straight out of the mapping the first time a Highlighter asks for it. Every
+ * Highlighter after that, in any tab, just takes another reference to the same Grammar.
+ *
+ * Grammars are never changed once built. Only to be used from the GUI thread.
+ */
+class GrammarRegistry
+{
+public:
+    static GrammarRegistry &instance();
+
+    QStringList getLanguages() const { return languages.keys(); }
+    QString languageOf(const QString &fileName) const;
+    QSharedPointer<const Grammar> grammarFor(const QString &language);
+
+    int getNumGrammars() const;
+    int getMemoryUsage() const;
+
+    static QString definitionsDirectory();
+    static QString cachePath();
+
+    const static quint32 CACHE_MAGIC = 0x53434752;
+    const static quint32 CACHE_VERSION = 3;
+
+private:
+    GrammarRegistry();
+
+    struct Entry
+    {
+        QStringList extensions;
+
+        // Where this language's Grammar starts in the cache, or -1 if it was compiled on this run
+        qint64 offset = -1;
+
+        // Built the first time it's asked for
+        QSharedPointer<const Grammar> grammar;
+    };
+
+    static QStringList definitionFiles();
+    static QByteArray fingerprintOf(const QStringList &files);
+    bool loadCache(const QByteArray &fingerprint);
+    void compile(const QStringList &files);
+    void writeCache(const QByteArray &fingerprint);
+
+    QMap<QString, Entry> languages;
+    QHash<QString, QString> extensionToLanguage;
+
+    // The cache file, mapped into memory for as long as the application runs
+    QFile cacheFile;
+    QByteArray cache;
+};
+
+#endif // GRAMMARREGISTRY_H
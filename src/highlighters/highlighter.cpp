@@ -1,100 +1,773 @@
 #include "highlighter.h"
+#include "../bracketmatcher.h"
+#include "../blockdata.h"
+#include "../settings.h"
+#include <QElapsedTimer>
+#include <QTextLayout>
 #include <QtDebug>
 
 
-Highlighter::Highlighter(QTextDocument *parent) : QSyntaxHighlighter(parent)
+Highlighter::Highlighter(QSharedPointer<const Grammar> grammar, QTextDocument *parent)
+    : QObject(parent), grammar(grammar), document(parent)
 {
-    keywordFormat.setForeground(Qt::darkBlue);
-    keywordFormat.setFontWeight(QFont::Bold);
-    classFormat.setFontWeight(QFont::Bold);
-    classFormat.setForeground(Qt::darkMagenta);
-    functionFormat.setFontItalic(true);
-    functionFormat.setForeground(Qt::blue);
-    quoteFormat.setForeground(Qt::darkGreen);
-    inlineCommentFormat.setForeground(Qt::darkGreen);
-    blockCommentFormat.setForeground(Qt::darkGreen);
+    qRegisterMetaType<HighlightBatch>("HighlightBatch");
+
+    restartTimer.setSingleShot(true);
+    restartTimer.setInterval(RESTART_DELAY);
+    cascadeTimer.setSingleShot(true);
+    cascadeTimer.setInterval(0);
+    frameBudget = Settings::instance()->value(FRAME_BUDGET_KEY, DEFAULT_FRAME_BUDGET).toInt();
+    knownBlockCount = document->blockCount();
+
+    connect(&restartTimer, SIGNAL(timeout()), this, SLOT(startWorker()));
+    connect(&cascadeTimer, SIGNAL(timeout()), this, SLOT(continueCascades()));
+    connect(document, SIGNAL(contentsChange(int, int, int)), this, SLOT(on_contentsChange(int, int, int)));
+
+    // The first pass waits for the Editor to say which lines are on screen
+    QTimer::singleShot(0, this, SLOT(rehighlight()));
+}
+
+
+/* Stops any workers that are still running and removes all highlighting from the document
+ * (unless the document itself is what's being destroyed).
+ */
+Highlighter::~Highlighter()
+{
+    // Workers that were stopped but haven't exited yet are still children of this Highlighter
+    for (HighlightWorker *child : findChildren<HighlightWorker*>())
+    {
+        child->requestInterruption();
+        child->wait();
+    }
+
+    if (document)
+    {
+        clearFormats();
+    }
+}
+
+
+/* Tells this Highlighter which blocks are on screen, so that they can be highlighted first
+ * (or, in lazy mode, at all).
+ */
+void Highlighter::setVisibleBlocks(int first, int last)
+{
+    firstVisibleBlock = first;
+    lastVisibleBlock = last;
+    moveFormatWindow(qMax(0, first - FORMAT_MARGIN), last + FORMAT_MARGIN);
+
+    if (worker)
+    {
+        worker->setVisibleBlocks(first, last);
+    }
+
+    highlightVisibleBlocks();
+}
+
+
+/* Moves the window of blocks whose formats are set to the given blocks. Blocks that leave it give up
+ * their formats, and blocks that enter it get them back from their styled ranges.
+ */
+void Highlighter::moveFormatWindow(int start, int end)
+{
+    int oldStart = formatWindowStart;
+    int oldEnd = formatWindowEnd;
+    formatWindowStart = start;
+    formatWindowEnd = end;
+
+    applyingFormats = true;
+
+    // The two windows can be far apart (e.g., after going to the end of the file), and nothing in between changes
+    for (int window = 0; window < 2; window++)
+    {
+        int dirtyStart = -1;
+        int dirtyEnd = -1;
+        int last = window == 0 ? oldEnd : end;
+
+        for (QTextBlock block = document->findBlockByNumber(window == 0 ? oldStart : start); block.isValid() && block.blockNumber() <= last; block = block.next())
+        {
+            if (resolveFormats(block))
+            {
+                dirtyStart = dirtyStart == -1 ? block.position() : dirtyStart;
+                dirtyEnd = block.position() + block.length();
+            }
+        }
+
+        if (dirtyStart != -1)
+        {
+            document->markContentsDirty(dirtyStart, dirtyEnd - dirtyStart);
+        }
+    }
+
+    applyingFormats = false;
+}
+
+
+/* Highlights the entire document again in the background.
+ */
+void Highlighter::rehighlight()
+{
+    scheduleWorkerFrom(0);
+    restartTimer.stop();
+    startWorker();
+}
+
+
+/* Returns roughly how many bytes this Highlighter takes up, not counting its (shared) Grammar
+ * or the highlighting it has applied to its document.
+ */
+int Highlighter::getMemoryUsage() const
+{
+    return static_cast<int>(sizeof(Highlighter) + (worker ? sizeof(HighlightWorker) : 0));
+}
+
+
+/* Returns roughly how many bytes the highlighting of this Highlighter's document takes up: the styled
+ * ranges of every block (counting lines that share theirs, through the TokenCache, only once) and the
+ * formats of the blocks on screen.
+ */
+qint64 Highlighter::getHighlightingMemoryUsage() const
+{
+    QSet<const StyledRange*> counted;
+    qint64 usage = 0;
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+        QVector<StyledRange> ranges = data ? data->styledRanges : QVector<StyledRange>();
+
+        if (!ranges.isEmpty() && !counted.contains(ranges.constData()))
+        {
+            counted.insert(ranges.constData());
+            usage += ranges.capacity() * static_cast<qint64>(sizeof(StyledRange));
+        }
+
+        usage += block.layout()->formats().size() * static_cast<qint64>(sizeof(QTextLayout::FormatRange));
+    }
+
+    return usage;
+}
+
+
+/* Returns roughly how many bytes the highlighting of this Highlighter's document would take up if
+ * every highlighted block kept its formats instead, for comparison.
+ */
+qint64 Highlighter::getFormatsMemoryUsage() const
+{
+    qint64 usage = 0;
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+
+        if (data)
+        {
+            usage += data->styledRanges.size() * static_cast<qint64>(sizeof(QTextLayout::FormatRange));
+        }
+    }
+
+    return usage;
+}
+
+
+/* Called whenever text is inserted into or removed from the document. Re-lexes the edited
+ * blocks right away, so they're painted highlighted, and queues up a cascade through the blocks
+ * after them if the edit changed the state they start in (see continueCascades).
+ */
+void Highlighter::on_contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    if (applyingFormats)
+    {
+        return;
+    }
+
+    QTextBlock block = document->findBlock(position);
+    int lastEditedBlock = document->findBlock(position + charsAdded).blockNumber();
+    int addedBlocks = document->blockCount() - knownBlockCount;
+
+    if (addedBlocks != 0)
+    {
+        knownBlockCount = document->blockCount();
+
+        // The blocks after the edit moved, but their states still hold
+        if (lazy && block.blockNumber() < stateWatermark)
+        {
+            stateWatermark = qMax(block.blockNumber(), stateWatermark + addedBlocks);
+        }
+
+        for (Cascade &cascade : cascades)
+        {
+            if (cascade.nextBlock > block.blockNumber())
+            {
+                cascade.nextBlock = qMax(block.blockNumber(), cascade.nextBlock + addedBlocks);
+            }
+        }
+
+        // Block numbers in the running worker's snapshot no longer line up with the document
+        if (worker)
+        {
+            restartWorkerLater();
+        }
+    }
+
+    applyingFormats = true;
+    numEdits++;
+    int dirtyStart = -1;
+    int dirtyEnd = -1;
+
+    for (int numHighlighted = 0; block.isValid() && block.blockNumber() <= lastEditedBlock; numHighlighted++, block = block.next())
+    {
+        if (numHighlighted == SYNC_BLOCK_BUDGET || !isStateKnownBefore(block))
+        {
+            scheduleWorkerFrom(block.blockNumber());
+
+            // Whatever highlighting the edited blocks still have left is for their old text
+            for (; block.isValid() && block.blockNumber() <= lastEditedBlock; block = block.next())
+            {
+                BlockData::of(block)->highlightedState = BlockData::UNCOUNTED;
+            }
+
+            break;
+        }
+
+        if (relex(block, dirtyStart, dirtyEnd) && block.blockNumber() == lastEditedBlock)
+        {
+            queueCascadeFrom(lastEditedBlock + 1);
+        }
+    }
+
+    if (dirtyStart != -1)
+    {
+        document->markContentsDirty(dirtyStart, dirtyEnd - dirtyStart);
+    }
+
+    applyingFormats = false;
+}
+
+
+/* Called once the event loop is idle after an edit changed the state some blocks start in.
+ * Re-lexes those blocks for as long as the change in state carries over, one block after
+ * another, but only for frameBudget milliseconds at a time so that typing and painting are
+ * never held up; whatever is left goes on in the next slice. Keystrokes that come in between
+ * slices only ever re-lex their own blocks, and cascades that catch up with one another merge.
+ * A cascade that runs for more than SYNC_BLOCK_BUDGET blocks is left to a worker instead.
+ */
+void Highlighter::continueCascades()
+{
+    if (!document)
+    {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    applyingFormats = true;
+    int dirtyStart = -1;
+    int dirtyEnd = -1;
+
+    while (!cascades.isEmpty() && !timer.hasExpired(frameBudget))
+    {
+        Cascade &cascade = cascades.first();
+        QTextBlock block = document->findBlockByNumber(cascade.nextBlock);
+
+        if (!block.isValid())
+        {
+            cascades.removeFirst();
+            continue;
+        }
+
+        if (cascade.numRelexed == SYNC_BLOCK_BUDGET || !isStateKnownBefore(block))
+        {
+            scheduleWorkerFrom(block.blockNumber());
+            cascades.removeFirst();
+            continue;
+        }
+
+        cascade.numRelexed++;
+
+        // Past the edit, keep going only as long as the change in state carries over
+        if (!relex(block, dirtyStart, dirtyEnd))
+        {
+            cascades.removeFirst();
+            continue;
+        }
+
+        // The running worker lexed the lines after this one assuming they start in the old state
+        if (worker)
+        {
+            scheduleWorkerFrom(block.blockNumber() + 1);
+        }
+
+        cascade.nextBlock++;
+
+        if (cascades.size() > 1 && cascades[1].nextBlock <= cascade.nextBlock)
+        {
+            cascades.remove(1);
+        }
+    }
+
+    if (dirtyStart != -1)
+    {
+        document->markContentsDirty(dirtyStart, dirtyEnd - dirtyStart);
+    }
+
+    applyingFormats = false;
+
+    if (!cascades.isEmpty())
+    {
+        cascadeTimer.start();
+    }
+}
+
+
+/* Makes sure the blocks from the given one on get re-lexed, for as long as the state they start
+ * in has changed, once the event loop is idle.
+ */
+void Highlighter::queueCascadeFrom(int blockNumber)
+{
+    int i = 0;
+    while (i < cascades.size() && cascades[i].nextBlock < blockNumber)
+    {
+        i++;
+    }
+
+    if (i == cascades.size() || cascades[i].nextBlock != blockNumber)
+    {
+        cascades.insert(i, {blockNumber, 0});
+    }
+
+    cascadeTimer.start();
+}
+
+
+/* Highlights the given block again, given the state the block before it ends in, and extends
+ * the range of the document that needs redrawing if its highlighting changed. Returns true if
+ * the state the block ends in changed as well.
+ */
+bool Highlighter::relex(QTextBlock block, int &dirtyStart, int &dirtyEnd)
+{
+    QTextBlock previous = block.previous();
+    int startState = previous.isValid() ? previous.userState() : Lexer::Normal;
+    int oldEndState = block.userState();
+    QString text = block.text();
+    HighlightedLine line = highlight(text, startState);
+    numRelexedBlocks++;
+
+    if (apply(block, text, line, startState))
+    {
+        dirtyStart = dirtyStart == -1 ? block.position() : dirtyStart;
+        dirtyEnd = block.position() + block.length();
+    }
+
+    if (lazy && block.blockNumber() == stateWatermark)
+    {
+        stateWatermark++;
+    }
+
+    return line.endState != oldEndState;
+}
+
+
+/* Called when the worker has lexed another batch of blocks. Applies the batch unless it's stale.
+ */
+void Highlighter::on_batchReady(HighlightBatch batch)
+{
+    if (batch.generation != generation)
+    {
+        return;
+    }
+
+    applyingFormats = true;
+    QTextBlock block = document->findBlockByNumber(batch.firstBlock);
+    int startState = batch.startState;
+    int dirtyStart = -1;
+    int dirtyEnd = -1;
+
+    for (int i = 0; i < batch.texts.size() && block.isValid(); i++, block = block.next())
+    {
+        // Lines edited since the snapshot was taken have already been highlighted as they were typed
+        if (block.text() == batch.texts[i])
+        {
+            if (i < batch.numStateOnly)
+            {
+                block.setUserState(batch.endStates[i]);
+            }
+            else
+            {
+                // Not cached: a whole file's worth of lines would evict the ones being edited (see TokenCache)
+                HighlightedLine line = highlightedLineFrom(batch.tokens[i], batch.endStates[i]);
+
+                if (apply(block, batch.texts[i], line, startState))
+                {
+                    dirtyStart = dirtyStart == -1 ? block.position() : dirtyStart;
+                    dirtyEnd = block.position() + block.length();
+                }
+            }
+        }
+
+        startState = block.userState();
+    }
+
+    // Batches are lexed starting from the watermark, so everything up to the end of this one is now known
+    if (lazy && batch.firstBlock <= stateWatermark)
+    {
+        stateWatermark = qMax(stateWatermark, batch.firstBlock + batch.texts.size());
+    }
+
+    if (dirtyStart != -1)
+    {
+        document->markContentsDirty(dirtyStart, dirtyEnd - dirtyStart);
+    }
+
+    applyingFormats = false;
+
+    if (worker)
+    {
+        worker->batchConsumed();
+    }
+}
+
+
+/* Called when a worker has handed over every batch. Nothing is left to highlight unless
+ * the worker was a stale one (or, in lazy mode, the user has scrolled since).
+ */
+void Highlighter::on_workerDone(int generation)
+{
+    if (generation != this->generation)
+    {
+        return;
+    }
+
+    firstDirtyBlock = -1;
+    stopWorker();
+    highlightVisibleBlocks();
+}
+
+
+/* Decides whether the document is to be highlighted lazily and starts highlighting whatever
+ * needs to be: every block from the first dirty one on, or in lazy mode the blocks on screen.
+ */
+void Highlighter::startWorker()
+{
+    stopWorker();
+
+    if (!document)
+    {
+        return;
+    }
+
+    bool wasLazy = lazy;
+    lazy = document->blockCount() >= LAZY_THRESHOLD;
+
+    if (lazy)
+    {
+        if (!wasLazy)
+        {
+            stateWatermark = firstDirtyBlock == -1 ? document->blockCount() : firstDirtyBlock;
+            firstDirtyBlock = -1;
+        }
+
+        highlightVisibleBlocks();
+        return;
+    }
+
+    // A lazy pass skipped over most of the document
+    if (wasLazy)
+    {
+        firstDirtyBlock = 0;
+    }
+
+    if (firstDirtyBlock == -1)
+    {
+        return;
+    }
+
+    // The worker needs to know the state the block before its first one ends in
+    QTextBlock block = document->findBlockByNumber(qMin(firstDirtyBlock, document->blockCount() - 1));
+    while (!isStateKnownBefore(block))
+    {
+        block = block.previous();
+    }
+
+    firstDirtyBlock = block.blockNumber();
+    launchWorker(firstDirtyBlock, document->blockCount() - 1, firstDirtyBlock);
+}
+
+
+/* In lazy mode, highlights the blocks on screen and LAZY_MARGIN blocks on either side of them,
+ * skipping any that are already highlighted. If the watermark hasn't reached them yet, a worker
+ * works out the states of the blocks in between and highlights them instead.
+ */
+void Highlighter::highlightVisibleBlocks()
+{
+    if (!lazy || !document)
+    {
+        return;
+    }
+
+    int first = qMax(0, firstVisibleBlock - LAZY_MARGIN);
+    int last = qMin(document->blockCount() - 1, lastVisibleBlock + LAZY_MARGIN);
+
+    if (stateWatermark < first)
+    {
+        if (!worker || first < windowStart || last > windowEnd)
+        {
+            launchWorker(stateWatermark, last, first);
+        }
+
+        return;
+    }
+
+    applyingFormats = true;
+    int dirtyStart = -1;
+    int dirtyEnd = -1;
+
+    for (QTextBlock block = document->findBlockByNumber(first); block.isValid() && block.blockNumber() <= last; block = block.next())
+    {
+        QTextBlock previous = block.previous();
+        int startState = previous.isValid() ? previous.userState() : Lexer::Normal;
+
+        if (BlockData::of(block)->highlightedState != startState)
+        {
+            QString text = block.text();
+
+            if (apply(block, text, highlight(text, startState), startState))
+            {
+                dirtyStart = dirtyStart == -1 ? block.position() : dirtyStart;
+                dirtyEnd = block.position() + block.length();
+            }
+        }
+
+        if (block.blockNumber() == stateWatermark)
+        {
+            stateWatermark++;
+        }
+    }
+
+    if (dirtyStart != -1)
+    {
+        document->markContentsDirty(dirtyStart, dirtyEnd - dirtyStart);
+    }
+
+    applyingFormats = false;
+}
+
+
+/* Starts a worker on the blocks from firstBlock through lastBlock. Blocks before formatFrom are
+ * only lexed for the state they end in. The block before firstBlock must have a known state.
+ */
+void Highlighter::launchWorker(int firstBlock, int lastBlock, int formatFrom)
+{
+    stopWorker();
+
+    QTextBlock block = document->findBlockByNumber(firstBlock);
+    int startState = block.previous().isValid() ? block.previous().userState() : Lexer::Normal;
+
+    QVector<QString> texts;
+    texts.reserve(lastBlock - firstBlock + 1);
+    for (; block.isValid() && block.blockNumber() <= lastBlock; block = block.next())
+    {
+        texts.append(block.text());
+    }
+
+    generation++;
+    windowStart = formatFrom;
+    windowEnd = lastBlock;
+    worker = new HighlightWorker(grammar, texts, firstBlock, startState, generation, this);
+    worker->setFormatFrom(formatFrom - firstBlock);
+    worker->setVisibleBlocks(firstVisibleBlock, lastVisibleBlock);
+
+    connect(worker, SIGNAL(batchReady(HighlightBatch)), this, SLOT(on_batchReady(HighlightBatch)));
+    connect(worker, SIGNAL(done(int)), this, SLOT(on_workerDone(int)));
+    connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+
+    worker->start(QThread::LowPriority);
 }
 
 
-/* Adds all keywords specified by the argument to this Highlighter's rules.
+/* Marks every block from the given one on as needing to be highlighted again (or in lazy mode,
+ * as having an unknown state), which happens once the document has gone RESTART_DELAY
+ * milliseconds without being edited.
  */
-void Highlighter::addKeywords(QStringList keywords)
+void Highlighter::scheduleWorkerFrom(int blockNumber)
 {
-    foreach(const QString &keyword, keywords)
+    if (lazy)
     {
-        addRule(QRegularExpression(keyword), keywordFormat);
+        stateWatermark = qMin(stateWatermark, blockNumber);
     }
+    else
+    {
+        firstDirtyBlock = firstDirtyBlock == -1 ? blockNumber : qMin(firstDirtyBlock, blockNumber);
+    }
+
+    restartWorkerLater();
 }
 
 
-/* Creates a HighlightingRule based on the given regex pattern and its
- * corresponding format and adds it to the internal vector of rules.
+/* Stops the current worker (if any) and starts over once the document has gone RESTART_DELAY
+ * milliseconds without being edited.
  */
-void Highlighter::addRule(QRegularExpression pattern, QTextCharFormat format)
+void Highlighter::restartWorkerLater()
 {
-    HighlightingRule rule;
-    rule.pattern = pattern;
-    rule.format = format;
-    rules.append(rule);
+    stopWorker();
+
+    // Anything the old worker still has queued up is stale
+    generation++;
+    restartTimer.start();
 }
 
 
-/* Called whenever blocks of text change within the document. Used to apply custom
- * formatting/syntax highlighting to the given text.
- * @param text - the text to be parsed for pattern matches
+/* Asks the current worker (if any) to stop. It deletes itself once it has exited.
  */
-void Highlighter::highlightBlock(const QString &text)
+void Highlighter::stopWorker()
 {
-    // Try to find matches for all rules (except comments) and apply their formatting
-    foreach(const HighlightingRule &rule, rules)
+    if (worker)
     {
-        QRegularExpressionMatchIterator iterator = rule.pattern.globalMatch(text);
+        worker->requestInterruption();
+        worker = nullptr;
+    }
+}
+
+
+/* Removes all highlighting (and bracket summaries) from the document.
+ */
+void Highlighter::clearFormats()
+{
+    applyingFormats = true;
 
-        while (iterator.hasNext())
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        block.setUserState(NOT_HIGHLIGHTED);
+        BracketMatcher::summarize(block, QString(), QVector<int>());
+        BlockData::of(block)->highlightedState = BlockData::UNCOUNTED;
+        BlockData::of(block)->styledRanges.clear();
+
+        if (!block.layout()->formats().isEmpty())
         {
-            QRegularExpressionMatch match = iterator.next();
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+            block.layout()->setFormats(QVector<QTextLayout::FormatRange>());
         }
     }
 
-    setCurrentBlockState(BlockState::NotInComment);
-    highlightMultilineComments(text);
+    document->markContentsDirty(0, document->characterCount());
+    applyingFormats = false;
 }
 
 
-/* Formats multiline comments per this Highlighter's
- * blockCommentStart and blockCommentEnd patterns.
+/* Returns true if the state the given block starts in is known.
  */
-void Highlighter::highlightMultilineComments(const QString &text)
+bool Highlighter::isStateKnownBefore(QTextBlock block) const
 {
-    int startIndex = 0;
+    QTextBlock previous = block.previous();
 
-    // If the previous state was not in comment, then start searching from very beginning
-    if (previousBlockState() != BlockState::InComment)
+    if (!previous.isValid())
     {
-        startIndex = text.indexOf(blockCommentStart);
+        return true;
     }
 
-    while (startIndex >= 0)
+    return lazy ? previous.blockNumber() < stateWatermark : previous.userState() != NOT_HIGHLIGHTED;
+}
+
+
+/* Returns the highlighting of the given line of text, given the state the line before it ended in.
+ * Lines that any Highlighter with the same rules has seen recently come from the TokenCache.
+ */
+HighlightedLine Highlighter::highlight(const QString &text, int startState)
+{
+    TokenCache &cache = TokenCache::instance();
+    const HighlightedLine *cached = cache.find(text, startState, grammar->lexer.getRulesHash());
+
+    if (cached)
     {
-        QRegularExpressionMatch match = blockCommentEnd.match(text, startIndex);
-        int endIndex = match.capturedStart();
-        int commentLength = 0;
+        return *cached;
+    }
+
+    QVector<Token> tokens;
+    int endState = grammar->lexer.tokenize(text, startState, tokens);
+    HighlightedLine line = highlightedLineFrom(tokens, endState);
 
-        // If we have not yet found the terminating pattern, we are still in comment
-        if (endIndex == -1)
+    cache.insert(text, startState, grammar->lexer.getRulesHash(), line);
+    return line;
+}
+
+
+/* Packs the given tokens into styled ranges (and the positions of the brackets among them).
+ */
+HighlightedLine Highlighter::highlightedLineFrom(const QVector<Token> &tokens, int endState)
+{
+    HighlightedLine line;
+    line.endState = endState;
+
+    for (const Token &token : tokens)
+    {
+        if (token.type == Token::Bracket)
         {
-           setCurrentBlockState(BlockState::InComment);
-           commentLength = text.length() - startIndex;
+            line.bracketPositions.append(token.start);
+            continue;
         }
-        else
+
+        for (int start = token.start; start < token.start + token.length; start += StyledRange::MAX_LENGTH)
         {
-           commentLength = endIndex - startIndex + match.capturedLength();
+            StyledRange range;
+            range.start = start;
+            range.length = static_cast<quint32>(qMin(token.start + token.length - start, static_cast<int>(StyledRange::MAX_LENGTH)));
+            range.style = token.type;
+            line.ranges.append(range);
         }
+    }
 
-        setFormat(startIndex, commentLength, blockCommentFormat);
-        startIndex = text.indexOf(blockCommentStart, startIndex + commentLength);
-   }
+    return line;
 }
 
 
+/* Sets the given block's highlighting and bracket summary, and records the states it starts and
+ * ends in. Only blocks on screen (or close to it) have their formats set; the rest just keep their
+ * styled ranges. Returns true if the block's formats actually changed (in which case the block
+ * must be marked dirty so it gets redrawn).
+ */
+bool Highlighter::apply(QTextBlock block, const QString &text, const HighlightedLine &line, int startState)
+{
+    BlockData *data = BlockData::of(block);
+
+    block.setUserState(line.endState);
+    BracketMatcher::summarize(block, text, line.bracketPositions);
+    data->highlightedState = startState;
+    data->styledRanges = line.ranges;
+
+    return resolveFormats(block);
+}
+
+
+/* Sets the given block's formats from its styled ranges if it's in the window of blocks around the
+ * screen, and removes them otherwise. Returns true if they changed.
+ */
+bool Highlighter::resolveFormats(QTextBlock block)
+{
+    bool inWindow = block.blockNumber() >= formatWindowStart && block.blockNumber() <= formatWindowEnd;
+    QVector<QTextLayout::FormatRange> formats;
+
+    if (inWindow)
+    {
+        const QVector<StyledRange> &ranges = BlockData::of(block)->styledRanges;
+        formats.reserve(ranges.size());
+
+        for (const StyledRange &range : ranges)
+        {
+            QTextLayout::FormatRange format;
+            format.start = range.start;
+            format.length = static_cast<int>(range.length);
+            format.format = Grammar::formatFor(static_cast<Token::Type>(range.style));
+            formats.append(format);
+        }
+    }
+
+    if (block.layout()->formats() == formats)
+    {
+        return false;
+    }
+
+    block.layout()->setFormats(formats);
+    return true;
+}
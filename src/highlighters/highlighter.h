@@ -1,57 +1,143 @@
 #ifndef HIGHLIGHTER_H
 #define HIGHLIGHTER_H
-#include <QSyntaxHighlighter>
-#include <QRegularExpression>
+#include "grammarregistry.h"
+#include "highlightworker.h"
+#include "tokencache.h"
+#include <QObject>
+#include <QPointer>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QSet>
 #include <QtDebug>
 
 
-class Highlighter : public QSyntaxHighlighter
+/* Syntax highlighting for a document. Most of the work happens on a HighlightWorker thread,
+ * which lexes a snapshot of the document, the lines on screen first, while the GUI only
+ * applies the results. Lines that are edited are re-lexed right away on the GUI thread, since
+ * that only takes as long as the lines themselves. The lines after them are re-lexed too, for as
+ * long as the edit changes the state they start in (e.g., after typing the start of a comment),
+ * but only when the GUI is idle and in slices of at most frameBudget milliseconds (a setting),
+ * up to SYNC_BLOCK_BUDGET lines. Anything further is left to a new worker, started once editing pauses.
+ *
+ * Documents of LAZY_THRESHOLD lines or more are highlighted lazily instead: only the lines on
+ * screen (and LAZY_MARGIN lines around them) are ever highlighted. The states of all lines before
+ * the watermark are known; to highlight lines past it, the lines in between are lexed just for the
+ * state they end in, which is far cheaper, and the watermark moves up to the lines on screen.
+ *
+ * How to highlight the language comes from its Grammar, which every Highlighter for the same
+ * language shares (see GrammarRegistry); a Highlighter itself only keeps track of its document.
+ *
+ * A block's highlighting is kept as packed styled ranges in its BlockData (shared with the
+ * TokenCache and any other block with the same line). Only the blocks on screen, and FORMAT_MARGIN
+ * blocks around them, have their ranges turned into formats for their layouts, and blocks that
+ * scroll out of that window give their formats up again.
+ *
+ * Each block's user state (see QTextBlock::userState) is the lexer state it ends in, or
+ * NOT_HIGHLIGHTED if it hasn't been highlighted yet. Each block also remembers the state it
+ * started in when it was highlighted (see BlockData), so a block only needs highlighting again
+ * if it's been edited or the line before it now ends in a different state.
+ */
+class Highlighter : public QObject
 {
     Q_OBJECT
 
 public:
 
-    Highlighter(QTextDocument *parent = nullptr);
-    virtual void addKeywords(QStringList keywords);
-    virtual void addRule(QRegularExpression pattern, QTextCharFormat format);
+    Highlighter(QSharedPointer<const Grammar> grammar, QTextDocument *parent);
+    ~Highlighter() override;
+    void setVisibleBlocks(int first, int last);
+    int getMemoryUsage() const;
+    qint64 getHighlightingMemoryUsage() const;
+    qint64 getFormatsMemoryUsage() const;
+    int getNumEdits() const { return numEdits; }
+    int getNumRelexedBlocks() const { return numRelexedBlocks; }
 
-    QChar getCodeBlockStartDelimiter() const { return codeBlockStart; }
-    QChar getCodeBlockEndDelimiter() const { return codeBlockEnd; }
+    QChar getCodeBlockStartDelimiter() const { return grammar->codeBlockStart; }
+    QChar getCodeBlockEndDelimiter() const { return grammar->codeBlockEnd; }
+    QRegularExpression getDedentPattern() const { return grammar->dedentAfter; }
 
-protected:
+    static HighlightedLine highlightedLineFrom(const QVector<Token> &tokens, int endState);
 
-    virtual void highlightBlock(const QString &text) override;
-    virtual void highlightMultilineComments(const QString &text);
+    const static int NOT_HIGHLIGHTED = -1;
+    const static int SYNC_BLOCK_BUDGET = 256;
+    const static int RESTART_DELAY = 250;
+    const static int LAZY_THRESHOLD = 20000;
+    const static int LAZY_MARGIN = 100;
+    const static int FORMAT_MARGIN = 50;
+    const static int DEFAULT_FRAME_BUDGET = 4;
+    const QString FRAME_BUDGET_KEY = "highlighting_frame_budget";
 
-    struct HighlightingRule
-    {
-        QRegularExpression pattern;
-        QTextCharFormat format;
-    };
+public slots:
+    void rehighlight();
+
+private slots:
+    void on_contentsChange(int position, int charsRemoved, int charsAdded);
+    void on_batchReady(HighlightBatch batch);
+    void on_workerDone(int generation);
+    void startWorker();
+    void continueCascades();
+
+private:
+    HighlightedLine highlight(const QString &text, int startState);
+    bool apply(QTextBlock block, const QString &text, const HighlightedLine &line, int startState);
+    bool resolveFormats(QTextBlock block);
+    void moveFormatWindow(int start, int end);
+    bool relex(QTextBlock block, int &dirtyStart, int &dirtyEnd);
+    void queueCascadeFrom(int blockNumber);
+    bool isStateKnownBefore(QTextBlock block) const;
+    void highlightVisibleBlocks();
+    void launchWorker(int firstBlock, int lastBlock, int formatFrom);
+    void scheduleWorkerFrom(int blockNumber);
+    void restartWorkerLater();
+    void stopWorker();
+    void clearFormats();
+
+    QSharedPointer<const Grammar> grammar;
+    QPointer<QTextDocument> document;
+    HighlightWorker *worker = nullptr;
+    QTimer restartTimer;
+    QTimer cascadeTimer;
+    int frameBudget;
 
-    // Used for multi-line comment formatting
-    enum BlockState
+    // Blocks whose starting state an edit changed, in order, each with how far its cascade has got
+    struct Cascade
     {
-        NotInComment = 0,
-        InComment = 1
+        int nextBlock;
+        int numRelexed;
     };
 
-    QVector<HighlightingRule> rules;
+    QVector<Cascade> cascades;
+
+    // Batches from any worker but the current one are stale
+    int generation = 0;
+
+    // The first block that a worker still has to (re)highlight, or -1 if there are none
+    int firstDirtyBlock = -1;
+
+    // Lazy mode only: the end states of all blocks before this one are known
+    bool lazy = false;
+    int stateWatermark = 0;
+
+    // Lazy mode only: the blocks the running worker is highlighting
+    int windowStart = 0;
+    int windowEnd = 0;
+
+    // The blocks on screen and FORMAT_MARGIN blocks on either side of them; only these have formats
+    int formatWindowStart = 0;
+    int formatWindowEnd = -1;
 
-    // Block comments are handled separately from the other patterns
-    QRegularExpression blockCommentStart;
-    QRegularExpression blockCommentEnd;
+    int knownBlockCount = 0;
+    int firstVisibleBlock = 0;
+    int lastVisibleBlock = 0;
 
-    // For auto-indentation after a user hits ENTER
-    QChar codeBlockStart;
-    QChar codeBlockEnd;
+    // How many edits there have been, and how many blocks they re-lexed between them on the GUI thread
+    int numEdits = 0;
+    int numRelexedBlocks = 0;
 
-    QTextCharFormat keywordFormat;
-    QTextCharFormat classFormat;
-    QTextCharFormat inlineCommentFormat;
-    QTextCharFormat blockCommentFormat;
-    QTextCharFormat quoteFormat;
-    QTextCharFormat functionFormat;
+    // Applying formats makes the document report a change of its own, which must be ignored
+    bool applyingFormats = false;
 
 };
 
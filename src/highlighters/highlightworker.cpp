@@ -0,0 +1,185 @@
+#include "highlightworker.h"
+
+
+/* Initializes this HighlightWorker with the text of every line from firstBlock to the end of
+ * the document and the state the line before firstBlock ended in. Call start() to begin.
+ */
+HighlightWorker::HighlightWorker(QSharedPointer<const Grammar> grammar, QVector<QString> texts, int firstBlock, int startState, int generation, QObject *parent)
+    : QThread(parent), grammar(grammar), texts(texts), firstBlock(firstBlock), generation(generation),
+      startStates({startState}), batchesInFlight(MAX_BATCHES_IN_FLIGHT)
+{
+}
+
+
+/* Tells the worker which blocks are on screen. Safe to call while the worker is running;
+ * it takes effect when the next batch is picked.
+ */
+void HighlightWorker::setVisibleBlocks(int first, int last)
+{
+    firstVisibleBlock.storeRelease(first);
+    lastVisibleBlock.storeRelease(last);
+}
+
+
+/* Blocks until the GUI is ready for another batch. Returns false if the worker
+ * was interrupted (see QThread::requestInterruption) in the meantime.
+ */
+bool HighlightWorker::waitForConsumer()
+{
+    while (!batchesInFlight.tryAcquire(1, 50))
+    {
+        if (isInterruptionRequested())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* Runs on the worker thread. Hands over the lines that only need their states, then picks the
+ * batch nearest the screen, lexes it, and hands it over, until every batch has been handed over
+ * or the worker is interrupted.
+ */
+void HighlightWorker::run()
+{
+    if (!handOverStates())
+    {
+        return;
+    }
+
+    int numBatches = (texts.size() - formatFrom + BATCH_SIZE - 1) / BATCH_SIZE;
+    QVector<bool> batchDone(numBatches, false);
+
+    for (int numDone = 0; numDone < numBatches; numDone++)
+    {
+        int batchIndex = nextBatch(batchDone);
+        int first = formatFrom + batchIndex * BATCH_SIZE;
+        int end = qMin(first + BATCH_SIZE, texts.size());
+
+        if (!lexStatesUpTo(first))
+        {
+            return;
+        }
+
+        HighlightBatch batch;
+        batch.generation = generation;
+        batch.firstBlock = firstBlock + first;
+        batch.startState = startStates[first];
+        batch.texts = texts.mid(first, end - first);
+        batch.tokens.resize(end - first);
+        batch.endStates.resize(end - first);
+
+        for (int line = first; line < end; line++)
+        {
+            int endState = grammar->lexer.tokenize(texts[line], startStates[line], batch.tokens[line - first]);
+            batch.endStates[line - first] = endState;
+
+            if (line + 1 == startStates.size())
+            {
+                startStates.append(endState);
+            }
+        }
+
+        if (!waitForConsumer())
+        {
+            return;
+        }
+
+        batchDone[batchIndex] = true;
+        emit(batchReady(batch));
+    }
+
+    emit(done(generation));
+}
+
+
+/* Hands over the states of the lines before formatFrom, in order. Returns false if the worker
+ * was interrupted in the meantime.
+ */
+bool HighlightWorker::handOverStates()
+{
+    for (int first = 0; first < formatFrom; first += STATE_BATCH_SIZE)
+    {
+        int end = qMin(first + STATE_BATCH_SIZE, formatFrom);
+
+        if (!lexStatesUpTo(end))
+        {
+            return false;
+        }
+
+        HighlightBatch batch;
+        batch.generation = generation;
+        batch.firstBlock = firstBlock + first;
+        batch.startState = startStates[first];
+        batch.numStateOnly = end - first;
+        batch.texts = texts.mid(first, end - first);
+        batch.tokens.resize(end - first);
+        batch.endStates = startStates.mid(first + 1, end - first);
+
+        if (!waitForConsumer())
+        {
+            return false;
+        }
+
+        emit(batchReady(batch));
+    }
+
+    return true;
+}
+
+
+/* Returns the index of the batch that should be lexed next: a batch on screen if there are
+ * any left, or else the one closest to the screen (preferring the one below it).
+ */
+int HighlightWorker::nextBatch(const QVector<bool> &batchDone) const
+{
+    int lastIndex = batchDone.size() - 1;
+    int firstFormatted = firstBlock + formatFrom;
+    int firstVisible = qBound(0, (firstVisibleBlock.loadAcquire() - firstFormatted) / BATCH_SIZE, lastIndex);
+    int lastVisible = qBound(firstVisible, (lastVisibleBlock.loadAcquire() - firstFormatted) / BATCH_SIZE, lastIndex);
+
+    for (int index = firstVisible; index <= lastVisible; index++)
+    {
+        if (!batchDone[index])
+        {
+            return index;
+        }
+    }
+
+    for (int distance = 1; distance <= lastIndex; distance++)
+    {
+        if (lastVisible + distance <= lastIndex && !batchDone[lastVisible + distance])
+        {
+            return lastVisible + distance;
+        }
+
+        if (firstVisible - distance >= 0 && !batchDone[firstVisible - distance])
+        {
+            return firstVisible - distance;
+        }
+    }
+
+    return batchDone.indexOf(false);
+}
+
+
+/* Works out the state of every line up to the given one (without their tokens; see Lexer::endState).
+ * Returns false if the worker was interrupted in the meantime.
+ */
+bool HighlightWorker::lexStatesUpTo(int line)
+{
+    while (startStates.size() <= line)
+    {
+        int previous = startStates.size() - 1;
+        startStates.append(grammar->lexer.endState(texts[previous], startStates[previous]));
+
+        if (previous % BATCH_SIZE == 0 && isInterruptionRequested())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
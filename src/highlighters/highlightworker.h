@@ -0,0 +1,83 @@
+#ifndef HIGHLIGHTWORKER_H
+#define HIGHLIGHTWORKER_H
+#include "grammar.h"
+#include <QSharedPointer>
+#include <QThread>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QMetaType>
+#include <QVector>
+
+
+/* The tokens for a run of consecutive lines, as worked out by a HighlightWorker.
+ * The lines' text is included so the GUI can tell if any of them has been edited since.
+ * Lines that were only lexed for the state they end in (see HighlightWorker::setFormatFrom)
+ * have no tokens and are counted by numStateOnly.
+ */
+struct HighlightBatch
+{
+    int generation;
+    int firstBlock;
+    int startState;
+    int numStateOnly = 0;
+    QVector<QString> texts;
+    QVector<QVector<Token>> tokens;
+    QVector<int> endStates;
+};
+
+Q_DECLARE_METATYPE(HighlightBatch)
+
+
+/* Tokenizes a snapshot of a document's lines on a worker thread and hands the results back
+ * in batches of BATCH_SIZE lines. The lines on screen go first, then the batches closest to
+ * them, so what the user is looking at is highlighted first no matter where it is in the file.
+ * The state a batch starts in is only known once every line before it has been lexed, so
+ * lines between the start of the snapshot and the screen are lexed (but not handed over) first.
+ * As with FileLoader, at most MAX_BATCHES_IN_FLIGHT batches are ever waiting to be applied.
+ *
+ * Lines before the one given to setFormatFrom are only needed for the state they end in. They are
+ * handed over first, in order and in larger batches of STATE_BATCH_SIZE lines, with no tokens.
+ */
+class HighlightWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    HighlightWorker(QSharedPointer<const Grammar> grammar, QVector<QString> texts, int firstBlock, int startState, int generation, QObject *parent = nullptr);
+
+    void setVisibleBlocks(int first, int last);
+    void setFormatFrom(int line) { formatFrom = line; }
+    void batchConsumed() { batchesInFlight.release(); }
+
+    const static int BATCH_SIZE = 256;
+    const static int STATE_BATCH_SIZE = 16 * 1024;
+    const static int MAX_BATCHES_IN_FLIGHT = 2;
+
+signals:
+    void batchReady(HighlightBatch batch);
+    void done(int generation);
+
+protected:
+    void run() override;
+
+private:
+    int nextBatch(const QVector<bool> &batchDone) const;
+    bool handOverStates();
+    bool lexStatesUpTo(int line);
+    bool waitForConsumer();
+
+    QSharedPointer<const Grammar> grammar;
+    QVector<QString> texts;
+    int firstBlock;
+    int generation;
+    int formatFrom = 0;
+
+    // startStates[i] is the state line i starts in; only known for the lines lexed so far
+    QVector<int> startStates;
+
+    QAtomicInt firstVisibleBlock;
+    QAtomicInt lastVisibleBlock;
+    QSemaphore batchesInFlight;
+};
+
+#endif // HIGHLIGHTWORKER_H
@@ -0,0 +1,201 @@
+#include "keywordtable.h"
+#include <cstring>
+
+
+/* Builds a table in which every one of the given keywords has a slot to itself. The table
+ * starts out big enough that a collision-free seed is likely (about the number of keywords
+ * squared, halved) and doubles in size until one is found.
+ */
+KeywordTable::KeywordTable(const QStringList &keywords, bool caseInsensitive)
+    : keywords(keywords), caseInsensitive(caseInsensitive)
+{
+    // Folded a character at a time, the way words are when they're looked up
+    if (caseInsensitive)
+    {
+        for (QString &keyword : this->keywords)
+        {
+            for (QChar &character : keyword)
+            {
+                character = character.toCaseFolded();
+            }
+        }
+    }
+
+    this->keywords.removeDuplicates();
+
+    if (this->keywords.isEmpty())
+    {
+        return;
+    }
+
+    shortest = this->keywords.first().length();
+    for (const QString &keyword : this->keywords)
+    {
+        shortest = qMin(shortest, keyword.length());
+        longest = qMax(longest, keyword.length());
+    }
+
+    int tableSize = 1;
+    while (tableSize < this->keywords.size() * this->keywords.size() / 2)
+    {
+        tableSize <<= 1;
+    }
+
+    for (;; tableSize <<= 1)
+    {
+        for (uint candidateSeed = 0; candidateSeed < NUM_SEEDS_TO_TRY; candidateSeed++)
+        {
+            if (tryToFill(tableSize, candidateSeed))
+            {
+                return;
+            }
+        }
+    }
+}
+
+
+/* Returns true if the given word (which need not be null-terminated) is one of the keywords.
+ */
+bool KeywordTable::contains(const QChar *word, int length) const
+{
+    if (length < shortest || length > longest)
+    {
+        return false;
+    }
+
+    int index = table[hash(word, length, seed) & mask];
+    if (index == -1)
+    {
+        return false;
+    }
+
+    const QString &keyword = keywords[index];
+
+    if (keyword.length() != length)
+    {
+        return false;
+    }
+
+    if (!caseInsensitive)
+    {
+        return memcmp(keyword.constData(), word, length * sizeof(QChar)) == 0;
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        if (keyword[i] != word[i].toCaseFolded())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* FNV-1a, with the seed mixed into the starting value. Case-insensitive tables hash the case folded word.
+ */
+uint KeywordTable::hash(const QChar *word, int length, uint seed) const
+{
+    uint hash = 2166136261u ^ (seed * 16777619u);
+
+    for (int i = 0; i < length; i++)
+    {
+        hash ^= caseInsensitive ? word[i].toCaseFolded().unicode() : word[i].unicode();
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+
+/* Places every keyword in a table of the given size (a power of two) using the given seed.
+ * Returns false, leaving the table unusable, if any two keywords land in the same slot.
+ */
+bool KeywordTable::tryToFill(int tableSize, uint candidateSeed)
+{
+    table.fill(-1, tableSize);
+    seed = candidateSeed;
+    mask = static_cast<uint>(tableSize - 1);
+
+    for (int i = 0; i < keywords.size(); i++)
+    {
+        qint16 &slot = table[hash(keywords[i].constData(), keywords[i].length(), seed) & mask];
+
+        if (slot != -1)
+        {
+            return false;
+        }
+
+        slot = static_cast<qint16>(i);
+    }
+
+    return true;
+}
+
+
+/* Returns roughly how many bytes this table takes up, keywords included.
+ */
+int KeywordTable::getMemoryUsage() const
+{
+    int memoryUsage = static_cast<int>(sizeof(KeywordTable) + table.size() * sizeof(qint16));
+
+    for (const QString &keyword : keywords)
+    {
+        memoryUsage += static_cast<int>(sizeof(QString) + keyword.size() * sizeof(QChar));
+    }
+
+    return memoryUsage;
+}
+
+
+/* Returns true if every slot is either empty or refers to a keyword, and a hash masked with
+ * mask always lands in the table, so that contains() can't read out of bounds.
+ */
+bool KeywordTable::isValid() const
+{
+    if (keywords.isEmpty())
+    {
+        return true;
+    }
+
+    if (table.size() != static_cast<qint64>(mask) + 1)
+    {
+        return false;
+    }
+
+    for (qint16 index : table)
+    {
+        if (index < -1 || index >= keywords.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* Writes the given table to a binary stream, slots and seed included.
+ */
+QDataStream &operator<<(QDataStream &out, const KeywordTable &table)
+{
+    return out << table.keywords << table.caseInsensitive << table.table << table.seed << table.mask << table.shortest << table.longest;
+}
+
+
+/* Reads a table back from a binary stream written by operator<<. A table that doesn't hold
+ * together (see isValid) is left empty, and the stream's status set to ReadCorruptData.
+ */
+QDataStream &operator>>(QDataStream &in, KeywordTable &table)
+{
+    in >> table.keywords >> table.caseInsensitive >> table.table >> table.seed >> table.mask >> table.shortest >> table.longest;
+
+    if (in.status() != QDataStream::Ok || !table.isValid())
+    {
+        table = KeywordTable();
+        in.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    return in;
+}
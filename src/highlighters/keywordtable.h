@@ -0,0 +1,45 @@
+#ifndef KEYWORDTABLE_H
+#define KEYWORDTABLE_H
+#include <QStringList>
+#include <QVector>
+#include <QDataStream>
+
+
+/* A perfect hash set of keywords. The table is sized and seeded when it's built so that no
+ * two keywords share a slot, which means that a lookup costs a single hash of the word and
+ * at most one comparison, however many keywords a language has.
+ *
+ * A case-insensitive table keeps its keywords case folded, and folds each character of a
+ * word as it hashes and compares it, so a lookup still costs the same.
+ */
+class KeywordTable
+{
+public:
+    KeywordTable() {}
+    explicit KeywordTable(const QStringList &keywords, bool caseInsensitive = false);
+
+    bool contains(const QChar *word, int length) const;
+    inline QStringList getKeywords() const { return keywords; }
+    inline bool isCaseInsensitive() const { return caseInsensitive; }
+    int getMemoryUsage() const;
+
+    friend QDataStream &operator<<(QDataStream &out, const KeywordTable &table);
+    friend QDataStream &operator>>(QDataStream &in, KeywordTable &table);
+
+    const static int NUM_SEEDS_TO_TRY = 256;
+
+private:
+    uint hash(const QChar *word, int length, uint seed) const;
+    bool tryToFill(int tableSize, uint seed);
+    bool isValid() const;
+
+    QStringList keywords;
+    bool caseInsensitive = false;
+    QVector<qint16> table;
+    uint seed = 0;
+    uint mask = 0;
+    int shortest = 0;
+    int longest = 0;
+};
+
+#endif // KEYWORDTABLE_H
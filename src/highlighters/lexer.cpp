@@ -0,0 +1,466 @@
+#include "lexer.h"
+#include "../bracketmatcher.h"
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+
+// Every raw string terminator seen so far, so a state only has to hold its index (see internTerminator)
+static QMutex terminatorsLock;
+static QStringList terminators;
+
+
+/* Adds the given words (not patterns) to this lexer's keywords.
+ */
+void Lexer::addKeywords(const QStringList &words)
+{
+    keywords = KeywordTable(keywords.getKeywords() + words, keywords.isCaseInsensitive());
+    updateRulesHash();
+}
+
+
+/* Sets whether keywords match regardless of case (as in SQL). Keywords added before are kept.
+ */
+void Lexer::setCaseInsensitiveKeywords(bool caseInsensitive)
+{
+    keywords = KeywordTable(keywords.getKeywords(), caseInsensitive);
+    updateRulesHash();
+}
+
+
+/* Recomputes the hash of everything that decides how this lexer splits a line into tokens.
+ */
+void Lexer::updateRulesHash()
+{
+    QStringList rules = keywords.getKeywords();
+    rules << lineCommentStart << blockCommentStart << blockCommentEnd << quoteCharacters << (tripleQuotedStrings ? "'''" : "")
+          << (nestedBlockComments ? "nested" : "") << QString::number(rawStrings) << (keywords.isCaseInsensitive() ? "caseInsensitive" : "");
+
+    rulesHash = qHash(rules.join('\n'));
+}
+
+
+/* Returns roughly how many bytes this lexer takes up.
+ */
+int Lexer::getMemoryUsage() const
+{
+    int delimiterLength = lineCommentStart.size() + blockCommentStart.size() + blockCommentEnd.size() + quoteCharacters.size();
+    return static_cast<int>(sizeof(Lexer) - sizeof(KeywordTable) + delimiterLength * sizeof(QChar)) + keywords.getMemoryUsage();
+}
+
+
+/* Appends the tokens in the given line of text to tokens (which is cleared first), given the
+ * state the previous line ended in. Returns the state this line ends in.
+ *
+ * An identifier is a keyword if it's in the keyword table, a function if it's followed by an
+ * opening parenthesis, and a class if it starts with a capital letter or an underscore.
+ * Numbers are skipped whole, so the letters in something like 0xFF aren't taken for a name.
+ */
+int Lexer::tokenize(const QString &text, int state, QVector<Token> &tokens) const
+{
+    tokens.clear();
+    const int length = text.length();
+    int i = 0;
+
+    if (state != Normal)
+    {
+        i = continueMultiline(text, 0, 0, state, tokens);
+    }
+
+    while (i < length)
+    {
+        const QChar character = text.at(i);
+
+        if (isIdentifierStart(character))
+        {
+            int start = i;
+            i = endOfWord(text, i);
+            int rawStringStart = rawStrings == NoRawStrings ? -1 : rawStringAt(text, start, i, state);
+
+            if (rawStringStart != -1)
+            {
+                i = continueMultiline(text, start, rawStringStart, state, tokens);
+            }
+            else if (keywords.contains(text.constData() + start, i - start))
+            {
+                tokens.append({start, i - start, Token::Keyword});
+            }
+            else if (i < length && text.at(i) == '(')
+            {
+                tokens.append({start, i - start, Token::Function});
+            }
+            else if ((character >= 'A' && character <= 'Z') || character == '_')
+            {
+                tokens.append({start, i - start, Token::Class});
+            }
+        }
+        else if (character.isDigit())
+        {
+            i = endOfWord(text, i);
+        }
+        else if (!lineCommentStart.isEmpty() && startsWithAt(text, i, lineCommentStart))
+        {
+            tokens.append({i, length - i, Token::Comment});
+            return Normal;
+        }
+        else if (!blockCommentStart.isEmpty() && startsWithAt(text, i, blockCommentStart))
+        {
+            state = packState(InBlockComment, 1);
+            i = continueMultiline(text, i, i + blockCommentStart.length(), state, tokens);
+        }
+        else if (!quoteCharacters.contains(character))
+        {
+            if (BracketMatcher::isBracket(character))
+            {
+                tokens.append({i, 1, Token::Bracket});
+            }
+
+            i++;
+        }
+        else if (tripleQuotedStrings && (startsWithAt(text, i, "'''") || startsWithAt(text, i, "\"\"\"")))
+        {
+            state = character == '\'' ? InTripleSingleQuote : InTripleDoubleQuote;
+            i = continueMultiline(text, i, i + 3, state, tokens);
+        }
+        else
+        {
+            state = packState(InContinuedString, character.unicode());
+            i = continueMultiline(text, i, i + 1, state, tokens);
+        }
+    }
+
+    return state;
+}
+
+
+/* Returns the state the given line ends in, given the state the previous line ended in, without
+ * working out its tokens. Only quotes and comment markers can change the state, so every other
+ * character is skipped without a second look. Used to carry the state forward through lines
+ * that aren't going to be highlighted (yet).
+ */
+int Lexer::endState(const QString &text, int state) const
+{
+    const int length = text.length();
+    int i = 0;
+
+    if (state != Normal)
+    {
+        i = skipMultiline(text, 0, state);
+    }
+
+    while (i < length)
+    {
+        const QChar character = text.at(i);
+
+        // Words only matter if they can start a raw string, and then they must be split up just as tokenize does
+        if (rawStrings != NoRawStrings && isIdentifierPart(character))
+        {
+            int start = i;
+            i = endOfWord(text, i);
+            int rawStringStart = isIdentifierStart(character) ? rawStringAt(text, start, i, state) : -1;
+
+            if (rawStringStart != -1)
+            {
+                i = skipMultiline(text, rawStringStart, state);
+            }
+        }
+        else if (!lineCommentStart.isEmpty() && character == lineCommentStart.at(0) && startsWithAt(text, i, lineCommentStart))
+        {
+            return Normal;
+        }
+        else if (!blockCommentStart.isEmpty() && character == blockCommentStart.at(0) && startsWithAt(text, i, blockCommentStart))
+        {
+            state = packState(InBlockComment, 1);
+            i = skipMultiline(text, i + blockCommentStart.length(), state);
+        }
+        else if (quoteCharacters.contains(character))
+        {
+            if (tripleQuotedStrings && (startsWithAt(text, i, "'''") || startsWithAt(text, i, "\"\"\"")))
+            {
+                state = character == '\'' ? InTripleSingleQuote : InTripleDoubleQuote;
+                i = skipMultiline(text, i + 3, state);
+            }
+            else
+            {
+                state = packState(InContinuedString, character.unicode());
+                i = skipMultiline(text, i + 1, state);
+            }
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return state;
+}
+
+
+/* Emits the multi-line comment or string that starts at the given index (with its contents
+ * starting at contentStart) and returns the index just past its end. If it doesn't end on
+ * this line, it runs to the end of the line (see skipMultiline for the state it leaves).
+ */
+int Lexer::continueMultiline(const QString &text, int start, int contentStart, int &state, QVector<Token> &tokens) const
+{
+    Token::Type type = kindOf(state) == InBlockComment ? Token::Comment : Token::String;
+    int end = skipMultiline(text, contentStart, state);
+
+    tokens.append({start, end - start, type});
+    return end;
+}
+
+
+/* Returns the index just past the end of the comment or string whose contents start at
+ * contentStart, given the state it's in, and resets the state to Normal. If it doesn't end on
+ * this line, returns the length of the line and leaves the state as whatever the next line
+ * starts in.
+ */
+int Lexer::skipMultiline(const QString &text, int contentStart, int &state) const
+{
+    QString terminator;
+
+    switch (kindOf(state))
+    {
+        case (InBlockComment): return skipBlockComment(text, contentStart, state);
+        case (InContinuedString): return skipQuoted(text, contentStart, state);
+        case (InTripleSingleQuote): terminator = "'''"; break;
+        case (InTripleDoubleQuote): terminator = "\"\"\""; break;
+        default: terminator = terminatorAt(payloadOf(state)); break;
+    }
+
+    int terminatorStart = text.indexOf(terminator, contentStart);
+
+    if (terminatorStart == -1)
+    {
+        return text.length();
+    }
+
+    state = Normal;
+    return terminatorStart + terminator.length();
+}
+
+
+/* Like skipMultiline, for a block comment. If block comments can be nested, the state holds how
+ * deeply, and the comment only ends once every comment inside it has.
+ */
+int Lexer::skipBlockComment(const QString &text, int contentStart, int &state) const
+{
+    if (!nestedBlockComments)
+    {
+        int end = text.indexOf(blockCommentEnd, contentStart);
+
+        if (end == -1)
+        {
+            return text.length();
+        }
+
+        state = Normal;
+        return end + blockCommentEnd.length();
+    }
+
+    int depth = qMax(1, payloadOf(state));
+    int i = contentStart;
+
+    while (i < text.length())
+    {
+        if (text.at(i) == blockCommentEnd.at(0) && startsWithAt(text, i, blockCommentEnd))
+        {
+            i += blockCommentEnd.length();
+
+            if (--depth == 0)
+            {
+                state = Normal;
+                return i;
+            }
+        }
+        else if (text.at(i) == blockCommentStart.at(0) && startsWithAt(text, i, blockCommentStart))
+        {
+            i += blockCommentStart.length();
+            depth++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    state = packState(InBlockComment, depth);
+    return text.length();
+}
+
+
+/* Like skipMultiline, for a string in ordinary quotes (the state holds which quote), skipping
+ * escaped characters. A string that isn't closed runs to the end of the line, and only carries
+ * on to the next line if the line ends in a backslash that escapes the line break.
+ */
+int Lexer::skipQuoted(const QString &text, int contentStart, int &state)
+{
+    const QChar quote(static_cast<ushort>(payloadOf(state)));
+    const int length = text.length();
+
+    for (int i = contentStart; i < length; i++)
+    {
+        if (text.at(i) == '\\')
+        {
+            if (i == length - 1)
+            {
+                return length;
+            }
+
+            i++;
+        }
+        else if (text.at(i) == quote)
+        {
+            state = Normal;
+            return i + 1;
+        }
+    }
+
+    state = Normal;
+    return length;
+}
+
+
+/* If the word between prefixStart and prefixEnd is a raw string prefix (e.g., R in C++) and a raw
+ * string starts right after it, points the state at the raw string's terminator and returns the
+ * index its contents start at. Otherwise returns -1 and leaves the state as it is.
+ */
+int Lexer::rawStringAt(const QString &text, int prefixStart, int prefixEnd, int &state) const
+{
+    QStringRef prefix = text.midRef(prefixStart, prefixEnd - prefixStart);
+    const int length = text.length();
+    int i = prefixEnd;
+    QString terminator;
+
+    if (rawStrings == ParenthesizedRawStrings)
+    {
+        bool isPrefix = prefix == "R" || prefix == "LR" || prefix == "uR" || prefix == "UR" || prefix == "u8R";
+
+        if (!isPrefix || i >= length || text.at(i) != '"')
+        {
+            return -1;
+        }
+
+        int openingParenthesis = text.indexOf('(', i + 1);
+        if (openingParenthesis == -1 || openingParenthesis - i - 1 > MAX_RAW_DELIMITER_LENGTH)
+        {
+            return -1;
+        }
+
+        QString delimiter = text.mid(i + 1, openingParenthesis - i - 1);
+        for (QChar character : delimiter)
+        {
+            if (character.isSpace() || character == ')' || character == '\\')
+            {
+                return -1;
+            }
+        }
+
+        terminator = ")" + delimiter + "\"";
+        i = openingParenthesis + 1;
+    }
+    else if (rawStrings == HashedRawStrings)
+    {
+        if (prefix != "r" && prefix != "br")
+        {
+            return -1;
+        }
+
+        while (i < length && text.at(i) == '#')
+        {
+            i++;
+        }
+
+        if (i >= length || text.at(i) != '"')
+        {
+            return -1;
+        }
+
+        terminator = "\"" + QString(i - prefixEnd, '#');
+        i++;
+    }
+    else
+    {
+        return -1;
+    }
+
+    state = packState(InRawString, internTerminator(terminator));
+    return i;
+}
+
+
+/* Returns the index just past the word (identifier or number) that starts at the given index.
+ * Numbers are skipped whole, decimal point and all, so the letters in something like 0xFF
+ * aren't taken for a name.
+ */
+int Lexer::endOfWord(const QString &text, int start)
+{
+    const bool isNumber = text.at(start).isDigit();
+    int i = start + 1;
+
+    while (i < text.length() && (isIdentifierPart(text.at(i)) || (isNumber && text.at(i) == '.')))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+
+/* Returns the index of the given raw string terminator in the table shared by every lexer,
+ * adding it if it's new. Lexers run on worker threads too, so the table is locked.
+ */
+int Lexer::internTerminator(const QString &terminator)
+{
+    QMutexLocker locker(&terminatorsLock);
+    int index = terminators.indexOf(terminator);
+
+    if (index == -1)
+    {
+        index = terminators.size();
+        terminators.append(terminator);
+    }
+
+    return index;
+}
+
+
+/* Returns the raw string terminator at the given index of the shared table (see internTerminator).
+ */
+QString Lexer::terminatorAt(int index)
+{
+    QMutexLocker locker(&terminatorsLock);
+    return terminators.value(index);
+}
+
+
+/* Writes the given lexer's rules to a binary stream (see GrammarRegistry). The keyword table is
+ * written as it is, so reading it back doesn't need to search for a seed again.
+ */
+QDataStream &operator<<(QDataStream &out, const Lexer &lexer)
+{
+    return out << lexer.keywords << lexer.lineCommentStart << lexer.blockCommentStart << lexer.blockCommentEnd
+               << lexer.tripleQuotedStrings << lexer.quoteCharacters << lexer.nestedBlockComments << qint32(lexer.rawStrings);
+}
+
+
+/* Reads a lexer's rules back from a binary stream written by operator<<.
+ */
+QDataStream &operator>>(QDataStream &in, Lexer &lexer)
+{
+    qint32 rawStrings;
+    in >> lexer.keywords >> lexer.lineCommentStart >> lexer.blockCommentStart >> lexer.blockCommentEnd
+       >> lexer.tripleQuotedStrings >> lexer.quoteCharacters >> lexer.nestedBlockComments >> rawStrings;
+
+    lexer.rawStrings = static_cast<Lexer::RawStringSyntax>(rawStrings);
+    lexer.updateRulesHash();
+    return in;
+}
+
+
+/* Returns true if the given text contains the given prefix at the given index.
+ */
+bool Lexer::startsWithAt(const QString &text, int index, const QString &prefix)
+{
+    return text.midRef(index, prefix.length()) == prefix;
+}
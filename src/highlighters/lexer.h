@@ -0,0 +1,116 @@
+#ifndef LEXER_H
+#define LEXER_H
+#include "keywordtable.h"
+#include <QString>
+#include <QVector>
+#include <QDataStream>
+
+
+struct Token
+{
+    enum Type : unsigned char
+    {
+        Keyword,
+        Class,
+        Function,
+        String,
+        Comment,
+        Bracket
+    };
+
+    int start;
+    int length;
+    Type type;
+};
+
+
+/* Splits a line of source code into tokens in a single left-to-right pass. Every character
+ * is looked at once, and what it is decides what it can be the start of, so a keyword in a
+ * comment or a comment marker in a string is never mistaken for anything else. Only the
+ * tokens that get highlighted (plus brackets, for BracketMatcher) are emitted.
+ *
+ * The lexer has no state of its own besides its rules, so the same Lexer can be used for
+ * any number of lines at once. Constructs that span lines are carried from one line to the next
+ * through the state a line ends in, which is a single int (so that it fits in a block's user
+ * state) and is Normal outside of any such construct. Its low STATE_KIND_BITS bits say what kind
+ * of construct the line ends inside of, and the rest whatever it takes to pick up where it left
+ * off: how deeply nested a block comment is, which quote a string continued with a backslash was
+ * opened with, or which terminator closes a raw string. Raw string terminators can be too long to
+ * pack, so they're interned in a table shared by every lexer and the state holds their index in it.
+ *
+ * Two lines end in the same state only if every line after them lexes the same, which is what
+ * lets highlighting stop as soon as an edit no longer changes the state a line ends in.
+ */
+class Lexer
+{
+public:
+    enum State
+    {
+        Normal = 0,
+        InBlockComment = 1,
+        InTripleSingleQuote = 2,
+        InTripleDoubleQuote = 3,
+        InContinuedString = 4,
+        InRawString = 5
+    };
+
+    enum RawStringSyntax
+    {
+        NoRawStrings,
+        ParenthesizedRawStrings,    // C++: R"delimiter(...)delimiter"
+        HashedRawStrings            // Rust: r#"..."#
+    };
+
+    void addKeywords(const QStringList &words);
+    void setCaseInsensitiveKeywords(bool caseInsensitive);
+    void setLineCommentStart(QString start) { lineCommentStart = start; updateRulesHash(); }
+    void setBlockCommentDelimiters(QString start, QString end) { blockCommentStart = start; blockCommentEnd = end; updateRulesHash(); }
+    void setTripleQuotedStrings(bool allowed) { tripleQuotedStrings = allowed; updateRulesHash(); }
+    void setQuoteCharacters(QString quotes) { quoteCharacters = quotes; updateRulesHash(); }
+    void setNestedBlockComments(bool allowed) { nestedBlockComments = allowed; updateRulesHash(); }
+    void setRawStrings(RawStringSyntax syntax) { rawStrings = syntax; updateRulesHash(); }
+
+    // Two lexers with the same rules produce the same tokens (see TokenCache)
+    uint getRulesHash() const { return rulesHash; }
+    int getMemoryUsage() const;
+
+    friend QDataStream &operator<<(QDataStream &out, const Lexer &lexer);
+    friend QDataStream &operator>>(QDataStream &in, Lexer &lexer);
+
+    int tokenize(const QString &text, int state, QVector<Token> &tokens) const;
+    int endState(const QString &text, int state) const;
+
+    const static int STATE_KIND_BITS = 4;
+    const static int STATE_KIND_MASK = (1 << STATE_KIND_BITS) - 1;
+    const static int MAX_STATE_PAYLOAD = (1 << (31 - STATE_KIND_BITS)) - 1;
+    const static int MAX_RAW_DELIMITER_LENGTH = 16;
+
+private:
+    void updateRulesHash();
+    int continueMultiline(const QString &text, int start, int contentStart, int &state, QVector<Token> &tokens) const;
+    int skipMultiline(const QString &text, int contentStart, int &state) const;
+    int skipBlockComment(const QString &text, int contentStart, int &state) const;
+    int rawStringAt(const QString &text, int prefixStart, int prefixEnd, int &state) const;
+    static int skipQuoted(const QString &text, int contentStart, int &state);
+    static int endOfWord(const QString &text, int start);
+    static int packState(int kind, int payload) { return kind | (qMin(payload, static_cast<int>(MAX_STATE_PAYLOAD)) << STATE_KIND_BITS); }
+    static int kindOf(int state) { return state & STATE_KIND_MASK; }
+    static int payloadOf(int state) { return state >> STATE_KIND_BITS; }
+    static int internTerminator(const QString &terminator);
+    static QString terminatorAt(int index);
+    static bool startsWithAt(const QString &text, int index, const QString &prefix);
+    static bool isIdentifierStart(QChar character) { return character.isLetter() || character == '_'; }
+    static bool isIdentifierPart(QChar character) { return character.isLetterOrNumber() || character == '_'; }
+
+    KeywordTable keywords;
+    QString lineCommentStart;
+    QString blockCommentStart;
+    QString blockCommentEnd;
+    bool tripleQuotedStrings = false;
+    QString quoteCharacters = "\"'";
+    bool nestedBlockComments = false;
+    RawStringSyntax rawStrings = NoRawStrings;
+    uint rulesHash = 0;
+};
+
+#endif // LEXER_H
@@ -0,0 +1,21 @@
+#ifndef STYLEDRANGE_H
+#define STYLEDRANGE_H
+#include <QtGlobal>
+
+
+/* A highlighted stretch of a line, packed into 8 bytes. The style is a Token::Type, whose format
+ * every language shares (see Grammar::formatFor), so a line's formats are only worked out from its
+ * ranges while it's on screen. Tokens longer than MAX_LENGTH are split into several ranges.
+ */
+struct StyledRange
+{
+    qint32 start;
+    quint32 length : 24;
+    quint32 style : 8;
+
+    bool operator==(const StyledRange &other) const { return start == other.start && length == other.length && style == other.style; }
+
+    const static int MAX_LENGTH = (1 << 24) - 1;
+};
+
+#endif // STYLEDRANGE_H
@@ -0,0 +1,68 @@
+#include "tokencache.h"
+
+
+/* Returns the cache shared by every Highlighter.
+ */
+TokenCache &TokenCache::instance()
+{
+    static TokenCache tokenCache;
+    return tokenCache;
+}
+
+
+/* Initializes an empty cache.
+ */
+TokenCache::TokenCache()
+{
+    cache.setMaxCost(MAX_SIZE);
+}
+
+
+/* Returns the cached highlighting of the given line, or nullptr if it isn't cached. A line that's
+ * found becomes the most recently used one. The pointer is only valid until the next insert.
+ */
+const HighlightedLine *TokenCache::find(const QString &text, int startState, uint rules)
+{
+    const HighlightedLine *line = cache.object({text, startState, rules});
+
+    if (line)
+    {
+        hits++;
+    }
+    else
+    {
+        misses++;
+    }
+
+    return line;
+}
+
+
+/* Caches the highlighting of the given line, evicting the least recently used lines if needed.
+ * The cost of a line is roughly how many bytes it takes up.
+ */
+void TokenCache::insert(const QString &text, int startState, uint rules, const HighlightedLine &line)
+{
+    int cost = static_cast<int>(sizeof(Key) + sizeof(HighlightedLine) + text.size() * sizeof(QChar) +
+                                line.ranges.size() * sizeof(StyledRange) +
+                                line.bracketPositions.size() * sizeof(int));
+
+    cache.insert({text, startState, rules}, new HighlightedLine(line), cost);
+}
+
+
+/* Returns true if both keys are for the same line, state and rules. The hashes of two different
+ * lines can collide, so the text has to be compared too.
+ */
+bool TokenCache::Key::operator==(const Key &other) const
+{
+    return startState == other.startState && rules == other.rules && text == other.text;
+}
+
+
+/* Hashes a line's key for the cache.
+ */
+uint qHash(const TokenCache::Key &key, uint seed)
+{
+    return qHash(key.text, seed) ^ (uint(key.startState) * 0x9E3779B9u) ^ key.rules;
+}
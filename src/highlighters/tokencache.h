@@ -0,0 +1,65 @@
+#ifndef TOKENCACHE_H
+#define TOKENCACHE_H
+#include <QCache>
+#include <QString>
+#include <QVector>
+#include "styledrange.h"
+
+
+/* A line's highlighting, ready to be applied to its block as is (see Highlighter::apply).
+ */
+struct HighlightedLine
+{
+    QVector<StyledRange> ranges;
+    QVector<int> bracketPositions;
+    int endState;
+};
+
+
+/* Remembers the highlighting of recently highlighted lines, keyed by their text, the state the line
+ * before them ended in and the rules they were lexed with (see Lexer::getRulesHash). Undo, redo
+ * and Replace All hand the highlighter lines it has already seen, and generated code and logs
+ * repeat the same lines over and over; any of those lines is highlighted with a single hash
+ * lookup. The least recently used lines are evicted once the cache holds more than MAX_SIZE
+ * bytes' worth of them.
+ *
+ * The cache is shared by every Highlighter, and so must only be used from the GUI thread. Only
+ * lines the GUI thread lexes itself (see Highlighter::highlight) go into it; the lines of a whole
+ * file that a HighlightWorker lexed would cost a hash and a copy each on the GUI thread, and
+ * would push the lines being edited out.
+ */
+class TokenCache
+{
+public:
+    static TokenCache &instance();
+
+    const HighlightedLine *find(const QString &text, int startState, uint rules);
+    void insert(const QString &text, int startState, uint rules, const HighlightedLine &line);
+
+    int getHits() const { return hits; }
+    int getMisses() const { return misses; }
+    int getNumLines() const { return cache.count(); }
+    int getSize() const { return cache.totalCost(); }
+
+    const static int MAX_SIZE = 16 * 1024 * 1024;
+
+private:
+    TokenCache();
+
+    struct Key
+    {
+        QString text;
+        int startState;
+        uint rules;
+
+        bool operator==(const Key &other) const;
+    };
+
+    friend uint qHash(const Key &key, uint seed);
+
+    QCache<Key, HighlightedLine> cache;
+    int hits = 0;
+    int misses = 0;
+};
+
+#endif // TOKENCACHE_H
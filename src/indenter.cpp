@@ -0,0 +1,126 @@
+#include "indenter.h"
+#include <QTextBlock>
+
+
+/* Returns the indentation for a line broken off at the cursor, given the text before the cursor.
+ * That's the current line's indentation, one level deeper after a code block start (like an
+ * opening brace in C++), or one level shallower after a line that ends a block in languages
+ * without an end delimiter (like a return statement in Python).
+ */
+QString Indenter::indentationAfter(const QString &textBeforeCursor, Highlighter *highlighter) const
+{
+    QString indentation = leadingWhitespaceOf(textBeforeCursor);
+
+    if (codeBlockStartIn(textBeforeCursor, highlighter) != -1)
+    {
+        return indented(indentation);
+    }
+
+    if (highlighter && !highlighter->getDedentPattern().pattern().isEmpty() &&
+        highlighter->getDedentPattern().match(textBeforeCursor).hasMatch())
+    {
+        return dedented(indentation);
+    }
+
+    return indentation;
+}
+
+
+/* Returns the given indentation one level deeper.
+ */
+QString Indenter::indented(const QString &indentation) const
+{
+    return indentation + indentUnit;
+}
+
+
+/* Returns the given indentation one level shallower. Indentation that doesn't end in a
+ * whole level (say, three spaces when a level is four) loses whatever partial level it has.
+ */
+QString Indenter::dedented(const QString &indentation) const
+{
+    if (indentation.endsWith(indentUnit))
+    {
+        return indentation.left(indentation.length() - indentUnit.length());
+    }
+
+    if (indentation.endsWith('\t'))
+    {
+        return indentation.left(indentation.length() - 1);
+    }
+
+    int end = indentation.length();
+    while (end > 0 && indentation.length() - end < indentUnit.length() && indentation.at(end - 1) == ' ')
+    {
+        end--;
+    }
+
+    return indentation.left(end);
+}
+
+
+/* Returns the tabs and spaces at the start of the given line.
+ */
+QString Indenter::leadingWhitespaceOf(const QString &line)
+{
+    int length = 0;
+
+    while (length < line.length() && (line.at(length) == '\t' || line.at(length) == ' '))
+    {
+        length++;
+    }
+
+    return line.left(length);
+}
+
+
+/* Returns the index of the highlighter's code block start delimiter if the text before the cursor
+ * ends with it (ignoring any trailing whitespace), and -1 otherwise.
+ */
+int Indenter::codeBlockStartIn(const QString &textBeforeCursor, Highlighter *highlighter)
+{
+    if (!highlighter)
+    {
+        return -1;
+    }
+
+    int last = textBeforeCursor.length() - 1;
+    while (last >= 0 && textBeforeCursor.at(last).isSpace())
+    {
+        last--;
+    }
+
+    return last >= 0 && textBeforeCursor.at(last) == highlighter->getCodeBlockStartDelimiter() ? last : -1;
+}
+
+
+/* Guesses whether the given document is indented with tabs or spaces by looking at its first
+ * NUM_LINES_TO_SAMPLE lines, and returns one level of that indentation. For spaces, a level
+ * is taken to be the shallowest indentation any of those lines has.
+ */
+QString Indenter::detectIndentUnit(QTextDocument *document)
+{
+    int numLinesWithTabs = 0;
+    int numLinesWithSpaces = 0;
+    int fewestSpaces = 0;
+    int numLinesSampled = 0;
+
+    for (QTextBlock block = document->begin(); block.isValid() && numLinesSampled < NUM_LINES_TO_SAMPLE; block = block.next())
+    {
+        QString indentation = leadingWhitespaceOf(block.text());
+        numLinesSampled++;
+
+        if (indentation.startsWith('\t'))
+        {
+            numLinesWithTabs++;
+        }
+        else if (indentation.length() > 1 && indentation.length() < block.length() - 1)
+        {
+            // A lone space is more likely alignment (like in a block comment) than indentation
+            numLinesWithSpaces++;
+            fewestSpaces = fewestSpaces == 0 ? indentation.length() : qMin(fewestSpaces, indentation.length());
+        }
+    }
+
+    return numLinesWithSpaces > numLinesWithTabs ? QString(fewestSpaces, ' ') : QString("\t");
+}
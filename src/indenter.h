@@ -0,0 +1,32 @@
+#ifndef INDENTER_H
+#define INDENTER_H
+#include "highlighters/highlighter.h"
+#include <QString>
+#include <QTextDocument>
+
+
+/* Works out how far a new line should be indented. Only the line the cursor is on is ever
+ * looked at, so this costs time proportional to that line, whatever the size of the file.
+ * One level of indentation is either a tab or a fixed number of spaces (see detectIndentUnit).
+ */
+class Indenter
+{
+public:
+    inline QString getIndentUnit() const { return indentUnit; }
+    inline void setIndentUnit(QString unit) { indentUnit = unit; }
+
+    QString indentationAfter(const QString &textBeforeCursor, Highlighter *highlighter) const;
+    QString indented(const QString &indentation) const;
+    QString dedented(const QString &indentation) const;
+
+    static QString leadingWhitespaceOf(const QString &line);
+    static int codeBlockStartIn(const QString &textBeforeCursor, Highlighter *highlighter);
+    static QString detectIndentUnit(QTextDocument *document);
+
+    const static int NUM_LINES_TO_SAMPLE = 1000;
+
+private:
+    QString indentUnit = "\t";
+};
+
+#endif // INDENTER_H
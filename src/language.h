@@ -4,15 +4,11 @@
 
 namespace ProgrammingLanguage
 {
-    // Four common programming languages
-    enum Language
-    {
-        None,
-        CPP,
-        C,
-        Python,
-        Java
-    };
+    // Languages are known by the names they're defined with (see GrammarRegistry)
+    typedef QString Language;
+
+    // Plain text, which isn't highlighted
+    const Language NO_LANGUAGE;
 
     QString toString(Language language);
 }
@@ -1,18 +1,22 @@
 #ifndef LINENUMBERAREA_H
 #define LINENUMBERAREA_H
-#include "editor.h"
+#include <QWidget>
 
+/* The gutter shown to the left of any text view that numbers its lines (Editor, FileViewer).
+ * The view does the actual painting via getLineNumberAreaWidth and lineNumberAreaPaintEvent.
+ */
+template <class View>
 class LineNumberArea : public QWidget
 {
 public:
-    LineNumberArea(Editor *editor) : QWidget(editor) { this->editor = editor; }
-    QSize sizeHint() const override { return QSize(editor->getLineNumberAreaWidth(), 0); }
+    LineNumberArea(View *view) : QWidget(view) { this->view = view; }
+    QSize sizeHint() const override { return QSize(view->getLineNumberAreaWidth(), 0); }
 
 protected:
-    void paintEvent(QPaintEvent *event) override { editor->lineNumberAreaPaintEvent(event); }
+    void paintEvent(QPaintEvent *event) override { view->lineNumberAreaPaintEvent(event); }
 
 private:
-    Editor *editor;
+    View *view;
 };
 
 #endif // LINENUMBERAREA_H
@@ -0,0 +1,21 @@
+#include "loadprogress.h"
+#include <QHBoxLayout>
+
+
+LoadProgress::LoadProgress(QWidget *parent) : QFrame(parent)
+{
+    // Note: since these get added as widgets, they will be deallocated automatically by the QFrame destructor
+    progressBar = new QProgressBar();
+    progressBar->setRange(0, 100);
+    cancelButton = new QPushButton(tr("Cancel"));
+
+    QHBoxLayout *layout = new QHBoxLayout();
+    layout->addWidget(progressBar);
+    layout->addWidget(cancelButton);
+    setLayout(layout);
+
+    setFrameShape(QFrame::StyledPanel);
+    setAutoFillBackground(true);
+
+    connect(cancelButton, SIGNAL(clicked()), this, SIGNAL(canceled()));
+}
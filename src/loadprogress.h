@@ -0,0 +1,29 @@
+#ifndef LOADPROGRESS_H
+#define LOADPROGRESS_H
+#include <QFrame>
+#include <QProgressBar>
+#include <QPushButton>
+
+
+/* Small progress bar with a Cancel button that an Editor shows over
+ * its bottom-right corner while a file is loading into it.
+ */
+class LoadProgress : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit LoadProgress(QWidget *parent = nullptr);
+
+signals:
+    void canceled();
+
+public slots:
+    void setProgress(int percent) { progressBar->setValue(percent); }
+
+private:
+    QProgressBar *progressBar;
+    QPushButton *cancelButton;
+};
+
+#endif // LOADPROGRESS_H
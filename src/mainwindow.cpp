@@ -2,16 +2,19 @@
 #include "utilityfunctions.h"
 #include "ui_mainwindow.h"
 #include "settings.h"                   // storing app state
+#include "highlighters/tokencache.h"
+#include "highlighters/grammarregistry.h"
 #include <QtDebug>
 #include <QtPrintSupport/QPrinter>      // printing
 #include <QtPrintSupport/QPrintDialog>  // printing
 #include <QFileDialog>                  // file open/save dialogs
 #include <QFile>                        // file descriptors, IO
-#include <QTextStream>                  // file IO
+#include <QFileInfo>
 #include <QStandardPaths>               // default open directory
 #include <QDateTime>                    // current time
 #include <QApplication>                 // quit
 #include <QShortcut>
+#include <algorithm>
 
 
 /* Sets up the main application window and all of its children/widgets.
@@ -24,10 +27,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     // Used to ensure that only one language can ever be checked at a time
     languageGroup = new QActionGroup(this);
     languageGroup->setExclusive(true);
-    languageGroup->addAction(ui->actionC_Lang);
-    languageGroup->addAction(ui->actionCPP_Lang);
-    languageGroup->addAction(ui->actionJava_Lang);
-    languageGroup->addAction(ui->actionPython_Lang);
+    populateLanguageMenu();
     connect(languageGroup, SIGNAL(triggered(QAction*)), this, SLOT(on_languageSelected(QAction*)));
     // Language label frame
     setupLanguageOnStatusBar();
@@ -36,6 +36,23 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     findDialog = new FindDialog();
     findDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
 
+    // Searches across tabs are started from the find dialog, whichever tab is current
+    connect(findDialog, SIGNAL(startFindingInTabs(QString, bool, bool, bool)), this, SLOT(findInOpenTabs(QString, bool, bool, bool)));
+    connect(findDialog, SIGNAL(startReplacingInTabs(QString, QString, bool, bool, bool)), this, SLOT(replaceInOpenTabs(QString, QString, bool, bool, bool)));
+    connect(findDialog, SIGNAL(queryChanged()), this, SLOT(cancelTabSearch()));
+
+    // Set up the panel that lists the results of searches across tabs
+    resultsPanel = new SearchResultsPanel(this);
+    addDockWidget(Qt::BottomDockWidgetArea, resultsPanel);
+    resultsPanel->hide();
+    connect(resultsPanel, SIGNAL(matchActivated(int, int, int)), this, SLOT(on_searchResultActivated(int, int, int)));
+
+    // Set up the panel that searches the files in a folder
+    findInFilesPanel = new FindInFilesPanel(this);
+    addDockWidget(Qt::BottomDockWidgetArea, findInFilesPanel);
+    findInFilesPanel->hide();
+    connect(findInFilesPanel, SIGNAL(fileHitActivated(QString, int, int)), this, SLOT(openFileAt(QString, int, int)));
+
     // Set up the goto dialog
     gotoDialog = new GotoDialog();
     gotoDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
@@ -65,8 +82,6 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     // For word wrap and auto indent
     matchFormatOptionsToEditorDefaults();
 
-    mapMenuLanguageOptionToLanguageType();
-    mapFileExtensionsToLanguages();
     appendShortcutsToToolbarTooltips();
 }
 
@@ -109,27 +124,18 @@ void MainWindow::setupLanguageOnStatusBar()
 }
 
 
-/* Maps each menu language option (from the Format dropdown) to its corresponding
- * Language type, for convenience.
+/* Adds an option to the Format > Language menu for every language that can be highlighted
+ * (see GrammarRegistry), and maps each option to its language, for convenience.
  */
-void MainWindow::mapMenuLanguageOptionToLanguageType()
+void MainWindow::populateLanguageMenu()
 {
-    menuActionToLanguageMap[ui->actionC_Lang] = Language::C;
-    menuActionToLanguageMap[ui->actionCPP_Lang] = Language::CPP;
-    menuActionToLanguageMap[ui->actionJava_Lang] = Language::Java;
-    menuActionToLanguageMap[ui->actionPython_Lang] = Language::Python;
-}
-
-
-/* Maps known file extensions to the languages the editor supports.
- */
-void MainWindow::mapFileExtensionsToLanguages()
-{
-    extensionToLanguageMap.insert("cpp", Language::CPP);
-    extensionToLanguageMap.insert("h", Language::CPP);
-    extensionToLanguageMap.insert("c", Language::C);
-    extensionToLanguageMap.insert("java", Language::Java);
-    extensionToLanguageMap.insert("py", Language::Python);
+    for (const Language &language : GrammarRegistry::instance().getLanguages())
+    {
+        QAction *languageAction = ui->menuLanguage->addAction(language);
+        languageAction->setCheckable(true);
+        languageGroup->addAction(languageAction);
+        menuActionToLanguageMap[languageAction] = language;
+    }
 }
 
 
@@ -146,6 +152,7 @@ void MainWindow::appendShortcutsToToolbarTooltips()
  */
 MainWindow::~MainWindow()
 {
+    delete tabSearch;
     delete languageLabel;
     delete languageGroup;
     delete ui;
@@ -162,72 +169,27 @@ void MainWindow::on_languageSelected(QAction* languageAction)
 }
 
 
-/* Given a Language enum, this function checks the corresponding radio option from the Format > Language
+/* Given a language, this function checks the corresponding radio option from the Format > Language
  * menu. Used by on_currentTabChanged to reflect the current tab's selected language.
  */
 void MainWindow::triggerCorrespondingMenuLanguageOption(Language lang)
 {
-    switch (lang)
-    {
-        case (Language::C):
-            if (!ui->actionC_Lang->isChecked())
-            {
-                ui->actionC_Lang->trigger();
-            }
-            break;
+    QAction *languageAction = menuActionToLanguageMap.key(lang, nullptr);
 
-        case (Language::CPP):
-            if (!ui->actionCPP_Lang->isChecked())
-            {
-                ui->actionCPP_Lang->trigger();
-            }
-            break;
-
-        case (Language::Java):
-            if (!ui->actionJava_Lang->isChecked())
-            {
-                ui->actionJava_Lang->trigger();
-            }
-            break;
-
-        case (Language::Python):
-            if (!ui->actionPython_Lang->isChecked())
-            {
-                ui->actionPython_Lang->trigger();
-            }
-            break;
-
-        default: return;
+    if (languageAction && !languageAction->isChecked())
+    {
+        languageAction->trigger();
     }
 }
 
 
 /* Uses the extension of a file to determine what language, if any, it should be
  * mapped to. If the extension does not match one of the supported languages, or if
- * the file does not have an extension, then the language is set to Language::None.
+ * the file does not have an extension, then the language is set to NO_LANGUAGE.
  */
 void MainWindow::setLanguageFromExtension()
 {
-    QString fileName = editor->getFileName();
-    int indexOfDot = fileName.indexOf('.');
-
-    if (indexOfDot == -1)
-    {
-        selectProgrammingLanguage(Language::None);
-        return;
-    }
-
-    QString fileExtension = fileName.mid(indexOfDot + 1);
-
-    bool extensionSupported = extensionToLanguageMap.find(fileExtension) != extensionToLanguageMap.end();
-
-    if (!extensionSupported)
-    {
-        selectProgrammingLanguage(Language::None);
-        return;
-    }
-
-    selectProgrammingLanguage(extensionToLanguageMap[fileExtension]);
+    selectProgrammingLanguage(GrammarRegistry::instance().languageOf(editor->getFileName()));
 }
 
 
@@ -252,11 +214,16 @@ void MainWindow::selectProgrammingLanguage(Language language)
  */
 void MainWindow::disconnectEditorDependentSignals()
 {
-    disconnect(findDialog, SIGNAL(startFinding(QString, bool, bool)), editor, SLOT(find(QString, bool, bool)));
-    disconnect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool)));
-    disconnect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool)));
-    disconnect(gotoDialog, SIGNAL(gotoLine(int)), editor, SLOT(goTo(int)));
+    disconnect(findDialog, SIGNAL(startFinding(QString, bool, bool, bool)), editor, SLOT(find(QString, bool, bool, bool)));
+    disconnect(findDialog, SIGNAL(startFindingAll(QString, bool, bool, bool)), editor, SLOT(findAll(QString, bool, bool, bool)));
+    disconnect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool, bool)));
+    disconnect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool, bool)));
+    disconnect(gotoDialog, SIGNAL(gotoLine(int, int)), editor, SLOT(goTo(int, int)));
+    disconnect(gotoDialog, SIGNAL(gotoOffset(qint64)), editor, SLOT(goToOffset(qint64)));
+    disconnect(gotoDialog, SIGNAL(gotoPercent(int)), editor, SLOT(goToPercent(int)));
+    disconnect(findDialog, SIGNAL(queryChanged()), editor, SLOT(cancelSearch()));
     disconnect(editor, SIGNAL(findResultReady(QString)), findDialog, SLOT(onFindResultReady(QString)));
+    disconnect(editor, SIGNAL(searchProgress(QString)), findDialog, SLOT(onSearchProgress(QString)));
     disconnect(editor, SIGNAL(gotoResultReady(QString)), gotoDialog, SLOT(onGotoResultReady(QString)));
 
     disconnect(editor, SIGNAL(wordCountChanged(int)), metricReporter, SLOT(updateWordCount(int)));
@@ -264,6 +231,7 @@ void MainWindow::disconnectEditorDependentSignals()
     disconnect(editor, SIGNAL(lineCountChanged(int, int)), metricReporter, SLOT(updateLineCount(int, int)));
     disconnect(editor, SIGNAL(columnCountChanged(int)), metricReporter, SLOT(updateColumnCount(int)));
     disconnect(editor, SIGNAL(fileContentsChanged()), this, SLOT(updateTabAndWindowTitle()));
+    disconnect(editor, SIGNAL(saveFinished(bool)), this, SLOT(on_saveFinished(bool)));
 
     disconnect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(toggleUndo(bool)));
     disconnect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(toggleRedo(bool)));
@@ -276,11 +244,16 @@ void MainWindow::disconnectEditorDependentSignals()
  */
 void MainWindow::reconnectEditorDependentSignals()
 {
-    connect(findDialog, SIGNAL(startFinding(QString, bool, bool)), editor, SLOT(find(QString, bool, bool)));
-    connect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool)));
-    connect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool)));
-    connect(gotoDialog, SIGNAL(gotoLine(int)), editor, SLOT(goTo(int)));
+    connect(findDialog, SIGNAL(startFinding(QString, bool, bool, bool)), editor, SLOT(find(QString, bool, bool, bool)));
+    connect(findDialog, SIGNAL(startFindingAll(QString, bool, bool, bool)), editor, SLOT(findAll(QString, bool, bool, bool)));
+    connect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool, bool)));
+    connect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool, bool)));
+    connect(gotoDialog, SIGNAL(gotoLine(int, int)), editor, SLOT(goTo(int, int)));
+    connect(gotoDialog, SIGNAL(gotoOffset(qint64)), editor, SLOT(goToOffset(qint64)));
+    connect(gotoDialog, SIGNAL(gotoPercent(int)), editor, SLOT(goToPercent(int)));
+    connect(findDialog, SIGNAL(queryChanged()), editor, SLOT(cancelSearch()));
     connect(editor, SIGNAL(findResultReady(QString)), findDialog, SLOT(onFindResultReady(QString)));
+    connect(editor, SIGNAL(searchProgress(QString)), findDialog, SLOT(onSearchProgress(QString)));
     connect(editor, SIGNAL(gotoResultReady(QString)), gotoDialog, SLOT(onGotoResultReady(QString)));
 
     connect(editor, SIGNAL(wordCountChanged(int)), metricReporter, SLOT(updateWordCount(int)));
@@ -288,6 +261,7 @@ void MainWindow::reconnectEditorDependentSignals()
     connect(editor, SIGNAL(lineCountChanged(int, int)), metricReporter, SLOT(updateLineCount(int, int)));
     connect(editor, SIGNAL(columnCountChanged(int)), metricReporter, SLOT(updateColumnCount(int)));
     connect(editor, SIGNAL(fileContentsChanged()), this, SLOT(updateTabAndWindowTitle()));
+    connect(editor, SIGNAL(saveFinished(bool)), this, SLOT(on_saveFinished(bool)));
 
     connect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(toggleUndo(bool)));
     connect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(toggleRedo(bool)));
@@ -314,12 +288,15 @@ void MainWindow::on_currentTabChanged(int index)
 
     editor = tabbedEditor->currentTab();
     reconnectEditorDependentSignals();
+
+    // Any search still being reported on belongs to the previous tab
+    findDialog->onSearchProgress(QString());
     editor->setFocus(Qt::FocusReason::TabFocusReason);
 
     Language tabLanguage = editor->getProgrammingLanguage();
 
     // If this tab had a programming language set, trigger the corresponding option
-    if (tabLanguage != Language::None)
+    if (tabLanguage != NO_LANGUAGE)
     {
         triggerCorrespondingMenuLanguageOption(tabLanguage);
     }
@@ -422,13 +399,27 @@ void MainWindow::on_actionNew_triggered()
 
 
 /* Called when the user selects the Save or Save As option from the menu or toolbar
- * (or uses Ctrl+S). On success, saves the contents of the text editor to the disk using
+ * (or uses Ctrl+S). Starts saving the contents of the text editor to the disk using
  * the file name provided by the user. If the current document was never saved, or if the
  * user chose Save As, the program prompts the user to specify a name and directory for the file.
- * Returns true if the file was saved and false otherwise.
+ * Returns true if the save was started and false otherwise. The save itself finishes in the
+ * background (see Editor::save and on_saveFinished).
  */
 bool MainWindow::on_actionSaveTriggered()
 {
+    // Saving now would write out only the part of the file that has loaded so far
+    if (editor->isLoading())
+    {
+        ui->statusBar->showMessage("Wait for the file to finish loading before saving", 2000);
+        return false;
+    }
+
+    if (editor->isSaving())
+    {
+        ui->statusBar->showMessage("This document is already being saved", 2000);
+        return false;
+    }
+
     bool saveAs = sender() == ui->actionSave_As;
     QString currentFilePath = editor->getCurrentFilePath();
 
@@ -449,23 +440,9 @@ bool MainWindow::on_actionSaveTriggered()
         editor->setCurrentFilePath(filePath);
     }
 
-    // Attempt to create a file descriptor with the given path
-    QFile file(editor->getCurrentFilePath());
-    if (!file.open(QIODevice::WriteOnly | QFile::Text))
-    {
-        QMessageBox::warning(this, "Warning", "Cannot save file: " + file.errorString());
-        return false;
-    }
-
-    ui->statusBar->showMessage("Document saved", 2000);
-
-    // Save the contents of the editor to the disk and close the file descriptor
-    QTextStream out(&file);
-    QString editorContents = editor->toPlainText();
-    out << editorContents;
-    file.close();
-
-    editor->setModifiedState(false);
+    // The editor writes the file in the background; see on_saveFinished for the outcome
+    ui->statusBar->showMessage("Saving...");
+    editor->save(editor->getCurrentFilePath());
     updateTabAndWindowTitle();
     setLanguageFromExtension();
 
@@ -473,62 +450,172 @@ bool MainWindow::on_actionSaveTriggered()
 }
 
 
-/* Called when the user selects the Open option from the menu or toolbar
- * (or uses Ctrl+O). If the current document has unsaved changes, it first
- * asks the user if they want to save. In any case, it launches a dialog box
- * that allows the user to select the file they want to open. Sets the editor's
- * current file path to that of the opened file on success and updates the app state.
+/* Called when the current editor finishes saving its document.
  */
-void MainWindow::on_actionOpen_triggered()
+void MainWindow::on_saveFinished(bool succeeded)
 {
-    // Used to switch to a new tab if there's already an open doc
-    bool openInCurrentTab = editor->isUntitled() && !editor->isUnsaved();
+    if (succeeded)
+    {
+        ui->statusBar->showMessage("Document saved", 2000);
+    }
+    else
+    {
+        ui->statusBar->clearMessage();
+    }
+
+    updateTabAndWindowTitle();
+}
 
+
+/* Launches a file dialog in the most recently used directory so the user can pick a file to open.
+ * Returns the path of the selected file, or a null string if the user hit Cancel. Remembers the
+ * directory of the selected file for next time.
+ */
+QString MainWindow::promptForFileToOpen(QString dialogTitle)
+{
     QString openedFilePath;
     QString lastUsedDirectory = settings->value(DEFAULT_DIRECTORY_KEY).toString();
 
     if (lastUsedDirectory.isEmpty())
     {
-        openedFilePath = QFileDialog::getOpenFileName(this, tr("Open"), DEFAULT_DIRECTORY);
+        openedFilePath = QFileDialog::getOpenFileName(this, dialogTitle, DEFAULT_DIRECTORY);
     }
     else
     {
-        openedFilePath = QFileDialog::getOpenFileName(this, tr("Open"), lastUsedDirectory);
+        openedFilePath = QFileDialog::getOpenFileName(this, dialogTitle, lastUsedDirectory);
+    }
+
+    // Update the recently used directory
+    if (!openedFilePath.isNull())
+    {
+        QDir currentDirectory;
+        settings->setValue(DEFAULT_DIRECTORY_KEY, currentDirectory.absoluteFilePath(openedFilePath));
     }
 
+    return openedFilePath;
+}
+
+
+/* Called when the user selects the Open option from the menu or toolbar
+ * (or uses Ctrl+O). If the current document has unsaved changes, it first
+ * asks the user if they want to save. In any case, it launches a dialog box
+ * that allows the user to select the file they want to open. Sets the editor's
+ * current file path to that of the opened file on success and updates the app state.
+ */
+void MainWindow::on_actionOpen_triggered()
+{
+    QString openedFilePath = promptForFileToOpen(tr("Open"));
+
     // Don't do anything if the user hit Cancel
     if (openedFilePath.isNull())
     {
         return;
     }
 
-    // Update the recently used directory
-    QDir currentDirectory;
-    settings->setValue(DEFAULT_DIRECTORY_KEY, currentDirectory.absoluteFilePath(openedFilePath));
+    openFile(openedFilePath);
+}
+
 
-    // Attempt to create a file descriptor for the file at the given path
-    QFile file(openedFilePath);
+/* Opens the file at the given path in the current tab if it's an untitled, unmodified one, or in a
+ * new tab otherwise. Returns false (after telling the user why) if the file can't be read.
+ */
+bool MainWindow::openFile(const QString &filePath)
+{
+    // Used to switch to a new tab if there's already an open doc
+    bool openInCurrentTab = editor->isUntitled() && !editor->isUnsaved();
+
+    // Make sure the file can actually be read before committing a tab to it
+    QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QFile::Text))
     {
-        QMessageBox::warning(this, "Warning", "Cannot save file: " + file.errorString());
-        return;
+        QMessageBox::warning(this, "Warning", "Cannot open file: " + file.errorString());
+        return false;
     }
-
-    // Read the file contents into the editor and close the file descriptor
-    QTextStream in(&file);
-    QString documentContents = in.readAll();
+    file.close();
 
     if (!openInCurrentTab)
     {
         tabbedEditor->add(new Editor());
     }
-    editor->setCurrentFilePath(openedFilePath);
-    editor->setPlainText(documentContents);
-    file.close();
 
-    editor->setModifiedState(false);
+    // The editor reads the file in the background and updates the title once it's done
+    editor->load(filePath);
     updateTabAndWindowTitle();
     setLanguageFromExtension();
+    return true;
+}
+
+
+/* Goes to the given line and column of the file at the given path, switching to its tab if it's
+ * already open and opening it otherwise (see openFile). Used by the Find in Files panel.
+ */
+void MainWindow::openFileAt(QString filePath, int line, int column)
+{
+    for (int i = 0; i < tabbedEditor->count(); i++)
+    {
+        Editor *tab = tabbedEditor->tabAt(i);
+
+        if (!tab->isUntitled() && QFileInfo(tab->getCurrentFilePath()) == QFileInfo(filePath))
+        {
+            tabbedEditor->setCurrentWidget(tab);
+            editor->goToAfterLoading(line, column);
+            editor->setFocus();
+            return;
+        }
+    }
+
+    if (openFile(filePath))
+    {
+        editor->goToAfterLoading(line, column);
+        editor->setFocus();
+    }
+}
+
+
+/* Called when the user selects Find in Files from the Edit menu (or uses Ctrl+Shift+F). Shows the
+ * Find in Files panel, pointed at the current file's folder unless it has been pointed elsewhere.
+ */
+void MainWindow::on_actionFind_in_Files_triggered()
+{
+    if (findInFilesPanel->getDirectory().isEmpty())
+    {
+        findInFilesPanel->setDirectory(editor->isUntitled() ? DEFAULT_DIRECTORY : QFileInfo(editor->getCurrentFilePath()).absolutePath());
+    }
+
+    findInFilesPanel->show();
+    findInFilesPanel->raise();
+    findInFilesPanel->focusQuery();
+}
+
+
+/* Called when the user selects the View (Read-Only) option from the File menu (or uses Ctrl+Shift+O).
+ * Opens the selected file in a separate read-only FileViewer window. Unlike Open, this memory-maps
+ * the file and only ever reads the lines on screen, so it's meant for huge logs and dumps.
+ */
+void MainWindow::on_actionView_File_triggered()
+{
+    QString viewedFilePath = promptForFileToOpen(tr("View (Read-Only)"));
+
+    // Don't do anything if the user hit Cancel
+    if (viewedFilePath.isNull())
+    {
+        return;
+    }
+
+    FileViewer *viewer = new FileViewer(this);
+    viewer->setWindowFlags(Qt::Window);
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+
+    if (!viewer->open(viewedFilePath))
+    {
+        QMessageBox::warning(this, "Warning", "Cannot open file: " + viewer->errorString());
+        delete viewer;
+        return;
+    }
+
+    viewer->setWindowTitle(viewer->getFileName() + " [Read-Only] - Scribe");
+    viewer->resize(size());
+    viewer->show();
 }
 
 
@@ -551,7 +638,9 @@ void MainWindow::on_actionPrint_triggered()
 
 /* Called when the user tries to close a tab in the editor (or uses Ctrl+W). Allows the user
  * to save the contents of the tab if unsaved. Closes the tab, unless the file is unsaved
- * and the user declines saving. Returns true if the tab was closed and false otherwise.
+ * and the user declines saving. A tab whose file is being saved is closed once the save
+ * finishes (see closeTabWhenSaved). Returns true if the tab was closed or will be once it's
+ * saved, and false otherwise.
  */
 bool MainWindow::closeTab(Editor *tabToClose)
 {
@@ -564,19 +653,36 @@ bool MainWindow::closeTab(Editor *tabToClose)
         tabbedEditor->setCurrentWidget(tabToClose);
     }
 
+    bool closeNow = true;
+
+    // Nothing has been edited yet if the file is still loading, so just stop loading it
+    if (tabToClose->isLoading())
+    {
+        tabToClose->cancelLoading();
+    }
+
+    // Whatever the save running now doesn't cover is asked about once it's done
+    else if (tabToClose->isSaving())
+    {
+        closeTabWhenSaved(tabToClose);
+        closeNow = false;
+    }
+
     // Don't close a tab immediately if it has unsaved contents
-    if (tabToClose->isUnsaved())
+    else if (tabToClose->isUnsaved())
     {
         QMessageBox::StandardButton selection = askUserToSave();
 
         if (selection == QMessageBox::StandardButton::Yes)
         {
-            bool fileSaved = on_actionSaveTriggered();
-
-            if (!fileSaved)
+            // The save runs in the background, and the tab can't go away until it's done
+            if (!on_actionSaveTriggered())
             {
                 return false;
             }
+
+            closeTabWhenSaved(tabToClose);
+            closeNow = false;
         }
 
         else if (selection == QMessageBox::Cancel)
@@ -585,8 +691,11 @@ bool MainWindow::closeTab(Editor *tabToClose)
         }
     }
 
-    int indexOfTabToClose = tabbedEditor->indexOf(tabToClose);
-    tabbedEditor->removeTab(indexOfTabToClose);
+    if (closeNow)
+    {
+        int indexOfTabToClose = tabbedEditor->indexOf(tabToClose);
+        tabbedEditor->removeTab(indexOfTabToClose);
+    }
 
     // If we closed the last tab, make a new one
     if (tabbedEditor->count() == 0)
@@ -604,11 +713,45 @@ bool MainWindow::closeTab(Editor *tabToClose)
 }
 
 
+/* Closes the given tab once the save it's running finishes, unless the save fails.
+ */
+void MainWindow::closeTabWhenSaved(Editor *tab)
+{
+    tabsClosingAfterSave.insert(tab);
+    connect(tab, SIGNAL(saveFinished(bool)), this, SLOT(on_closingTabSaved(bool)), Qt::UniqueConnection);
+    ui->statusBar->showMessage("The tab will close once its file is saved");
+}
+
+
+/* Called when a tab the user closed while it was being saved finishes saving. Tries to close it
+ * again, which asks about anything typed while the save was running. A failed save keeps the tab
+ * open (the editor has already told the user why) and cancels exiting, if the user was exiting.
+ */
+void MainWindow::on_closingTabSaved(bool succeeded)
+{
+    Editor *tab = qobject_cast<Editor*>(sender());
+    disconnect(tab, SIGNAL(saveFinished(bool)), this, SLOT(on_closingTabSaved(bool)));
+    tabsClosingAfterSave.remove(tab);
+
+    if (!succeeded || !closeTab(tab))
+    {
+        exitAfterSaving = false;
+    }
+
+    if (exitAfterSaving && tabsClosingAfterSave.isEmpty())
+    {
+        on_actionExit_triggered();
+    }
+}
+
+
 /* Called when the user selects the Exit option from the menu. Allows the user
- * to save any unsaved files before quitting.
+ * to save any unsaved files before quitting. Quits once any files still being
+ * saved are done (see on_closingTabSaved).
  */
 void MainWindow::on_actionExit_triggered()
 {
+    exitAfterSaving = false;
     QVector<Editor*> unsavedTabs = tabbedEditor->unsavedTabs();
 
     for (Editor *tab : unsavedTabs)
@@ -621,6 +764,12 @@ void MainWindow::on_actionExit_triggered()
         }
     }
 
+    if (!tabsClosingAfterSave.isEmpty())
+    {
+        exitAfterSaving = true;
+        return;
+    }
+
     writeSettings();
     QApplication::quit();
 }
@@ -758,6 +907,15 @@ void MainWindow::on_actionGo_To_triggered()
 }
 
 
+/* Called when the user explicitly selects the Matching Bracket option from the menu (or uses Ctrl+M).
+ * Moves the cursor to the bracket matching the one next to it.
+ */
+void MainWindow::on_actionMatching_Bracket_triggered()
+{
+    editor->jumpToMatchingBracket();
+}
+
+
 /* Called when the user explicitly selects the Select All option from the menu (or uses Ctrl+A).
  */
 void MainWindow::on_actionSelect_All_triggered()
@@ -832,6 +990,69 @@ void MainWindow::on_actionTool_Bar_triggered()
 }
 
 
+/* Shows how well the highlighters' token cache is doing and how much memory
+ * the highlighters take up, for debugging.
+ */
+void MainWindow::on_actionHighlighting_Statistics_triggered()
+{
+    const TokenCache &cache = TokenCache::instance();
+    int lookups = cache.getHits() + cache.getMisses();
+    double hitRate = lookups == 0 ? 0 : 100.0 * cache.getHits() / lookups;
+
+    int numHighlighters = 0;
+    int highlighterMemoryUsage = 0;
+    int numEdits = 0;
+    int numRelexedBlocks = 0;
+    int numLines = 0;
+    qint64 highlightingMemoryUsage = 0;
+    qint64 formatsMemoryUsage = 0;
+    QVector<qint64> latencies;
+
+    for (Editor *tab : tabbedEditor->tabs())
+    {
+        if (tab->getHighlighter())
+        {
+            numHighlighters++;
+            highlighterMemoryUsage += tab->getHighlighter()->getMemoryUsage();
+            numEdits += tab->getHighlighter()->getNumEdits();
+            numRelexedBlocks += tab->getHighlighter()->getNumRelexedBlocks();
+            numLines += tab->blockCount();
+            highlightingMemoryUsage += tab->getHighlighter()->getHighlightingMemoryUsage();
+            formatsMemoryUsage += tab->getHighlighter()->getFormatsMemoryUsage();
+        }
+
+        latencies += tab->getInputLatencies();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    QString statistics = QString("Token cache: %1 lines (%2 KB)\nHits: %3\nMisses: %4\nHit rate: %5%\n\n")
+            .arg(cache.getNumLines()).arg(cache.getSize() / 1024)
+            .arg(cache.getHits()).arg(cache.getMisses()).arg(hitRate, 0, 'f', 1);
+
+    statistics += QString("Grammars: %1 (%2 KB, shared)\nHighlighters: %3 (%4 bytes each)")
+            .arg(GrammarRegistry::instance().getNumGrammars()).arg(GrammarRegistry::instance().getMemoryUsage() / 1024)
+            .arg(numHighlighters).arg(numHighlighters == 0 ? 0 : highlighterMemoryUsage / numHighlighters);
+
+    statistics += QString("\nBlocks re-lexed per edit: %1")
+            .arg(numEdits == 0 ? 0 : static_cast<double>(numRelexedBlocks) / numEdits, 0, 'f', 1);
+
+    statistics += QString("\nHighlighting per line: %1 bytes (%2 bytes as formats)")
+            .arg(numLines == 0 ? 0 : static_cast<double>(highlightingMemoryUsage) / numLines, 0, 'f', 1)
+            .arg(numLines == 0 ? 0 : static_cast<double>(formatsMemoryUsage) / numLines, 0, 'f', 1);
+
+    if (!latencies.isEmpty())
+    {
+        statistics += QString("\nKeystroke to paint: %1 ms median, %2 ms p99 (%3 keystrokes)")
+                .arg(latencies[latencies.size() / 2] / 1000.0, 0, 'f', 1)
+                .arg(latencies[(latencies.size() - 1) * 99 / 100] / 1000.0, 0, 'f', 1)
+                .arg(latencies.size());
+    }
+
+    QMessageBox::information(this, "Highlighting Statistics", statistics);
+}
+
+
 /* Overrides the QWidget closeEvent virtual method. Called when the user tries
  * to close the main application window conventually via the red X. Allows the
  * user to save any unsaved files before quitting.
@@ -841,3 +1062,160 @@ void MainWindow::closeEvent(QCloseEvent *event)
     event->ignore();
     on_actionExit_triggered();
 }
+
+
+/* Called when the user clicks Find in Open Tabs in the find dialog. See searchOpenTabs.
+ */
+void MainWindow::findInOpenTabs(QString query, bool caseSensitive, bool wholeWords, bool regex)
+{
+    searchOpenTabs(query, QString(), caseSensitive, wholeWords, regex, false);
+}
+
+
+/* Called when the user clicks Replace in Open Tabs in the find dialog. See searchOpenTabs.
+ */
+void MainWindow::replaceInOpenTabs(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex)
+{
+    searchOpenTabs(what, with, caseSensitive, wholeWords, regex, true);
+}
+
+
+/* Searches every open tab at once (see TabSearch), canceling any such search that's still running,
+ * and lists the matches in the results panel, grouped by tab, as each tab is done. If replacing,
+ * each tab's matches are replaced as one undo step in that tab.
+ */
+void MainWindow::searchOpenTabs(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex, bool replacing)
+{
+    cancelTabSearch();
+
+    if (regex)
+    {
+        RegexSearcher searcher(what, caseSensitive, wholeWords);
+
+        if (!searcher.isValid())
+        {
+            informUser("Find and Replace", "Invalid regular expression: " + searcher.getErrorString());
+            return;
+        }
+    }
+
+    QVector<Editor*> tabs = tabbedEditor->tabs();
+
+    resultTabs.clear();
+    resultsPanel->clear(QString("Searching %1 tabs...").arg(tabs.size()));
+    resultsPanel->show();
+
+    tabSearch = new TabSearch(tabs, what, with, caseSensitive, wholeWords, regex, replacing, this);
+    connect(tabSearch, SIGNAL(tabSearched(int)), this, SLOT(on_tabSearched(int)));
+    connect(tabSearch, SIGNAL(done()), this, SLOT(on_tabSearchDone()));
+    tabSearch->start();
+}
+
+
+/* Cancels the search across tabs (if any) that's still running, e.g., because the query changed.
+ * Whatever has already been listed (or replaced) stays that way.
+ */
+void MainWindow::cancelTabSearch()
+{
+    if (!tabSearch)
+    {
+        return;
+    }
+
+    delete tabSearch;
+    tabSearch = nullptr;
+    resultsPanel->setSummary("Search canceled.");
+}
+
+
+/* Called when another tab has been searched. Lists its matches (if it has any) in the results panel.
+ */
+void MainWindow::on_tabSearched(int index)
+{
+    const TabMatches &matches = tabSearch->matchesIn(index);
+
+    if (matches.starts.isEmpty())
+    {
+        return;
+    }
+
+    QString title = matches.tabName + " (" + QString::number(matches.starts.size()) + (matches.starts.size() == 1 ? " match" : " matches");
+
+    if (tabSearch->isReplacing())
+    {
+        title += matches.replaced ? ", all replaced" : ", none replaced since the tab was edited or closed";
+    }
+
+    if (matches.listed.size() < matches.starts.size())
+    {
+        title += QString(", the first %1 listed").arg(matches.listed.size());
+    }
+
+    resultsPanel->addGroup(title + ")", matches.listed);
+    resultTabs.append(matches.tab);
+}
+
+
+/* Called when every tab has been searched. Sums up the search in the results panel.
+ */
+void MainWindow::on_tabSearchDone()
+{
+    int numMatches = 0;
+    int numReplaced = 0;
+    int numTabsWithMatches = 0;
+    int numLoadingTabs = 0;
+    int numSkippedLines = 0;
+
+    for (int i = 0; i < tabSearch->numTabs(); i++)
+    {
+        const TabMatches &matches = tabSearch->matchesIn(i);
+        numMatches += matches.starts.size();
+        numReplaced += matches.replaced ? matches.starts.size() : 0;
+        numTabsWithMatches += matches.starts.isEmpty() ? 0 : 1;
+        numLoadingTabs += matches.loading ? 1 : 0;
+        numSkippedLines += matches.numSkippedLines;
+    }
+
+    QString summary = QString("Found %1 matches in %2 of %3 tabs").arg(numMatches).arg(numTabsWithMatches).arg(tabSearch->numTabs());
+
+    if (tabSearch->isReplacing())
+    {
+        summary += QString(" and replaced %1 of them").arg(numReplaced);
+    }
+
+    summary += QString(" in %1 ms.").arg(tabSearch->getElapsedTime());
+
+    if (numLoadingTabs > 0)
+    {
+        summary += QString(" %1 tabs were skipped because they're still loading.").arg(numLoadingTabs);
+    }
+
+    if (numSkippedLines > 0)
+    {
+        summary += QString(" %1 lines were skipped because the expression took too long on them.").arg(numSkippedLines);
+    }
+
+    resultsPanel->setSummary(summary);
+
+    // Nothing is left running, and the results have been listed
+    tabSearch->deleteLater();
+    tabSearch = nullptr;
+}
+
+
+/* Called when the user activates a match in the results panel. Switches to its tab and goes to it.
+ */
+void MainWindow::on_searchResultActivated(int group, int line, int column)
+{
+    Editor *tab = resultTabs.value(group);
+
+    if (!tab)
+    {
+        informUser("Search Results", "That tab has been closed.");
+        return;
+    }
+
+    tabbedEditor->setCurrentWidget(tab);
+    editor->goTo(line, column);
+    editor->setFocus();
+}
@@ -8,11 +8,16 @@
 #include "tabbededitor.h"
 #include "language.h"
 #include "metricreporter.h"
+#include "fileviewer.h"
+#include "tabsearch.h"
+#include "searchresultspanel.h"
+#include "findinfilespanel.h"
 #include <highlighters/highlighter.h>
 #include <QMainWindow>
 #include <QCloseEvent>                  // closeEvent
 #include <QLabel>                       // GUI labels
 #include <QActionGroup>
+#include <QPointer>
 #include <QStandardPaths>               // see default directory
 
 
@@ -38,13 +43,14 @@ private:
     void reconnectEditorDependentSignals();
     void disconnectEditorDependentSignals();
     QMessageBox::StandardButton askUserToSave();
+    QString promptForFileToOpen(QString dialogTitle);
+    bool openFile(const QString &filePath);
 
     void appendShortcutsToToolbarTooltips();
     void setupLanguageOnStatusBar();
     void selectProgrammingLanguage(Language language);
     void triggerCorrespondingMenuLanguageOption(Language lang);
-    void mapMenuLanguageOptionToLanguageType();
-    void mapFileExtensionsToLanguages();
+    void populateLanguageMenu();
     void setLanguageFromExtension();
 
     void matchFormatOptionsToEditorDefaults();
@@ -53,6 +59,7 @@ private:
     void readSettings();
 
     void toggleVisibilityOf(QWidget *widget);
+    void searchOpenTabs(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex, bool replacing);
 
     // The "core" or essential members
     Ui::MainWindow *ui;
@@ -75,7 +82,18 @@ private:
     QActionGroup *languageGroup;
     QLabel *languageLabel;
     QMap<QAction*, Language> menuActionToLanguageMap;
-    QMap<QString, Language> extensionToLanguageMap;
+
+    // Searches across tabs, and the tab each group of results in the panel is for
+    SearchResultsPanel *resultsPanel;
+    TabSearch *tabSearch = nullptr;
+    QVector<QPointer<Editor>> resultTabs;
+
+    // Tabs the user closed while their file was being saved, and whether to exit once they're closed
+    QSet<Editor*> tabsClosingAfterSave;
+    bool exitAfterSaving = false;
+    void closeTabWhenSaved(Editor *tab);
+
+    FindInFilesPanel *findInFilesPanel;
 
 public slots:
     void toggleUndo(bool undoAvailable);
@@ -94,14 +112,19 @@ private slots:
     void on_languageSelected(QAction* languageAction);
     void on_actionNew_triggered();
     bool on_actionSaveTriggered();
+    void on_saveFinished(bool succeeded);
+    void on_closingTabSaved(bool succeeded);
     void on_actionOpen_triggered();
+    void on_actionView_File_triggered();
     void on_actionExit_triggered();
     void on_actionUndo_triggered();
     void on_actionCut_triggered();
     void on_actionCopy_triggered();
     void on_actionPaste_triggered();
     void on_actionFind_triggered();
+    void on_actionFind_in_Files_triggered();
     void on_actionGo_To_triggered();
+    void on_actionMatching_Bracket_triggered();
     void on_actionSelect_All_triggered();
     void on_actionRedo_triggered();
     void on_actionPrint_triggered();
@@ -111,6 +134,15 @@ private slots:
     void on_actionAuto_Indent_triggered();
     void on_actionWord_Wrap_triggered();
     void on_actionTool_Bar_triggered();
+    void on_actionHighlighting_Statistics_triggered();
+
+    void findInOpenTabs(QString query, bool caseSensitive, bool wholeWords, bool regex);
+    void replaceInOpenTabs(QString what, QString with, bool caseSensitive, bool wholeWords, bool regex);
+    void cancelTabSearch();
+    void on_tabSearched(int index);
+    void on_tabSearchDone();
+    void on_searchResultActivated(int group, int line, int column);
+    void openFileAt(QString filePath, int line, int column);
 };
 
 #endif // MAINWINDOW_H
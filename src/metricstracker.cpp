@@ -0,0 +1,108 @@
+#include "metricstracker.h"
+#include "blockdata.h"
+#include <cctype>
+
+
+/* Initializes this MetricsTracker and counts the document's current contents.
+ * The tracker is parented to the document so it lives exactly as long as it.
+ */
+MetricsTracker::MetricsTracker(QTextDocument *document) : QObject(document)
+{
+    this->document = document;
+    recountAll();
+
+    connect(document, SIGNAL(contentsChange(int, int, int)), this, SLOT(on_contentsChange(int, int, int)));
+}
+
+
+/* Returns the number of words in a single line of text. A word is a run of characters
+ * containing at least one ASCII letter or digit and ending at whitespace or at the end of
+ * the line; any other characters inside a run are ignored. Since words can never span
+ * lines, the document's word count is simply the sum of the counts of its blocks.
+ */
+int MetricsTracker::countWordsIn(const QString &text)
+{
+    int wordCount = 0;
+    bool inWord = false;
+
+    for (const QChar &ch : text)
+    {
+        // QTextDocument::toPlainText turns these into a space and a newline, respectively
+        unsigned char character = ch == QChar::Nbsp ? ' ' : ch == QChar::LineSeparator ? '\n' : ch.toLatin1();
+
+        if (isalnum(character))
+        {
+            inWord = true;
+        }
+        else if (isspace(character))
+        {
+            if (inWord)
+            {
+                wordCount++;
+                inWord = false;
+            }
+        }
+    }
+
+    return inWord ? wordCount + 1 : wordCount;
+}
+
+
+/* Called whenever text is inserted into or removed from the document. Blocks that were
+ * removed entirely have already given their words back (see ~BlockData), so only the
+ * blocks now spanning the edited range need to be recounted.
+ */
+void MetricsTracker::on_contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    // Replacing the entire document (e.g., setPlainText) is cheaper to count from scratch
+    if (position == 0 && charsAdded >= charCount())
+    {
+        recountAll();
+        return;
+    }
+
+    QTextBlock block = document->findBlock(position);
+    int endOfEdit = position + charsAdded;
+
+    while (block.isValid() && block.position() <= endOfEdit)
+    {
+        recount(block);
+        block = block.next();
+    }
+}
+
+
+/* Recounts the words of a single block and applies the difference to the running total.
+ */
+void MetricsTracker::recount(QTextBlock block)
+{
+    BlockData *data = BlockData::of(block);
+    int newCount = countWordsIn(block.text());
+
+    if (data->metricsTracker == this && data->wordCount != BlockData::UNCOUNTED)
+    {
+        words -= data->wordCount;
+    }
+
+    words += newCount;
+    data->wordCount = newCount;
+    data->metricsTracker = this;
+}
+
+
+/* Discards the running total and counts every block in the document.
+ */
+void MetricsTracker::recountAll()
+{
+    words = 0;
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        BlockData *data = BlockData::of(block);
+        data->wordCount = countWordsIn(block.text());
+        data->metricsTracker = this;
+        words += data->wordCount;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef METRICSTRACKER_H
+#define METRICSTRACKER_H
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+
+
+/* Keeps the word and char counts of a document up to date as it is edited.
+ * Each block remembers its own word count (see BlockData), so an edit only
+ * requires recounting the blocks it touched instead of the whole document.
+ */
+class MetricsTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsTracker(QTextDocument *document);
+
+    inline int wordCount() const { return words; }
+    inline int charCount() const { return document->characterCount() - 1; }
+    static int countWordsIn(const QString &text);
+
+private slots:
+    void on_contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    friend class BlockData;
+    void forget(int blockWordCount) { words -= blockWordCount; }
+    void recount(QTextBlock block);
+    void recountAll();
+
+    QTextDocument *document;
+    int words = 0;
+};
+
+#endif // METRICSTRACKER_H
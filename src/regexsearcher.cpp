@@ -0,0 +1,239 @@
+#include "regexsearcher.h"
+
+
+/* Compiles the given pattern, limited to STEP_BUDGET steps per window of a line (see the class
+ * comment). If the pattern is invalid, so is this searcher (see getErrorString).
+ */
+RegexSearcher::RegexSearcher(const QString &pattern, bool caseSensitive, bool wholeWords)
+{
+    QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+    if (!caseSensitive)
+    {
+        options |= QRegularExpression::CaseInsensitiveOption;
+    }
+
+    // Checked on its own first, so that wrapping it below can't hide (or cause) an error
+    expression = QRegularExpression(pattern, options);
+    if (!expression.isValid())
+    {
+        return;
+    }
+
+    // Verbs like (*UCP) only work at the very start, so they're kept out of the groups it's wrapped in
+    int verbsLength = QRegularExpression("^(?:\\(\\*[A-Z0-9_=]+\\))*").match(pattern).capturedLength();
+    QString verbs = QString("(*LIMIT_MATCH=%1)").arg(STEP_BUDGET) + pattern.left(verbsLength);
+    QString body = "(?:" + pattern.mid(verbsLength) + ")";
+
+    // Whole words are matched the way TextSearcher matches them: not run into by letters or digits
+    if (wholeWords)
+    {
+        body = "(?<![\\p{L}\\p{N}])" + body + "(?![\\p{L}\\p{N}])";
+    }
+
+    expression.setPattern(verbs + body);
+    expression.optimize();
+
+    // \G anchors it where it's matched from (anchoring it with a match option would keep the JIT from
+    // running it). It then skips up to WINDOW_LENGTH - 1 characters lazily, so the first position with
+    // a match wins, and \K leaves them out of the match without adding a group. Start optimizations
+    // would look for the characters a match needs in all the rest of the line, for every window.
+    windowed = QRegularExpression(verbs + "(*NO_START_OPT)\\G(?s:.{0," + QString::number(WINDOW_LENGTH - 1) + "}?)\\K" + body, options);
+    windowed.optimize();
+}
+
+
+/* Sets what matches are to be replaced with. See the class comment for what it may refer to.
+ */
+void RegexSearcher::setReplacement(const QString &replacementTemplate)
+{
+    replacement.clear();
+    TemplatePart part;
+    const int length = replacementTemplate.length();
+
+    for (int i = 0; i < length; i++)
+    {
+        QChar character = replacementTemplate.at(i);
+
+        if (character != '\\' || i + 1 == length)
+        {
+            part.literal += character;
+            continue;
+        }
+
+        QChar next = replacementTemplate.at(i + 1);
+        int nameEnd = -1;
+
+        if (next >= '0' && next <= '9')
+        {
+            part.group = 0;
+            int end = i + 1;
+
+            for (; end < length && end < i + 3 && replacementTemplate.at(end) >= '0' && replacementTemplate.at(end) <= '9'; end++)
+            {
+                part.group = part.group * 10 + replacementTemplate.at(end).digitValue();
+            }
+
+            replacement.append(part);
+            part = TemplatePart();
+            i = end - 1;
+        }
+        else if (next == 'g' && replacementTemplate.midRef(i + 2, 1) == "<" &&
+                 (nameEnd = replacementTemplate.indexOf('>', i + 3)) != -1)
+        {
+            QString name = replacementTemplate.mid(i + 3, nameEnd - i - 3);
+            bool isNumber = false;
+            int group = name.toInt(&isNumber);
+
+            if (isNumber)
+            {
+                part.group = group;
+            }
+            else
+            {
+                part.groupName = name;
+            }
+
+            replacement.append(part);
+            part = TemplatePart();
+            i = nameEnd;
+        }
+        else if (next == 'n' || next == 't' || next == '\\')
+        {
+            part.literal += next == 'n' ? '\n' : next == 't' ? '\t' : '\\';
+            i++;
+        }
+        else
+        {
+            part.literal += character;
+        }
+    }
+
+    if (!part.literal.isEmpty())
+    {
+        replacement.append(part);
+    }
+}
+
+
+/* Returns what the given match is to be replaced with (see setReplacement).
+ */
+QString RegexSearcher::replacementFor(const QRegularExpressionMatch &match) const
+{
+    QString result;
+
+    for (const TemplatePart &part : replacement)
+    {
+        result += part.literal;
+
+        if (part.group != -1)
+        {
+            result += match.captured(part.group);
+        }
+        else if (!part.groupName.isEmpty())
+        {
+            result += match.captured(part.groupName);
+        }
+    }
+
+    return result;
+}
+
+
+/* Adds the matches in the given line (which starts at lineStart in the document) to the given
+ * batch, along with their replacements if replacing. Empty matches are skipped, since there's
+ * nothing to select or replace. Returns OutOfSteps or OutOfTime if the search of the line was
+ * given up on, in which case the rest of the line isn't searched.
+ */
+RegexSearcher::LineOutcome RegexSearcher::findInLine(const QString &line, int lineStart, RegexMatchBatch &batch, bool replacing,
+                                                     QDeadlineTimer deadline) const
+{
+    QRegularExpressionMatch match;
+    bool lineChecked = false;
+
+    for (int position = 0; ; position = match.capturedEnd())
+    {
+        LineOutcome outcome = findFirstInWindows(line, position, match, deadline, lineChecked);
+
+        if (outcome != Searched || !match.hasMatch())
+        {
+            return outcome;
+        }
+
+        batch.starts.append(lineStart + match.capturedStart());
+        batch.lengths.append(match.capturedLength());
+
+        if (replacing)
+        {
+            batch.replacements.append(replacementFor(match));
+        }
+    }
+}
+
+
+/* Finds the first match in the given line that starts at or after from and isn't empty, or sets
+ * match to one that has no match if there is none. Returns OutOfSteps or OutOfTime, with no match,
+ * if the search was given up on before then. The line is searched a window at a time (see the
+ * class comment), and the deadline is checked before every window.
+ */
+RegexSearcher::LineOutcome RegexSearcher::findFirstInLine(const QString &line, int from, QRegularExpressionMatch &match,
+                                                          QDeadlineTimer deadline) const
+{
+    bool lineChecked = false;
+    return findFirstInWindows(line, from, match, deadline, lineChecked);
+}
+
+
+/* Does what findFirstInLine does. PCRE2 checks that the whole line is valid UTF-16 every time it's
+ * matched, which would make searching a long line quadratic, so it's only checked the first time
+ * (after which lineChecked is set).
+ */
+RegexSearcher::LineOutcome RegexSearcher::findFirstInWindows(const QString &line, int from, QRegularExpressionMatch &match,
+                                                             QDeadlineTimer deadline, bool &lineChecked) const
+{
+    int position = from;
+
+    while (position <= line.length())
+    {
+        if (deadline.hasExpired())
+        {
+            match = QRegularExpressionMatch();
+            return OutOfTime;
+        }
+
+        match = windowed.match(line, position, QRegularExpression::NormalMatch,
+                               lineChecked ? QRegularExpression::DontCheckSubjectStringMatchOption : QRegularExpression::NoMatchOption);
+
+        // Errors from PCRE2 (running out of steps among them) leave the match invalid
+        if (!match.isValid())
+        {
+            match = QRegularExpressionMatch();
+            return OutOfSteps;
+        }
+
+        lineChecked = true;
+
+        if (!match.hasMatch())
+        {
+            // The window covered at least WINDOW_LENGTH code units, so none are skipped, but it may end inside a surrogate pair
+            position += WINDOW_LENGTH;
+            if (position < line.length() && line.at(position).isLowSurrogate())
+            {
+                position++;
+            }
+
+            continue;
+        }
+
+        if (match.capturedLength() > 0)
+        {
+            return Searched;
+        }
+
+        // Move past an empty match, never into the middle of a surrogate pair
+        int start = match.capturedStart();
+        position = start + (start < line.length() && line.at(start).isHighSurrogate() ? 2 : 1);
+    }
+
+    match = QRegularExpressionMatch();
+    return Searched;
+}
@@ -0,0 +1,79 @@
+#ifndef REGEXSEARCHER_H
+#define REGEXSEARCHER_H
+#include <QRegularExpression>
+#include <QDeadlineTimer>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+
+/* The matches a RegexSearchWorker found in a run of lines, with what each of them is to be
+ * replaced with (if the search is for Replace All).
+ */
+struct RegexMatchBatch
+{
+    int generation;
+    int percentDone;
+    QVector<int> starts;
+    QVector<int> lengths;
+    QVector<QString> replacements;
+};
+
+Q_DECLARE_METATYPE(RegexMatchBatch)
+
+
+/* Finds the matches of a regular expression one line at a time, the way QTextDocument::find
+ * does, and works out their replacements.
+ *
+ * PCRE2's match limit starts over at every position a match is tried from, so a single unanchored
+ * match of a long line isn't bounded by it. Lines are searched in windows instead: a match is tried
+ * from each of up to WINDOW_LENGTH positions in one call, limited to STEP_BUDGET steps
+ * between them, so a pattern that backtracks catastrophically gives up on that line instead of hanging
+ * whoever is searching. The deadline a search is given is checked between windows, so even a pattern
+ * that's merely slow at every position stops soon after it.
+ *
+ * A replacement may refer to what the expression captured: \0 through \99 are numbered
+ * groups, \g<name> (or \g<number>) is a named one, \n and \t are a newline and a tab, and
+ * \\ is a backslash. Any other backslash is kept as it is.
+ */
+class RegexSearcher
+{
+public:
+    RegexSearcher(const QString &pattern, bool caseSensitive, bool wholeWords);
+
+    inline bool isValid() const { return expression.isValid(); }
+    inline QString getErrorString() const { return expression.errorString(); }
+    inline const QRegularExpression &getExpression() const { return expression; }
+
+    enum LineOutcome
+    {
+        Searched,
+        OutOfSteps,
+        OutOfTime
+    };
+
+    void setReplacement(const QString &replacementTemplate);
+    QString replacementFor(const QRegularExpressionMatch &match) const;
+    LineOutcome findInLine(const QString &line, int lineStart, RegexMatchBatch &batch, bool replacing, QDeadlineTimer deadline) const;
+    LineOutcome findFirstInLine(const QString &line, int from, QRegularExpressionMatch &match, QDeadlineTimer deadline) const;
+
+    const static int STEP_BUDGET = 1000000;
+    const static int WINDOW_LENGTH = 256;
+
+private:
+    LineOutcome findFirstInWindows(const QString &line, int from, QRegularExpressionMatch &match, QDeadlineTimer deadline,
+                                   bool &lineChecked) const;
+
+    struct TemplatePart
+    {
+        QString literal;
+        int group = -1;
+        QString groupName;
+    };
+
+    QRegularExpression expression;
+    QRegularExpression windowed;
+    QVector<TemplatePart> replacement;
+};
+
+#endif // REGEXSEARCHER_H
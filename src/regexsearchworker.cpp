@@ -0,0 +1,79 @@
+#include "regexsearchworker.h"
+#include <QDeadlineTimer>
+
+
+/* Initializes this RegexSearchWorker with the text to search. Call start() to begin.
+ */
+RegexSearchWorker::RegexSearchWorker(const RegexSearcher &searcher, QString text, bool replacing, int generation, QObject *parent)
+    : QThread(parent), searcher(searcher), text(text), replacing(replacing), generation(generation)
+{
+}
+
+
+/* Returns an empty batch for this worker's search.
+ */
+RegexMatchBatch RegexSearchWorker::newBatch(int percentDone) const
+{
+    RegexMatchBatch batch;
+    batch.generation = generation;
+    batch.percentDone = percentDone;
+    return batch;
+}
+
+
+/* Runs on the worker thread. Searches the text one line at a time, handing over a batch every
+ * LINES_PER_BATCH lines, until it reaches the end, times out, or is interrupted.
+ */
+void RegexSearchWorker::run()
+{
+    QDeadlineTimer deadline(TIMEOUT);
+
+    RegexMatchBatch batch = newBatch(0);
+    int numSkippedLines = 0;
+    int numLines = 0;
+    int lineStart = 0;
+
+    while (lineStart <= text.length())
+    {
+        if (isInterruptionRequested())
+        {
+            return;
+        }
+
+        int lineEnd = text.indexOf('\n', lineStart);
+        if (lineEnd == -1)
+        {
+            lineEnd = text.length();
+        }
+
+        // The line is searched where it is in the snapshot rather than copied out of it
+        QString line = QString::fromRawData(text.constData() + lineStart, lineEnd - lineStart);
+
+        RegexSearcher::LineOutcome outcome = searcher.findInLine(line, lineStart, batch, replacing, deadline);
+
+        if (outcome == RegexSearcher::OutOfTime)
+        {
+            emit(batchReady(batch));
+            emit(done(generation, TimedOut, numSkippedLines));
+            return;
+        }
+
+        if (outcome == RegexSearcher::OutOfSteps)
+        {
+            numSkippedLines++;
+        }
+
+        lineStart = lineEnd + 1;
+
+        if (++numLines % LINES_PER_BATCH == 0)
+        {
+            batch.percentDone = static_cast<int>(100LL * lineStart / qMax(1, text.length()));
+            emit(batchReady(batch));
+            batch = newBatch(batch.percentDone);
+        }
+    }
+
+    batch.percentDone = 100;
+    emit(batchReady(batch));
+    emit(done(generation, Completed, numSkippedLines));
+}
@@ -0,0 +1,48 @@
+#ifndef REGEXSEARCHWORKER_H
+#define REGEXSEARCHWORKER_H
+#include "regexsearcher.h"
+#include <QThread>
+#include <QString>
+
+
+/* Searches a snapshot of a document for a regular expression (see RegexSearcher) on a worker
+ * thread, handing the matches over every LINES_PER_BATCH lines so they can be shown as they're
+ * found. Interrupt it (QThread::requestInterruption) to cancel the search; it checks between lines.
+ *
+ * Lines that run out of steps are skipped and counted. If the whole search takes more than
+ * TIMEOUT milliseconds, it stops where it is (even partway through a line) and only the matches
+ * found so far are handed over.
+ */
+class RegexSearchWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    RegexSearchWorker(const RegexSearcher &searcher, QString text, bool replacing, int generation, QObject *parent = nullptr);
+
+    enum Outcome
+    {
+        Completed,
+        TimedOut
+    };
+
+    const static int LINES_PER_BATCH = 4096;
+    const static int TIMEOUT = 10000;
+
+signals:
+    void batchReady(RegexMatchBatch batch);
+    void done(int generation, int outcome, int numSkippedLines);
+
+protected:
+    void run() override;
+
+private:
+    RegexMatchBatch newBatch(int percentDone) const;
+
+    RegexSearcher searcher;
+    QString text;
+    bool replacing;
+    int generation;
+};
+
+#endif // REGEXSEARCHWORKER_H
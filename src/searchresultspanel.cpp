@@ -0,0 +1,125 @@
+#include "searchresultspanel.h"
+#include <QHeaderView>
+
+
+/* Returns the first maxListed of the matches that start at the given positions in the given text
+ * (in order), with the lines they're on. Walks the text once, so it's safe to call on any thread.
+ */
+QVector<ListedMatch> ListedMatch::listAll(const QString &text, const QVector<int> &starts, int maxListed)
+{
+    QVector<ListedMatch> listed;
+    int numListed = qMin(starts.size(), maxListed);
+    int line = 1;
+    int lineStart = 0;
+    int lineEnd = text.indexOf('\n');
+
+    listed.reserve(numListed);
+
+    for (int i = 0; i < numListed; i++)
+    {
+        while (lineEnd != -1 && lineEnd < starts[i])
+        {
+            line++;
+            lineStart = lineEnd + 1;
+            lineEnd = text.indexOf('\n', lineStart);
+        }
+
+        int lineLength = (lineEnd == -1 ? text.length() : lineEnd) - lineStart;
+
+        ListedMatch match;
+        match.line = line;
+        match.column = starts[i] - lineStart + 1;
+        match.lineText = text.mid(lineStart, qMin(lineLength, static_cast<int>(MAX_LINE_LENGTH))).trimmed();
+        listed.append(match);
+    }
+
+    return listed;
+}
+
+
+/* Initializes this SearchResultsPanel, empty.
+ */
+SearchResultsPanel::SearchResultsPanel(QWidget *parent) : QDockWidget(tr("Search Results"), parent)
+{
+    setObjectName("searchResultsPanel");
+
+    contents = new QWidget();
+    layout = new QVBoxLayout();
+    summaryLabel = new QLabel();
+    tree = new QTreeWidget();
+
+    tree->setColumnCount(2);
+    tree->setHeaderLabels({tr("Line"), tr("Text")});
+    tree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    tree->setUniformRowHeights(true);
+
+    layout->addWidget(summaryLabel);
+    layout->addWidget(tree);
+    contents->setLayout(layout);
+    setWidget(contents);
+
+    connect(tree, SIGNAL(itemActivated(QTreeWidgetItem*, int)), this, SLOT(on_itemActivated(QTreeWidgetItem*)));
+}
+
+
+/* Performs all required memory cleanup operations.
+ */
+SearchResultsPanel::~SearchResultsPanel()
+{
+    delete summaryLabel;
+    delete tree;
+    delete layout;
+    delete contents;
+}
+
+
+/* Removes every group and shows the given summary instead.
+ */
+void SearchResultsPanel::clear(const QString &summary)
+{
+    tree->clear();
+    summaryLabel->setText(summary);
+}
+
+
+/* Adds a group with the given title and matches. Returns the group's number.
+ */
+int SearchResultsPanel::addGroup(const QString &title, const QVector<ListedMatch> &matches)
+{
+    int group = tree->topLevelItemCount();
+
+    QTreeWidgetItem *groupItem = new QTreeWidgetItem({title});
+    groupItem->setData(0, Qt::UserRole, group);
+
+    QList<QTreeWidgetItem*> matchItems;
+    for (const ListedMatch &match : matches)
+    {
+        QTreeWidgetItem *matchItem = new QTreeWidgetItem({QString::number(match.line), match.lineText});
+        matchItem->setData(0, Qt::UserRole, match.line);
+        matchItem->setData(1, Qt::UserRole, match.column);
+        matchItems.append(matchItem);
+    }
+
+    // Adding the children before the group is in the tree spares a relayout per child
+    groupItem->addChildren(matchItems);
+    tree->addTopLevelItem(groupItem);
+
+    // Only takes effect once the item is in the tree
+    groupItem->setFirstColumnSpanned(true);
+    return group;
+}
+
+
+/* Called when the user activates an item. Matches are reported; groups are just expanded or collapsed.
+ */
+void SearchResultsPanel::on_itemActivated(QTreeWidgetItem *item)
+{
+    QTreeWidgetItem *groupItem = item->parent();
+
+    if (!groupItem)
+    {
+        return;
+    }
+
+    emit(matchActivated(groupItem->data(0, Qt::UserRole).toInt(), item->data(0, Qt::UserRole).toInt(), item->data(1, Qt::UserRole).toInt()));
+}
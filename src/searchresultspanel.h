@@ -0,0 +1,55 @@
+#ifndef SEARCHRESULTSPANEL_H
+#define SEARCHRESULTSPANEL_H
+#include <QDockWidget>
+#include <QTreeWidget>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <QString>
+#include <QVector>
+
+
+/* A match as it's listed in a SearchResultsPanel: where it is and the line it's on.
+ * Line and column numbers start at 1, as in GotoDialog.
+ */
+struct ListedMatch
+{
+    int line;
+    int column;
+    QString lineText;
+
+    static QVector<ListedMatch> listAll(const QString &text, const QVector<int> &starts, int maxListed);
+
+    const static int MAX_LINE_LENGTH = 200;
+};
+
+
+/* Lists the results of a search over more than one document, grouped by document. Each group is
+ * a top-level item with one child per match; activating a match (double-clicking it, or pressing
+ * Enter on it) emits matchActivated with its group (numbered in the order the groups were added).
+ */
+class SearchResultsPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    SearchResultsPanel(QWidget *parent = nullptr);
+    ~SearchResultsPanel() override;
+
+    void clear(const QString &summary);
+    int addGroup(const QString &title, const QVector<ListedMatch> &matches);
+    void setSummary(const QString &summary) { summaryLabel->setText(summary); }
+
+signals:
+    void matchActivated(int group, int line, int column);
+
+private slots:
+    void on_itemActivated(QTreeWidgetItem *item);
+
+private:
+    QWidget *contents;
+    QVBoxLayout *layout;
+    QLabel *summaryLabel;
+    QTreeWidget *tree;
+};
+
+#endif // SEARCHRESULTSPANEL_H
@@ -0,0 +1,134 @@
+#include "lineindex.h"
+#include <algorithm>
+#include <cstring>
+
+
+/* Points this index at the given buffer. Must be called again whenever the
+ * buffer is reallocated or appended to.
+ */
+void LineIndex::setData(const char *data, qint64 size)
+{
+    this->data = data;
+    this->size = size;
+}
+
+
+/* Scans forward to the next line break before limit, recording a checkpoint if needed.
+ * Returns false (and marks everything up to limit as scanned) if there is none.
+ */
+bool LineIndex::scanNextLine(qint64 limit)
+{
+    // memchr is vectorized by every mainstream C library, so let it do the heavy lifting
+    const void *lineBreak = memchr(data + scannedTo, '\n', static_cast<size_t>(limit - scannedTo));
+
+    if (!lineBreak)
+    {
+        scannedTo = limit;
+        return false;
+    }
+
+    scannedTo = static_cast<const char*>(lineBreak) - data + 1;
+    linesSeen++;
+
+    if (linesSeen % STRIDE == 0)
+    {
+        checkpoints.append(scannedTo);
+    }
+
+    return true;
+}
+
+
+/* Returns the offset just past the numLines-th line break at or after from.
+ * Assumes that many line breaks exist (i.e., they have already been scanned).
+ */
+qint64 LineIndex::skipLines(qint64 from, qint64 numLines) const
+{
+    for (qint64 i = 0; i < numLines; i++)
+    {
+        const void *lineBreak = memchr(data + from, '\n', static_cast<size_t>(size - from));
+        from = static_cast<const char*>(lineBreak) - data + 1;
+    }
+
+    return from;
+}
+
+
+/* Returns the number of line breaks in [from, to).
+ */
+qint64 LineIndex::countLines(qint64 from, qint64 to) const
+{
+    qint64 count = 0;
+
+    while (from < to)
+    {
+        const void *lineBreak = memchr(data + from, '\n', static_cast<size_t>(to - from));
+
+        if (!lineBreak)
+        {
+            break;
+        }
+
+        from = static_cast<const char*>(lineBreak) - data + 1;
+        count++;
+    }
+
+    return count;
+}
+
+
+/* Returns the number of line breaks before the given offset, which is
+ * also the (0-based) number of the line containing that offset.
+ */
+qint64 LineIndex::lineOfOffset(qint64 offset)
+{
+    offset = qBound(qint64(0), offset, size);
+
+    while (scannedTo < offset && scanNextLine(offset)) {}
+
+    // Find the last checkpoint at or before the offset and count the rest by hand
+    auto checkpoint = std::upper_bound(checkpoints.constBegin(), checkpoints.constEnd(), offset) - 1;
+    qint64 checkpointLine = (checkpoint - checkpoints.constBegin()) * STRIDE;
+
+    return checkpointLine + countLines(*checkpoint, offset);
+}
+
+
+/* Returns the offset at which the given (0-based) line starts, or -1 if the
+ * buffer does not have that many lines.
+ */
+qint64 LineIndex::offsetOfLine(qint64 line)
+{
+    if (line < 0)
+    {
+        return -1;
+    }
+
+    while (linesSeen < line && scanNextLine(size)) {}
+
+    if (linesSeen < line)
+    {
+        return -1;
+    }
+
+    qint64 checkpointIndex = line / STRIDE;
+    return skipLines(checkpoints.at(static_cast<int>(checkpointIndex)), line - checkpointIndex * STRIDE);
+}
+
+
+/* Scans the buffer up to the given offset, if it hasn't been already.
+ */
+void LineIndex::scanTo(qint64 offset)
+{
+    offset = qMin(offset, size);
+    while (scannedTo < offset && scanNextLine(offset)) {}
+}
+
+
+/* Returns the number of lines in the buffer. Scans the remainder of the buffer if necessary.
+ */
+qint64 LineIndex::lineCount()
+{
+    while (scannedTo < size && scanNextLine(size)) {}
+    return linesSeen + 1;
+}
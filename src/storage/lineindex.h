@@ -0,0 +1,48 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+#include <QVector>
+#include <QMetaType>
+
+
+/* Lazily built index of the line breaks in a byte buffer. The buffer is only
+ * scanned as far as the queries so far have required, and only the start of
+ * every STRIDE-th line is stored, so the index stays small even for files with
+ * tens of millions of lines. The buffer may grow between queries (append-only),
+ * but bytes that were already scanned must never change.
+ *
+ * An index is a plain value, so one can be built on another thread (see LineIndexer)
+ * and copied over one that has scanned less of the same buffer.
+ */
+class LineIndex
+{
+public:
+    LineIndex() {}
+    void setData(const char *data, qint64 size);
+
+    qint64 lineOfOffset(qint64 offset);
+    qint64 offsetOfLine(qint64 line);
+    qint64 lineCount();
+    void scanTo(qint64 offset);
+
+    inline qint64 bytesScanned() const { return scannedTo; }
+    inline qint64 linesScanned() const { return linesSeen; }
+
+    const static int STRIDE = 64;
+
+private:
+    bool scanNextLine(qint64 limit);
+    qint64 skipLines(qint64 from, qint64 numLines) const;
+    qint64 countLines(qint64 from, qint64 to) const;
+
+    const char *data = nullptr;
+    qint64 size = 0;
+
+    // checkpoints[i] is the offset at which line i * STRIDE starts
+    QVector<qint64> checkpoints = { 0 };
+    qint64 scannedTo = 0;
+    qint64 linesSeen = 0;
+};
+
+Q_DECLARE_METATYPE(LineIndex)
+
+#endif // LINEINDEX_H
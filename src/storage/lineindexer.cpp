@@ -0,0 +1,30 @@
+#include "lineindexer.h"
+
+
+/* Initializes this LineIndexer with the buffer to index. Call start() to begin.
+ */
+LineIndexer::LineIndexer(const char *data, qint64 size, int generation, QObject *parent)
+    : QThread(parent), data(data), size(size), generation(generation)
+{
+}
+
+
+/* Runs on the worker thread. Scans the buffer a chunk at a time until it reaches the end or is interrupted.
+ */
+void LineIndexer::run()
+{
+    LineIndex index;
+    index.setData(data, size);
+
+    for (qint64 scanned = 0; scanned < size; )
+    {
+        if (isInterruptionRequested())
+        {
+            return;
+        }
+
+        scanned = qMin(scanned + CHUNK_SIZE, size);
+        index.scanTo(scanned);
+        emit(progress(index, generation));
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef LINEINDEXER_H
+#define LINEINDEXER_H
+#include "lineindex.h"
+#include <QThread>
+
+
+/* Indexes the lines of a buffer (see LineIndex) on a worker thread, handing over a copy of
+ * the index every CHUNK_SIZE bytes, so that whoever reads the buffer never has to scan far
+ * themselves. The buffer must outlive the thread: interrupt it (QThread::requestInterruption)
+ * and wait for it before unmapping the buffer. It checks between chunks. Copies it had already
+ * handed over may still be queued after that, which the generation it was given tells apart.
+ */
+class LineIndexer : public QThread
+{
+    Q_OBJECT
+
+public:
+    LineIndexer(const char *data, qint64 size, int generation, QObject *parent = nullptr);
+
+    const static qint64 CHUNK_SIZE = 16 * 1024 * 1024;
+
+signals:
+    void progress(LineIndex index, int generation);
+
+protected:
+    void run() override;
+
+private:
+    const char *data;
+    qint64 size;
+    int generation;
+};
+
+#endif // LINEINDEXER_H
@@ -0,0 +1,154 @@
+#include "mappedfilestorage.h"
+#include <climits>
+#include <cstring>
+
+
+/* Memory-maps the file at the given path, unmapping any file loaded before. Returns false
+ * on failure, in which case errorString() describes what went wrong.
+ */
+bool MappedFileStorage::load(const QString &filePath)
+{
+    if (file.isOpen())
+    {
+        file.close();
+    }
+
+    mapping = nullptr;
+    mappingSize = 0;
+    lineIndex = LineIndex();
+
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    // Mapping an empty file fails, but there's nothing to map anyway
+    if (file.size() > 0)
+    {
+        uchar *mapped = file.map(0, file.size());
+
+        if (!mapped)
+        {
+            return false;
+        }
+
+        mapping = reinterpret_cast<const char*>(mapped);
+        mappingSize = file.size();
+    }
+
+    lineIndex.setData(mapping, mappingSize);
+    return true;
+}
+
+
+/* Returns a copy of the given range of the text. Positions are 64-bit, but a QByteArray can't
+ * hold more than INT_MAX bytes, so no more than that is ever copied at once.
+ */
+QByteArray MappedFileStorage::bytes(qint64 position, qint64 length) const
+{
+    if (position < 0 || position >= mappingSize)
+    {
+        return QByteArray();
+    }
+
+    qint64 end = qMin(position + qMin(length, qint64(INT_MAX)), mappingSize);
+    return QByteArray(mapping + position, static_cast<int>(end - position));
+}
+
+
+/* Returns the position at which the given (0-based) line starts, or -1 if there is no such line.
+ * Only scans as far into the file as needed to find the line.
+ */
+qint64 MappedFileStorage::lineStart(qint64 line)
+{
+    return lineIndex.offsetOfLine(line);
+}
+
+
+/* Returns the number of lines in the text. This needs to see every line break,
+ * so the first call may have to scan the rest of the file.
+ */
+qint64 MappedFileStorage::lineCount()
+{
+    return lineIndex.lineCount();
+}
+
+
+/* Returns the number of lines in the text without forcing a scan of the whole file.
+ * Until the file has been scanned to the end, the part seen so far is extrapolated.
+ */
+qint64 MappedFileStorage::lineCountEstimate()
+{
+    qint64 bytesScanned = lineIndex.bytesScanned();
+
+    if (bytesScanned >= mappingSize)
+    {
+        return lineCount();
+    }
+    else if (bytesScanned == 0)
+    {
+        return 1;
+    }
+
+    double linesPerByte = static_cast<double>(lineIndex.linesScanned()) / bytesScanned;
+    qint64 estimate = static_cast<qint64>(mappingSize * linesPerByte) + 1;
+    return qMax(estimate, lineIndex.linesScanned() + 1);
+}
+
+
+/* Takes over the given index of this storage's file if it has scanned further than the one in use.
+ */
+void MappedFileStorage::adoptLineIndex(const LineIndex &index)
+{
+    if (index.bytesScanned() > lineIndex.bytesScanned())
+    {
+        lineIndex = index;
+        lineIndex.setData(mapping, mappingSize);
+    }
+}
+
+
+/* Returns roughly where the given (0-based) line starts, without scanning the file up to it: the
+ * lines not indexed yet are assumed to be as long on average as the ones that are. The position
+ * returned is the start of the line that estimate lands in, as long as that line starts no more
+ * than MAX_BACKWARD_SCAN bytes before it. Lines already indexed are found exactly.
+ */
+qint64 MappedFileStorage::estimatedLineStart(qint64 line)
+{
+    qint64 linesScanned = lineIndex.linesScanned();
+
+    if (line <= linesScanned)
+    {
+        return lineStart(line);
+    }
+
+    double bytesPerLine = static_cast<double>(mappingSize) / lineCountEstimate();
+    qint64 lastLineStart = lineStart(linesScanned);
+    qint64 estimate = qMin(lastLineStart + static_cast<qint64>((line - linesScanned) * bytesPerLine), mappingSize - 1);
+
+    for (qint64 position = estimate; position > qMax(lastLineStart, estimate - MAX_BACKWARD_SCAN); position--)
+    {
+        if (mapping[position - 1] == '\n')
+        {
+            return position;
+        }
+    }
+
+    return estimate;
+}
+
+
+/* Returns the position at which the line after the one at the given position starts,
+ * or -1 if that's the last line.
+ */
+qint64 MappedFileStorage::nextLineStart(qint64 position) const
+{
+    if (position < 0 || position >= mappingSize)
+    {
+        return -1;
+    }
+
+    const void *lineBreak = memchr(mapping + position, '\n', static_cast<size_t>(mappingSize - position));
+    return lineBreak ? static_cast<const char*>(lineBreak) - mapping + 1 : -1;
+}
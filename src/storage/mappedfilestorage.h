@@ -0,0 +1,46 @@
+#ifndef MAPPEDFILESTORAGE_H
+#define MAPPEDFILESTORAGE_H
+#include "textstorage.h"
+#include "lineindex.h"
+#include <QFile>
+
+
+/* Read-only text storage that never copies the file it was loaded from. The file is
+ * memory-mapped, so loading it costs one mmap call no matter how big it is, and its
+ * lines are only found as far as they've been asked for (see LineIndex), or as far as
+ * an index built in the background has gotten (see adoptLineIndex).
+ *
+ * Lines past what's been indexed can be found without scanning up to them, but only
+ * roughly: estimatedLineStart extrapolates from the lines indexed so far.
+ */
+class MappedFileStorage : public TextStorage
+{
+public:
+    MappedFileStorage() {}
+
+    bool load(const QString &filePath);
+    inline QString errorString() const { return file.errorString(); }
+
+    inline qint64 size() const override { return mappingSize; }
+    QByteArray bytes(qint64 position, qint64 length) const override;
+    qint64 lineStart(qint64 line) override;
+    qint64 lineCount() override;
+    qint64 lineCountEstimate() override;
+
+    inline const char *data() const { return mapping; }
+    inline qint64 linesIndexed() const { return lineIndex.linesScanned(); }
+    void adoptLineIndex(const LineIndex &index);
+    qint64 estimatedLineStart(qint64 line);
+    qint64 nextLineStart(qint64 position) const;
+
+    const static int MAX_BACKWARD_SCAN = 64 * 1024;
+
+private:
+    QFile file;
+    const char *mapping = nullptr;
+    qint64 mappingSize = 0;
+
+    LineIndex lineIndex;
+};
+
+#endif // MAPPEDFILESTORAGE_H
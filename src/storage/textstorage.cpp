@@ -0,0 +1,48 @@
+#include "textstorage.h"
+
+
+/* Returns the number of bytes on the given line, excluding its line break
+ * (\n or \r\n), or -1 if there is no such line.
+ */
+qint64 TextStorage::lineLength(qint64 line)
+{
+    qint64 start = lineStart(line);
+
+    if (start == -1)
+    {
+        return -1;
+    }
+
+    qint64 nextStart = lineStart(line + 1);
+
+    // The last line has no line break after it
+    if (nextStart == -1)
+    {
+        return size() - start;
+    }
+
+    qint64 length = nextStart - start - 1;
+
+    if (length > 0 && bytes(nextStart - 2, 1).at(0) == '\r')
+    {
+        length--;
+    }
+
+    return length;
+}
+
+
+/* Returns the decoded text of the given line, without its line break,
+ * or a null string if there is no such line.
+ */
+QString TextStorage::lineText(qint64 line)
+{
+    qint64 length = lineLength(line);
+
+    if (length == -1)
+    {
+        return QString();
+    }
+
+    return QString::fromUtf8(bytes(lineStart(line), length));
+}
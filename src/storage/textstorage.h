@@ -0,0 +1,28 @@
+#ifndef TEXTSTORAGE_H
+#define TEXTSTORAGE_H
+#include <QByteArray>
+#include <QString>
+
+
+/* Minimal interface to a body of UTF-8 text that may be far too large to hold
+ * in a QString or QTextDocument. Positions and lengths are byte offsets, and
+ * lines are numbered from 0. Implementations are free to discover lines lazily,
+ * which is why the line queries are non-const.
+ */
+class TextStorage
+{
+public:
+    virtual ~TextStorage() {}
+
+    virtual qint64 size() const = 0;
+    virtual QByteArray bytes(qint64 position, qint64 length) const = 0;
+
+    virtual qint64 lineStart(qint64 line) = 0;
+    virtual qint64 lineCount() = 0;
+    virtual qint64 lineCountEstimate() { return lineCount(); }
+
+    qint64 lineLength(qint64 line);
+    QString lineText(qint64 line);
+};
+
+#endif // TEXTSTORAGE_H
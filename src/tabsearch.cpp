@@ -0,0 +1,214 @@
+#include "tabsearch.h"
+#include "regexsearcher.h"
+#include <QRunnable>
+#include <QThreadPool>
+#include <QMutexLocker>
+
+
+/* Searches one tab's snapshot on Qt's global thread pool, and reports it to the TabSearch if that
+ * hasn't been deleted in the meantime.
+ */
+class TabSearchTask : public QRunnable
+{
+public:
+    TabSearchTask(QSharedPointer<TabSearchState> state, int index, const QString &text)
+        : state(state), index(index), text(text)
+    {
+    }
+
+    void run() override
+    {
+        search(&state->results[index]);
+
+        QMutexLocker locker(&state->lock);
+        if (state->search)
+        {
+            QMetaObject::invokeMethod(state->search, "on_tabSearched", Qt::QueuedConnection, Q_ARG(int, index));
+        }
+    }
+
+private:
+    void search(TabMatches *matches);
+
+    QSharedPointer<TabSearchState> state;
+    int index;
+    QString text;
+};
+
+
+/* Initializes the state shared by a TabSearch and its tasks.
+ */
+TabSearchState::TabSearchState(const QString &query, const QString &with, bool caseSensitive, bool wholeWords, bool regex, bool replacing)
+    : query(query), with(with), caseSensitive(caseSensitive), wholeWords(wholeWords), regex(regex), replacing(replacing),
+      textSearcher(query, caseSensitive, wholeWords), search(nullptr)
+{
+}
+
+
+/* Initializes this TabSearch for the given tabs. Call start() to begin.
+ * A regular expression must be valid (see RegexSearcher::isValid).
+ */
+TabSearch::TabSearch(const QVector<Editor*> &tabs, const QString &query, const QString &with, bool caseSensitive, bool wholeWords, bool regex, bool replacing, QObject *parent)
+    : QObject(parent), state(new TabSearchState(query, with, caseSensitive, wholeWords, regex, replacing))
+{
+    state->search = this;
+    state->results.resize(tabs.size());
+
+    for (int i = 0; i < tabs.size(); i++)
+    {
+        state->results[i].tab = tabs[i];
+        state->results[i].tabName = tabs[i]->getFileName();
+        state->results[i].loading = tabs[i]->isLoading();
+    }
+}
+
+
+/* Cancels the search. Tabs that are still being searched aren't waited for; once this returns,
+ * they can no longer report back, and reports already on their way are discarded along with this.
+ */
+TabSearch::~TabSearch()
+{
+    state->canceled.storeRelease(1);
+
+    QMutexLocker locker(&state->lock);
+    state->search = nullptr;
+}
+
+
+/* Starts searching as many tabs as there are threads in the pool; the rest follow as those are
+ * done (see startNextTab). Tabs that are still loading aren't searched.
+ */
+void TabSearch::start()
+{
+    timer.start();
+
+    for (int i = 0; i < state->results.size(); i++)
+    {
+        if (state->results[i].loading)
+        {
+            QMetaObject::invokeMethod(this, "on_tabSearched", Qt::QueuedConnection, Q_ARG(int, i));
+        }
+    }
+
+    for (int i = 0; i < QThreadPool::globalInstance()->maxThreadCount(); i++)
+    {
+        startNextTab();
+    }
+
+    if (state->results.isEmpty())
+    {
+        QMetaObject::invokeMethod(this, "done", Qt::QueuedConnection);
+    }
+}
+
+
+/* Takes a snapshot of the next tab that's to be searched, if there are any left, and hands it to
+ * the thread pool. A tab that has been closed since the search started is just reported as done.
+ */
+void TabSearch::startNextTab()
+{
+    while (nextTab < state->results.size() && state->results[nextTab].loading)
+    {
+        nextTab++;
+    }
+
+    if (nextTab == state->results.size())
+    {
+        return;
+    }
+
+    int index = nextTab++;
+    TabMatches &matches = state->results[index];
+
+    if (!matches.tab)
+    {
+        QMetaObject::invokeMethod(this, "on_tabSearched", Qt::QueuedConnection, Q_ARG(int, index));
+        return;
+    }
+
+    // The task has its own copy of the snapshot, which it lets go of as soon as it's done
+    matches.revision = matches.tab->document()->revision();
+    QThreadPool::globalInstance()->start(new TabSearchTask(state, index, matches.tab->document()->toPlainText()));
+}
+
+
+/* Runs on a pooled thread. Finds every match in the snapshot (and works out their replacements
+ * if replacing), and lists them by line for the results panel, unless the search is canceled first.
+ */
+void TabSearchTask::search(TabMatches *matches)
+{
+    if (!state->regex)
+    {
+        matches->starts = state->textSearcher.findAll(text);
+        matches->lengths = QVector<int>(matches->starts.size(), state->textSearcher.getQueryLength());
+
+        if (state->replacing)
+        {
+            matches->replacements = QVector<QString>(matches->starts.size(), state->with);
+        }
+    }
+    else
+    {
+        // Every task compiles its own copy, so no two threads ever share a QRegularExpression
+        RegexSearcher searcher(state->query, state->caseSensitive, state->wholeWords);
+        searcher.setReplacement(state->with);
+
+        RegexMatchBatch batch;
+        int lineStart = 0;
+
+        while (lineStart <= text.length() && !state->canceled.loadAcquire())
+        {
+            int lineEnd = text.indexOf('\n', lineStart);
+            if (lineEnd == -1)
+            {
+                lineEnd = text.length();
+            }
+
+            QString line = QString::fromRawData(text.constData() + lineStart, lineEnd - lineStart);
+
+            if (searcher.findInLine(line, lineStart, batch, state->replacing, QDeadlineTimer(TabSearch::LINE_TIMEOUT)) != RegexSearcher::Searched)
+            {
+                matches->numSkippedLines++;
+            }
+
+            lineStart = lineEnd + 1;
+        }
+
+        matches->starts = batch.starts;
+        matches->lengths = batch.lengths;
+        matches->replacements = batch.replacements;
+    }
+
+    if (!state->canceled.loadAcquire())
+    {
+        matches->listed = ListedMatch::listAll(text, matches->starts, TabSearch::MAX_LISTED_MATCHES);
+    }
+}
+
+
+/* Called when a tab has been searched. Replaces its matches if replacing (and the tab hasn't been
+ * closed or edited in the meantime), then reports it and starts on the next tab, and reports the
+ * whole search once every tab has been searched.
+ */
+void TabSearch::on_tabSearched(int index)
+{
+    TabMatches &matches = state->results[index];
+    numSearched++;
+
+    if (state->replacing && !matches.starts.isEmpty() && matches.tab && matches.tab->document()->revision() == matches.revision)
+    {
+        matches.tab->replaceMatches(matches.starts, matches.lengths, matches.replacements);
+        matches.replaced = true;
+    }
+
+    // Only the positions were needed for replacing; the listed matches are what's reported
+    matches.replacements.clear();
+
+    emit(tabSearched(index));
+    startNextTab();
+
+    if (numSearched == state->results.size())
+    {
+        emit(done());
+    }
+}
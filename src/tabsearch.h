@@ -0,0 +1,110 @@
+#ifndef TABSEARCH_H
+#define TABSEARCH_H
+#include "editor.h"
+#include "textsearcher.h"
+#include "searchresultspanel.h"
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QElapsedTimer>
+
+
+/* What a TabSearch found in one tab. Up to MAX_LISTED_MATCHES of the matches are listed by line.
+ */
+struct TabMatches
+{
+    QPointer<Editor> tab;
+    QString tabName;
+    int revision = 0;
+    bool loading = false;
+    bool replaced = false;
+    int numSkippedLines = 0;
+    QVector<int> starts;
+    QVector<int> lengths;
+    QVector<QString> replacements;
+    QVector<ListedMatch> listed;
+};
+
+
+class TabSearch;
+
+
+/* What a TabSearch shares with the tasks searching its tabs. The tasks each hold on to it, so it
+ * outlives a canceled TabSearch until the last of them is done.
+ */
+struct TabSearchState
+{
+    TabSearchState(const QString &query, const QString &with, bool caseSensitive, bool wholeWords, bool regex, bool replacing);
+
+    QString query;
+    QString with;
+    bool caseSensitive;
+    bool wholeWords;
+    bool regex;
+    bool replacing;
+    TextSearcher textSearcher;
+
+    // Each task only ever touches its own tab's entry, and the vector is never resized once they've started
+    QVector<TabMatches> results;
+
+    // Set (to null) when the TabSearch is deleted; held while a task reports a tab to it
+    QAtomicInt canceled;
+    QMutex lock;
+    TabSearch *search;
+};
+
+
+/* Searches (and optionally replaces in) every open tab at once. A snapshot of each tab's text is
+ * searched on its own thread in Qt's global pool, which has as many threads as there are cores, so the search
+ * scales with the cores rather than the tabs. Plain queries are searched for with TextSearcher and
+ * regular expressions with RegexSearcher, as in a single tab; a regular expression is given up on
+ * for any line it takes more than LINE_TIMEOUT milliseconds on.
+ *
+ * Taking a snapshot has to happen on the GUI thread, so tabs aren't all snapshotted up front:
+ * a tab is only snapshotted once there's a thread free to search it, and the next one once a
+ * tab is done, so the GUI never spends longer than one tab's snapshot at a time on it.
+ *
+ * Each tab is reported (with tabSearched) as soon as it's done, and its matches are replaced right
+ * away in one edit block, so each tab gets its own undo step. A tab that has been edited since its
+ * snapshot was taken is left alone, as are tabs that are still loading.
+ *
+ * Deleting a TabSearch cancels it without waiting: tabs that are still being searched finish in
+ * the background (regular expressions stop at the next line), on what they share with it (see
+ * TabSearchState), and their results are dropped.
+ */
+class TabSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    TabSearch(const QVector<Editor*> &tabs, const QString &query, const QString &with, bool caseSensitive, bool wholeWords, bool regex, bool replacing, QObject *parent = nullptr);
+    ~TabSearch() override;
+
+    void start();
+    inline const TabMatches &matchesIn(int index) const { return state->results[index]; }
+    inline int numTabs() const { return state->results.size(); }
+    inline qint64 getElapsedTime() const { return timer.elapsed(); }
+    inline bool isReplacing() const { return state->replacing; }
+
+    const static int MAX_LISTED_MATCHES = 1000;
+    const static int LINE_TIMEOUT = 1000;
+
+signals:
+    void tabSearched(int index);
+    void done();
+
+private slots:
+    void on_tabSearched(int index);
+
+private:
+    void startNextTab();
+
+    QSharedPointer<TabSearchState> state;
+    int nextTab = 0;
+    int numSearched = 0;
+    QElapsedTimer timer;
+};
+
+#endif // TABSEARCH_H
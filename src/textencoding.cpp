@@ -0,0 +1,123 @@
+#include "textencoding.h"
+#include "utf8decoder.h"
+
+
+/* Returns the codec for this encoding, falling back to the locale's codec if Qt doesn't know it.
+ */
+QTextCodec *TextEncoding::codec() const
+{
+    QTextCodec *codec = QTextCodec::codecForName(codecName);
+    return codec ? codec : QTextCodec::codecForLocale();
+}
+
+
+/* Returns true if this is UTF-8, which the loader decodes with Utf8Decoder rather than a QTextCodec.
+ */
+bool TextEncoding::isUtf8() const
+{
+    return codec()->mibEnum() == 106;
+}
+
+
+/* Returns the encoding used for new documents.
+ */
+TextEncoding TextEncoding::localeDefault()
+{
+    TextEncoding encoding;
+    encoding.codecName = QTextCodec::codecForLocale()->name();
+
+#ifdef Q_OS_WIN
+    encoding.lineEnding = "\r\n";
+#endif
+
+    return encoding;
+}
+
+
+/* Returns the line ending of the first line break in the given text ("\r\n", "\n" or "\r"),
+ * or a null string if there isn't one. A "\r" at the very end might be the first half of a
+ * "\r\n", so it doesn't count.
+ */
+QString TextEncoding::detectLineEnding(const QString &text)
+{
+    for (int i = 0; i < text.length(); i++)
+    {
+        if (text[i] == '\n')
+        {
+            return "\n";
+        }
+
+        if (text[i] == '\r' && i + 1 < text.length())
+        {
+            return text[i + 1] == '\n' ? "\r\n" : "\r";
+        }
+    }
+
+    return QString();
+}
+
+
+/* Guesses the encoding of a file from its first few bytes (at most SAMPLE_SIZE are looked at).
+ * A byte order mark settles it. Otherwise, text with a zero in nearly every other byte is
+ * taken to be UTF-16 (that's what ASCII looks like in it), then valid UTF-8 is taken to be
+ * UTF-8, and anything else is read as a single-byte encoding, which can't garble anything.
+ */
+TextEncoding TextEncoding::detect(const QByteArray &fileStart)
+{
+    const QByteArray sample = fileStart.left(SAMPLE_SIZE);
+    TextEncoding encoding;
+
+    if (sample.startsWith("\xEF\xBB\xBF"))
+    {
+        encoding.codecName = "UTF-8";
+        encoding.hasByteOrderMark = true;
+        return encoding;
+    }
+
+    if (sample.startsWith("\xFF\xFE") || sample.startsWith("\xFE\xFF"))
+    {
+        encoding.codecName = sample.startsWith("\xFF\xFE") ? "UTF-16LE" : "UTF-16BE";
+        encoding.hasByteOrderMark = true;
+        return encoding;
+    }
+
+    int zerosAtEvenOffsets = 0;
+    int zerosAtOddOffsets = 0;
+
+    for (int i = 0; i < sample.size(); i++)
+    {
+        if (sample[i] == '\0')
+        {
+            (i % 2 == 0) ? zerosAtEvenOffsets++ : zerosAtOddOffsets++;
+        }
+    }
+
+    int numPairs = sample.size() / 2;
+
+    if (numPairs > 0)
+    {
+        // Mostly-ASCII UTF-16 has a zero in almost every high byte and hardly any in the low bytes
+        if (zerosAtOddOffsets > numPairs * 2 / 5 && zerosAtEvenOffsets < numPairs / 10)
+        {
+            encoding.codecName = "UTF-16LE";
+            return encoding;
+        }
+
+        if (zerosAtEvenOffsets > numPairs * 2 / 5 && zerosAtOddOffsets < numPairs / 10)
+        {
+            encoding.codecName = "UTF-16BE";
+            return encoding;
+        }
+    }
+
+    if (Utf8Decoder::isValid(sample))
+    {
+        encoding.codecName = "UTF-8";
+        return encoding;
+    }
+
+    // Prefer the locale's own single-byte codec (e.g., Windows-1252) when it isn't UTF-8 itself
+    QTextCodec *localeCodec = QTextCodec::codecForLocale();
+    encoding.codecName = localeCodec->mibEnum() == 106 ? QByteArray("ISO-8859-1") : localeCodec->name();
+    return encoding;
+}
@@ -0,0 +1,27 @@
+#ifndef TEXTENCODING_H
+#define TEXTENCODING_H
+#include <QByteArray>
+#include <QTextCodec>
+#include <QString>
+
+
+/* The encoding a file was read in, so that it can be written back out the same way.
+ * That includes its line ending, which QTextDocument forgets: every line break becomes a block.
+ */
+struct TextEncoding
+{
+    QByteArray codecName;
+    bool hasByteOrderMark = false;
+    QString lineEnding = "\n";
+
+    QTextCodec *codec() const;
+    bool isUtf8() const;
+
+    static TextEncoding detect(const QByteArray &fileStart);
+    static TextEncoding localeDefault();
+    static QString detectLineEnding(const QString &text);
+
+    const static int SAMPLE_SIZE = 64 * 1024;
+};
+
+#endif // TEXTENCODING_H
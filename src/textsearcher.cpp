@@ -0,0 +1,412 @@
+#include "textsearcher.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTSEARCHER_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 can only be enabled per function (and detected at runtime) with GCC and Clang
+#if defined(TEXTSEARCHER_SSE2) && defined(__GNUC__)
+#define TEXTSEARCHER_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // Returns the first window from the given one up to lastWindow that starts with first and ends
+    // (lastOffset characters further on) with last, or -1 if there's none
+    typedef int (*CandidateFinder)(const ushort *text, int from, int lastWindow, ushort first, ushort last, int lastOffset, const int *shifts);
+
+    int findCandidateScalar(const ushort *text, int from, int lastWindow, ushort first, ushort last, int lastOffset, const int *shifts)
+    {
+        int i = from;
+
+        while (i <= lastWindow)
+        {
+            const ushort character = text[i + lastOffset];
+
+            if (character == last && text[i] == first)
+            {
+                return i;
+            }
+
+            i += shifts[character % TextSearcher::SHIFT_TABLE_SIZE];
+        }
+
+        return -1;
+    }
+
+#ifdef TEXTSEARCHER_SSE2
+    int findCandidateSse2(const ushort *text, int from, int lastWindow, ushort first, ushort last, int lastOffset, const int *shifts)
+    {
+        const __m128i firsts = _mm_set1_epi16(static_cast<short>(first));
+        const __m128i lasts = _mm_set1_epi16(static_cast<short>(last));
+        int i = from;
+
+        for (; i + 8 <= lastWindow + 1; i += 8)
+        {
+            __m128i starts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            __m128i ends = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + lastOffset));
+
+            // Two mask bits per window, both set if the window starts and ends right
+            int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(starts, firsts), _mm_cmpeq_epi16(ends, lasts)));
+
+            if (mask != 0)
+            {
+                return i + static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(mask))) / 2;
+            }
+        }
+
+        return findCandidateScalar(text, i, lastWindow, first, last, lastOffset, shifts);
+    }
+#endif
+
+#ifdef TEXTSEARCHER_AVX2
+    __attribute__((target("avx2")))
+    int findCandidateAvx2(const ushort *text, int from, int lastWindow, ushort first, ushort last, int lastOffset, const int *shifts)
+    {
+        const __m256i firsts = _mm256_set1_epi16(static_cast<short>(first));
+        const __m256i lasts = _mm256_set1_epi16(static_cast<short>(last));
+        int i = from;
+
+        for (; i + 16 <= lastWindow + 1; i += 16)
+        {
+            __m256i starts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+            __m256i ends = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + lastOffset));
+            int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(starts, firsts), _mm256_cmpeq_epi16(ends, lasts)));
+
+            if (mask != 0)
+            {
+                return i + static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(mask))) / 2;
+            }
+        }
+
+        return findCandidateSse2(text, i, lastWindow, first, last, lastOffset, shifts);
+    }
+#endif
+
+    bool cpuSupportsAvx2()
+    {
+#ifdef TEXTSEARCHER_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    CandidateFinder pickCandidateFinder()
+    {
+#ifdef TEXTSEARCHER_AVX2
+        if (cpuSupportsAvx2())
+        {
+            return findCandidateAvx2;
+        }
+#endif
+#ifdef TEXTSEARCHER_SSE2
+        return findCandidateSse2;
+#else
+        return findCandidateScalar;
+#endif
+    }
+
+    // Only ever changed by useFilterPath, which is meant for benchmarks and tests
+    CandidateFinder findCandidate = pickCandidateFinder();
+
+
+    /* Returns where the maximal suffix of the given string starts, less one, under the usual order
+     * of characters or (if reversed) the opposite one, and sets period to the period of that suffix.
+     * See Crochemore and Perrin, "Two-way string-matching" (1991).
+     */
+    int maximalSuffix(const ushort *string, int length, bool reversed, int &period)
+    {
+        int suffix = -1;
+        int j = 0;
+        int k = 1;
+        period = 1;
+
+        while (j + k < length)
+        {
+            ushort a = string[j + k];
+            ushort b = string[suffix + k];
+
+            if (reversed ? a > b : a < b)
+            {
+                j += k;
+                k = 1;
+                period = j - suffix;
+            }
+            else if (a == b)
+            {
+                if (k != period)
+                {
+                    k++;
+                }
+                else
+                {
+                    j += period;
+                    k = 1;
+                }
+            }
+            else
+            {
+                suffix = j;
+                j = suffix + 1;
+                k = period = 1;
+            }
+        }
+
+        return suffix;
+    }
+}
+
+
+/* Prepares a search for the given query, working out the shift table for its characters
+ * and where to split it for the Two-Way algorithm.
+ */
+TextSearcher::TextSearcher(const QString &query, bool caseSensitive, bool wholeWords)
+{
+    this->query = caseSensitive ? query : fold(query);
+    this->caseSensitive = caseSensitive;
+    this->wholeWords = wholeWords;
+
+    // Characters that share a low byte share a shift, which can only make the shift smaller (never wrong)
+    int length = this->query.length();
+    for (int i = 0; i < SHIFT_TABLE_SIZE; i++)
+    {
+        shifts[i] = length;
+    }
+
+    for (int i = 0; i < length - 1; i++)
+    {
+        shifts[this->query.at(i).unicode() % SHIFT_TABLE_SIZE] = length - 1 - i;
+    }
+
+    if (length < 2)
+    {
+        return;
+    }
+
+    const ushort *needle = this->query.utf16();
+    int suffixPeriod;
+    int reversedPeriod;
+    int suffix = maximalSuffix(needle, length, false, suffixPeriod);
+    int reversedSuffix = maximalSuffix(needle, length, true, reversedPeriod);
+
+    criticalPosition = qMax(suffix, reversedSuffix);
+    period = suffix > reversedSuffix ? suffixPeriod : reversedPeriod;
+    periodic = std::memcmp(needle, needle + period, static_cast<size_t>(criticalPosition + 1) * sizeof(ushort)) == 0;
+
+    if (!periodic)
+    {
+        period = qMax(criticalPosition + 1, length - criticalPosition - 1) + 1;
+    }
+}
+
+
+/* Finds candidates the given way from now on. Returns false (and changes nothing) if that way
+ * wasn't built in or the CPU doesn't support it.
+ */
+bool TextSearcher::useFilterPath(FilterPath path)
+{
+    switch (path)
+    {
+    case ScalarFilter:
+        findCandidate = findCandidateScalar;
+        return true;
+#ifdef TEXTSEARCHER_SSE2
+    case Sse2Filter:
+        findCandidate = findCandidateSse2;
+        return true;
+#endif
+#ifdef TEXTSEARCHER_AVX2
+    case Avx2Filter:
+        if (cpuSupportsAvx2())
+        {
+            findCandidate = findCandidateAvx2;
+            return true;
+        }
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+
+/* Returns the way candidates are being found.
+ */
+TextSearcher::FilterPath TextSearcher::filterPath()
+{
+#ifdef TEXTSEARCHER_AVX2
+    if (findCandidate == findCandidateAvx2)
+    {
+        return Avx2Filter;
+    }
+#endif
+#ifdef TEXTSEARCHER_SSE2
+    if (findCandidate == findCandidateSse2)
+    {
+        return Sse2Filter;
+    }
+#endif
+    return ScalarFilter;
+}
+
+
+/* Returns the positions of all the (non-overlapping) matches in the given text, in order.
+ */
+QVector<int> TextSearcher::findAll(const QString &text) const
+{
+    QVector<int> matches;
+    const int length = query.length();
+
+    if (length == 0 || length > text.length())
+    {
+        return matches;
+    }
+
+    const QString haystack = caseSensitive ? text : fold(text);
+
+    if (length == 1)
+    {
+        for (int i = haystack.indexOf(query.at(0)); i != -1; i = haystack.indexOf(query.at(0), i + 1))
+        {
+            if (!wholeWords || isWholeWordAt(text, i))
+            {
+                matches.append(i);
+            }
+        }
+
+        return matches;
+    }
+
+    const ushort *data = haystack.utf16();
+    const ushort *needle = query.utf16();
+    const int lastWindow = haystack.length() - length;
+    qint64 comparisons = 0;
+    int i = 0;
+
+    while ((i = findCandidate(data, i, lastWindow, needle[0], needle[length - 1], length - 1, shifts)) != -1)
+    {
+        int k = 1;
+        while (k < length - 1 && data[i + k] == needle[k])
+        {
+            k++;
+        }
+
+        comparisons += k;
+
+        if (k == length - 1 && (!wholeWords || isWholeWordAt(text, i)))
+        {
+            matches.append(i);
+            i += length;
+        }
+        else if (comparisons > VERIFICATION_BUDGET * (static_cast<qint64>(i) + length))
+        {
+            findAllTwoWay(haystack, text, i + 1, matches);
+            break;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return matches;
+}
+
+
+/* Appends the positions of the matches in the given (folded, if need be) haystack from the given
+ * position on. The query was split at its critical position when this TextSearcher was made; a
+ * window's right half is compared first, left to right, and only if it matches is the left half
+ * compared, right to left. A mismatch in the right half moves the window past it. Once the right half
+ * matches, the window moves by the query's period (if the left half repeats in the right, in which case
+ * the part of the query known to match again at the new window isn't compared twice) or by more than
+ * half the query (if it doesn't), so no character is looked at more than twice.
+ */
+void TextSearcher::findAllTwoWay(const QString &haystack, const QString &text, int from, QVector<int> &matches) const
+{
+    const ushort *data = haystack.utf16();
+    const ushort *needle = query.utf16();
+    const int length = query.length();
+    const int lastWindow = haystack.length() - length;
+    int matchedPrefix = -1;
+    int j = from;
+
+    while (j <= lastWindow)
+    {
+        int i = qMax(criticalPosition, matchedPrefix) + 1;
+        while (i < length && needle[i] == data[i + j])
+        {
+            i++;
+        }
+
+        if (i < length)
+        {
+            j += i - criticalPosition;
+            matchedPrefix = -1;
+            continue;
+        }
+
+        i = criticalPosition;
+        while (i > matchedPrefix && needle[i] == data[i + j])
+        {
+            i--;
+        }
+
+        if (i <= matchedPrefix && (!wholeWords || isWholeWordAt(text, j)))
+        {
+            matches.append(j);
+            j += length;
+            matchedPrefix = -1;
+        }
+        else
+        {
+            j += period;
+            matchedPrefix = periodic ? length - period - 1 : -1;
+        }
+    }
+}
+
+
+/* Returns true if the match at the given position in the given text is a whole word, i.e., it
+ * isn't run into by letters or digits on either side.
+ */
+bool TextSearcher::isWholeWordAt(const QString &text, int start) const
+{
+    int end = start + query.length();
+    bool startsWord = start == 0 || !text.at(start - 1).isLetterOrNumber();
+    bool endsWord = end == text.length() || !text.at(end).isLetterOrNumber();
+
+    return startsWord && endsWord;
+}
+/* Returns the given text with every character case-folded on its own (both halves of a surrogate
+ * pair together), so that the result is exactly as long as the text.
+ */
+QString TextSearcher::fold(const QString &text)
+{
+    QString folded = text;
+    QChar *data = folded.data();
+    const int length = folded.length();
+
+    for (int i = 0; i < length; i++)
+    {
+        if (data[i].isHighSurrogate() && i + 1 < length && data[i + 1].isLowSurrogate())
+        {
+            uint character = QChar::toCaseFolded(QChar::surrogateToUcs4(data[i], data[i + 1]));
+            data[i] = QChar::highSurrogate(character);
+            data[i + 1] = QChar::lowSurrogate(character);
+            i++;
+        }
+        else
+        {
+            data[i] = data[i].toCaseFolded();
+        }
+    }
+
+    return folded;
+}
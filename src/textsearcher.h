@@ -0,0 +1,59 @@
+#ifndef TEXTSEARCHER_H
+#define TEXTSEARCHER_H
+#include <QString>
+#include <QVector>
+
+
+/* Finds every occurrence of a query in a flat snapshot of a document in one pass, instead of
+ * stepping through it one match at a time the way QTextDocument::find does.
+ *
+ * Candidate windows are found by their first and last characters alone: 8 or 16 windows at a
+ * time with SSE2 or AVX2 (picked at runtime, as in Utf8Decoder), or with Horspool's algorithm
+ * where neither is available, which moves a window that doesn't end right ahead by as far as its
+ * last character allows. Only candidates have the rest of their characters compared. A single
+ * character is searched for with QString::indexOf, which Qt vectorizes.
+ *
+ * Text that keeps almost matching (say, a query of "aaab" in a run of a's) would make comparing
+ * candidates quadratic, so once they've taken more than VERIFICATION_BUDGET comparisons per
+ * character of text, the rest of the text is searched with the Two-Way algorithm instead, which
+ * never looks at a character of the text more than twice.
+ *
+ * Case-insensitive searches compare case-folded copies of the query and the text. Folding is done
+ * one character at a time, so every character keeps its offset and matches are positions in the
+ * original text. Whole words are matched the way QTextDocument::FindWholeWords matches them.
+ */
+class TextSearcher
+{
+public:
+    TextSearcher(const QString &query, bool caseSensitive, bool wholeWords);
+
+    QVector<int> findAll(const QString &text) const;
+    int getQueryLength() const { return query.length(); }
+
+    // The ways candidates can be found; the fastest one the CPU supports is used by default
+    enum FilterPath { ScalarFilter, Sse2Filter, Avx2Filter };
+    static bool useFilterPath(FilterPath path);
+    static FilterPath filterPath();
+
+    const static int SHIFT_TABLE_SIZE = 256;
+    const static int VERIFICATION_BUDGET = 4;
+
+private:
+    void findAllTwoWay(const QString &haystack, const QString &text, int from, QVector<int> &matches) const;
+    bool isWholeWordAt(const QString &text, int start) const;
+    static QString fold(const QString &text);
+
+    QString query;
+    bool caseSensitive;
+    bool wholeWords;
+
+    // shifts[c] is how far a window can move if its last character's low byte is c
+    int shifts[SHIFT_TABLE_SIZE];
+
+    // The query's critical factorization (see findAllTwoWay), and how far a window moves once its right half matches
+    int criticalPosition = 0;
+    int period = 1;
+    bool periodic = false;
+};
+
+#endif // TEXTSEARCHER_H
@@ -0,0 +1,335 @@
+#include "utf8decoder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 can only be enabled per function (and detected at runtime) with GCC and Clang
+#if defined(UTF8DECODER_SSE2) && defined(__GNUC__)
+#define UTF8DECODER_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    const ushort REPLACEMENT_CHARACTER = 0xFFFD;
+
+    // Widens the run of ASCII bytes at the start of the input into UTF-16. Returns the length of the run.
+    typedef qint64 (*AsciiWidener)(const uchar *in, qint64 length, ushort *out);
+
+    qint64 widenAsciiScalar(const uchar *in, qint64 length, ushort *out)
+    {
+        qint64 i = 0;
+
+        while (i < length && in[i] < 0x80)
+        {
+            out[i] = in[i];
+            i++;
+        }
+
+        return i;
+    }
+
+#ifdef UTF8DECODER_SSE2
+    qint64 widenAsciiSse2(const uchar *in, qint64 length, ushort *out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        qint64 i = 0;
+
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+
+            // A set high bit anywhere means this chunk isn't pure ASCII
+            if (_mm_movemask_epi8(chunk) != 0)
+            {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(chunk, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(chunk, zero));
+        }
+
+        return i + widenAsciiScalar(in + i, length - i, out + i);
+    }
+#endif
+
+#ifdef UTF8DECODER_AVX2
+    __attribute__((target("avx2")))
+    qint64 widenAsciiAvx2(const uchar *in, qint64 length, ushort *out)
+    {
+        qint64 i = 0;
+
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+
+            if (_mm256_movemask_epi8(chunk) != 0)
+            {
+                break;
+            }
+
+            __m256i low = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chunk));
+            __m256i high = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chunk, 1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16), high);
+        }
+
+        return i + widenAsciiSse2(in + i, length - i, out + i);
+    }
+#endif
+
+    bool cpuSupportsAvx2()
+    {
+#ifdef UTF8DECODER_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    AsciiWidener pickAsciiWidener()
+    {
+#ifdef UTF8DECODER_AVX2
+        if (cpuSupportsAvx2())
+        {
+            return widenAsciiAvx2;
+        }
+#endif
+#ifdef UTF8DECODER_SSE2
+        return widenAsciiSse2;
+#else
+        return widenAsciiScalar;
+#endif
+    }
+
+    // Only ever changed by useAsciiPath, which is meant for benchmarks and tests
+    AsciiWidener widenAscii = pickAsciiWidener();
+
+
+    /* Decodes as much of the input as possible into out, which must have room for length
+     * code units (UTF-8 never takes fewer bytes than UTF-16 takes code units). Stops early
+     * only at a multi-byte sequence that is cut off by the end of the input. Returns the
+     * number of code units written and sets consumed to the number of bytes decoded.
+     */
+    qint64 decode(const uchar *in, qint64 length, ushort *out, qint64 &consumed, bool &sawInvalidBytes)
+    {
+        qint64 i = 0;
+        qint64 o = 0;
+
+        while (i < length)
+        {
+            qint64 asciiRun = widenAscii(in + i, length - i, out + o);
+            i += asciiRun;
+            o += asciiRun;
+
+            if (i >= length)
+            {
+                break;
+            }
+
+            uchar lead = in[i];
+            int numContinuationBytes;
+            uint codePoint;
+            uint smallestCodePoint;
+
+            if ((lead & 0xE0) == 0xC0)
+            {
+                numContinuationBytes = 1;
+                codePoint = lead & 0x1F;
+                smallestCodePoint = 0x80;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                numContinuationBytes = 2;
+                codePoint = lead & 0x0F;
+                smallestCodePoint = 0x800;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                numContinuationBytes = 3;
+                codePoint = lead & 0x07;
+                smallestCodePoint = 0x10000;
+            }
+            else
+            {
+                out[o++] = REPLACEMENT_CHARACTER;
+                sawInvalidBytes = true;
+                i++;
+                continue;
+            }
+
+            qint64 numAvailable = qMin(qint64(numContinuationBytes), length - i - 1);
+            bool valid = true;
+
+            for (int k = 1; k <= numAvailable; k++)
+            {
+                uchar next = in[i + k];
+
+                if ((next & 0xC0) != 0x80)
+                {
+                    valid = false;
+                    break;
+                }
+
+                codePoint = (codePoint << 6) | (next & 0x3F);
+            }
+
+            // Cut off by the end of the input; the caller will retry it with the next chunk
+            if (valid && numAvailable < numContinuationBytes)
+            {
+                break;
+            }
+
+            // Reject overlong encodings, surrogates, and anything past the last code point
+            if (!valid || codePoint < smallestCodePoint || codePoint > 0x10FFFF ||
+                (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            {
+                out[o++] = REPLACEMENT_CHARACTER;
+                sawInvalidBytes = true;
+                i++;
+                continue;
+            }
+
+            if (codePoint >= 0x10000)
+            {
+                codePoint -= 0x10000;
+                out[o++] = static_cast<ushort>(0xD800 + (codePoint >> 10));
+                out[o++] = static_cast<ushort>(0xDC00 + (codePoint & 0x3FF));
+            }
+            else
+            {
+                out[o++] = static_cast<ushort>(codePoint);
+            }
+
+            i += numContinuationBytes + 1;
+        }
+
+        consumed = i;
+        return o;
+    }
+}
+
+
+/* Decodes the next chunk of the input. Bytes at the end of the chunk that only form
+ * part of a character are held back and decoded along with the next chunk.
+ */
+QString Utf8Decoder::toUnicode(const QByteArray &bytes)
+{
+    const QByteArray BYTE_ORDER_MARK("\xEF\xBB\xBF");
+    QByteArray input = pending.isEmpty() ? bytes : pending + bytes;
+    pending.clear();
+
+    const uchar *data = reinterpret_cast<const uchar*>(input.constData());
+    qint64 length = input.size();
+
+    // The byte order mark isn't part of the text
+    if (atStart && length > 0)
+    {
+        if (length < BYTE_ORDER_MARK.size() && BYTE_ORDER_MARK.startsWith(input))
+        {
+            pending = input;
+            return QString();
+        }
+
+        if (input.startsWith(BYTE_ORDER_MARK))
+        {
+            data += BYTE_ORDER_MARK.size();
+            length -= BYTE_ORDER_MARK.size();
+        }
+
+        atStart = false;
+    }
+
+    QString text(static_cast<int>(length), Qt::Uninitialized);
+    qint64 consumed = 0;
+    qint64 written = decode(data, length, reinterpret_cast<ushort*>(text.data()), consumed, sawInvalidBytes);
+    text.resize(static_cast<int>(written));
+
+    pending = QByteArray(reinterpret_cast<const char*>(data + consumed), static_cast<int>(length - consumed));
+    return text;
+}
+
+
+/* Signals the end of the input. Returns a replacement character if the input
+ * ended in the middle of a character, and an empty string otherwise.
+ */
+QString Utf8Decoder::flush()
+{
+    if (pending.isEmpty())
+    {
+        return QString();
+    }
+
+    pending.clear();
+    sawInvalidBytes = true;
+    return QString(QChar(REPLACEMENT_CHARACTER));
+}
+
+
+/* Switches every Utf8Decoder to the given way of widening ASCII, if this build and CPU support it.
+ * Returns false (changing nothing) if they don't. Not thread-safe: nothing may be decoding meanwhile.
+ */
+bool Utf8Decoder::useAsciiPath(AsciiPath path)
+{
+    switch (path)
+    {
+        case ScalarPath:
+            widenAscii = widenAsciiScalar;
+            return true;
+
+        case Sse2Path:
+#ifdef UTF8DECODER_SSE2
+            widenAscii = widenAsciiSse2;
+            return true;
+#else
+            return false;
+#endif
+
+        case Avx2Path:
+#ifdef UTF8DECODER_AVX2
+            if (cpuSupportsAvx2())
+            {
+                widenAscii = widenAsciiAvx2;
+                return true;
+            }
+#endif
+            return false;
+    }
+
+    return false;
+}
+
+
+/* Returns the way ASCII is currently being widened.
+ */
+Utf8Decoder::AsciiPath Utf8Decoder::asciiPath()
+{
+#ifdef UTF8DECODER_AVX2
+    if (widenAscii == widenAsciiAvx2)
+    {
+        return Avx2Path;
+    }
+#endif
+#ifdef UTF8DECODER_SSE2
+    if (widenAscii == widenAsciiSse2)
+    {
+        return Sse2Path;
+    }
+#endif
+    return ScalarPath;
+}
+
+
+/* Returns true if the given bytes are valid UTF-8. A character cut off at the very
+ * end doesn't count against them, since they may just be a sample of a longer input.
+ */
+bool Utf8Decoder::isValid(const QByteArray &bytes)
+{
+    Utf8Decoder decoder;
+    decoder.toUnicode(bytes);
+    return !decoder.hasError();
+}
@@ -0,0 +1,35 @@
+#ifndef UTF8DECODER_H
+#define UTF8DECODER_H
+#include <QByteArray>
+#include <QString>
+
+
+/* Stateful UTF-8 to UTF-16 decoder for the open path. Runs of ASCII, which make up
+ * the bulk of most source files and logs, are widened 16 or 32 bytes at a time with
+ * SSE2 or AVX2 (picked at runtime); everything else is validated and decoded by hand.
+ * Invalid bytes become U+FFFD, and a sequence cut off at the end of one chunk is
+ * completed with the start of the next.
+ */
+class Utf8Decoder
+{
+public:
+    Utf8Decoder() {}
+
+    QString toUnicode(const QByteArray &bytes);
+    QString flush();
+    inline bool hasError() const { return sawInvalidBytes; }
+
+    static bool isValid(const QByteArray &bytes);
+
+    // The ways runs of ASCII can be widened; the fastest one the CPU supports is used by default
+    enum AsciiPath { ScalarPath, Sse2Path, Avx2Path };
+    static bool useAsciiPath(AsciiPath path);
+    static AsciiPath asciiPath();
+
+private:
+    QByteArray pending;
+    bool atStart = true;
+    bool sawInvalidBytes = false;
+};
+
+#endif // UTF8DECODER_H
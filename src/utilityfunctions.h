@@ -7,7 +7,6 @@
 namespace Utility
 {
     QMessageBox::StandardButton promptYesOrNo(QWidget *parent, QString title, QString prompt);
-    bool codeBlockNotClosed(QString context, QChar startDelimiter, QChar endDelimiter);
 }
 
 #endif // UTILITYFUNCTIONS_H
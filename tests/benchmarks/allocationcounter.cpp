@@ -0,0 +1,59 @@
+#include "allocationcounter.h"
+#include <QAtomicInteger>
+#include <cstdlib>
+
+
+// Statically initialized, since the first allocations happen before any constructor runs
+static QBasicAtomicInteger<qint64> allocations = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+
+#ifdef __GLIBC__
+
+// glibc's own allocator, still reachable under these names once malloc and friends are replaced below
+// (which have to be declared exactly as glibc declares them, __THROW and all)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_malloc(size);
+}
+
+
+extern "C" void *calloc(size_t count, size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_calloc(count, size);
+}
+
+
+extern "C" void *realloc(void *pointer, size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_realloc(pointer, size);
+}
+
+#endif
+
+
+/* Returns true if allocations are being counted on this platform.
+ */
+bool AllocationCounter::isAvailable()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/* Returns the number of allocations made so far, by every thread.
+ */
+qint64 AllocationCounter::count()
+{
+    return allocations.loadAcquire();
+}
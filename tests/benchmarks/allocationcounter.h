@@ -0,0 +1,18 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+#include <QtGlobal>
+
+
+/* Counts every heap allocation the benchmarks make: calls to malloc, calloc and realloc, which is
+ * what Qt's containers allocate with and what operator new calls. Counting works by wrapping glibc's
+ * allocator, which only glibc allows, so on other C libraries isAvailable() is false and the
+ * count never changes.
+ */
+class AllocationCounter
+{
+public:
+    static bool isAvailable();
+    static qint64 count();
+};
+
+#endif // ALLOCATIONCOUNTER_H
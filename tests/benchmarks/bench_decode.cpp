@@ -0,0 +1,236 @@
+#include "bench_decode.h"
+#include "benchmarkreport.h"
+#include "fileloader.h"
+#include <QTest>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+
+
+/* Remembers which ASCII path the CPU picked, so that every row can go back to it.
+ */
+void BenchDecode::initTestCase()
+{
+    defaultPath = Utf8Decoder::asciiPath();
+}
+
+
+void BenchDecode::cleanup()
+{
+    Utf8Decoder::useAsciiPath(defaultPath);
+}
+
+
+void BenchDecode::decode_data()
+{
+    addCorpusColumn();
+    QTest::addColumn<QString>("decoder");
+
+    QStringList corpora = {"generated-10485760", "generated-104857600", "generated-1073741824-streamed"};
+    corpora += BenchmarkReport::corpusFiles();
+
+    for (const QString &name : corpora)
+    {
+        for (const QString &decoder : {"QTextStream-readAll", "QTextCodec", "Utf8Decoder-scalar", "Utf8Decoder-sse2", "Utf8Decoder-avx2"})
+        {
+            QTest::newRow(qPrintable(QFileInfo(name).fileName() + " " + decoder)) << name << decoder;
+        }
+    }
+}
+
+
+/* Times one decoder over one corpus, after checking that it decodes the corpus the way QTextCodec does.
+ * Invalid bytes needn't decode the same: decoders are free to replace them with U+FFFD differently.
+ */
+void BenchDecode::decode()
+{
+    QFETCH(QString, corpusName);
+    QFETCH(QString, decoder);
+
+    const Utf8Decoder::AsciiPath paths[] = {Utf8Decoder::ScalarPath, Utf8Decoder::Sse2Path, Utf8Decoder::Avx2Path};
+    const QStringList pathNames = {"Utf8Decoder-scalar", "Utf8Decoder-sse2", "Utf8Decoder-avx2"};
+    int path = pathNames.indexOf(decoder);
+
+    if (path != -1 && !Utf8Decoder::useAsciiPath(paths[path]))
+    {
+        QSKIP("This build or CPU doesn't support that path");
+    }
+
+    int repeats;
+    const QByteArray &bytes = corpus(corpusName, repeats);
+
+    if (Utf8Decoder::isValid(bytes))
+    {
+        QVERIFY(decodeWith(decoder, bytes) == expectedText);
+    }
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            decodeWith(decoder, bytes);
+        }
+
+        iterations++;
+    }
+
+    double milliseconds = static_cast<double>(timer.nsecsElapsed()) / qMax(iterations, 1) / 1e6;
+    qint64 totalBytes = static_cast<qint64>(bytes.size()) * repeats;
+
+    QJsonObject result;
+    result["corpus"] = QFileInfo(corpusName).fileName();
+    result["decoder"] = decoder;
+    result["bytes"] = totalBytes;
+    result["streamedInBlocksOf"] = repeats > 1 ? bytes.size() : QJsonValue();
+    result["iterations"] = iterations;
+    result["ms"] = milliseconds;
+    result["megabytesPerSecond"] = totalBytes / (1024.0 * 1024.0) / qMax(milliseconds / 1000, 1e-9);
+    BenchmarkReport::record(result);
+}
+
+
+void BenchDecode::roundTrips_data()
+{
+    addCorpusColumn();
+
+    QStringList corpora = {"generated-10485760"};
+    corpora += BenchmarkReport::corpusFiles();
+
+    for (const QString &name : corpora)
+    {
+        QTest::newRow(qPrintable(QFileInfo(name).fileName())) << name;
+    }
+}
+
+
+/* Checks that valid UTF-8 encodes back to the bytes it was decoded from, less its byte order mark,
+ * which isn't text.
+ */
+void BenchDecode::roundTrips()
+{
+    QFETCH(QString, corpusName);
+
+    int repeats;
+    const QByteArray &bytes = corpus(corpusName, repeats);
+
+    if (!Utf8Decoder::isValid(bytes))
+    {
+        QSKIP("Invalid UTF-8 can't round-trip");
+    }
+
+    const QByteArray BYTE_ORDER_MARK("\xEF\xBB\xBF");
+    QVERIFY(expectedText.toUtf8() == (bytes.startsWith(BYTE_ORDER_MARK) ? bytes.mid(BYTE_ORDER_MARK.size()) : bytes));
+}
+
+
+void BenchDecode::addCorpusColumn()
+{
+    QTest::addColumn<QString>("corpusName");
+}
+
+
+/* Returns the bytes of the corpus with the given name: generated text of a given size ("generated-<bytes>",
+ * streamed if it ends in "-streamed") or a file. Sets repeats to how many times the bytes make up the corpus.
+ * Also decodes the corpus with QTextCodec, for the decoders to be checked against.
+ */
+const QByteArray &BenchDecode::corpus(const QString &name, int &repeats)
+{
+    const QString GENERATED = "generated-";
+    const QString STREAMED = "-streamed";
+    bool streamed = name.endsWith(STREAMED);
+    qint64 size = name.startsWith(GENERATED) ? name.mid(GENERATED.length()).remove(STREAMED).toLongLong() : 0;
+
+    repeats = streamed ? static_cast<int>(size / STREAMED_BLOCK_SIZE) : 1;
+
+    if (name == loadedCorpus)
+    {
+        return corpusBytes;
+    }
+
+    loadedCorpus = name;
+    corpusBytes.clear();
+    expectedText.clear();
+
+    if (name.startsWith(GENERATED))
+    {
+        corpusBytes = generateText(streamed ? static_cast<int>(STREAMED_BLOCK_SIZE) : static_cast<int>(size));
+    }
+    else
+    {
+        QFile file(name);
+
+        if (file.open(QIODevice::ReadOnly))
+        {
+            corpusBytes = file.readAll();
+        }
+    }
+
+    expectedText = QTextCodec::codecForName("UTF-8")->toUnicode(corpusBytes);
+    return corpusBytes;
+}
+
+
+/* Decodes the given bytes with the given decoder (see decode_data).
+ */
+QString BenchDecode::decodeWith(const QString &decoder, const QByteArray &bytes)
+{
+    QTextCodec *codec = QTextCodec::codecForName("UTF-8");
+
+    if (decoder == "QTextStream-readAll")
+    {
+        QTextStream stream(bytes);
+        stream.setCodec(codec);
+        return stream.readAll();
+    }
+
+    return decoder == "QTextCodec" ? codec->toUnicode(bytes) : decodeInChunks(bytes);
+}
+
+
+/* Decodes the given bytes with Utf8Decoder a FileLoader chunk at a time, as the open path does.
+ */
+QString BenchDecode::decodeInChunks(const QByteArray &bytes)
+{
+    Utf8Decoder decoder;
+    QString text;
+    text.reserve(bytes.size());
+
+    for (int start = 0; start < bytes.size(); start += FileLoader::CHUNK_SIZE)
+    {
+        text += decoder.toUnicode(QByteArray::fromRawData(bytes.constData() + start, qMin(static_cast<int>(FileLoader::CHUNK_SIZE), bytes.size() - start)));
+    }
+
+    return text + decoder.flush();
+}
+
+
+/* Returns made-up UTF-8 text of roughly the given number of bytes. Most lines are ASCII, as in
+ * source code and logs, so the ASCII paths get long runs, but every few lines has some two, three
+ * and four byte characters to fall back on the scalar decoding for.
+ */
+QByteArray BenchDecode::generateText(int size)
+{
+    const QStringList lines = {
+        "2019-04-01 12:34:56.789 INFO  [worker-3] Request handled in 12 ms (status 200, 5120 bytes)\n",
+        "    for (int i = 0; i < count; i++) { total += values[i] * weights[i]; }\n",
+        QString::fromUtf8("Caf\xC3\xA9 cr\xC3\xA8me br\xC3\xBBl\xC3\xA9" "e, na\xC3\xAFve fa\xC3\xA7" "ade\n"),
+        "The quick brown fox jumps over the lazy dog, then naps in the shade for a while.\n",
+        QString::fromUtf8("\xE6\x96\x87\xE5\xAD\x97\xE5\x8C\x96\xE3\x81\x91 test \xF0\x9F\x98\x80 done\n"),
+    };
+
+    QByteArray text;
+    text.reserve(size + 256);
+
+    for (int i = 0; text.size() < size; i++)
+    {
+        text += lines[i % lines.size()].toUtf8();
+    }
+
+    return text;
+}
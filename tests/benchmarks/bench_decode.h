@@ -0,0 +1,50 @@
+#ifndef BENCH_DECODE_H
+#define BENCH_DECODE_H
+#include "utf8decoder.h"
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+
+/* Compares decoding UTF-8 the way the open path does (Utf8Decoder, a FileLoader chunk at a time,
+ * with each of its ASCII paths this build and CPU support) with the way files used to be opened:
+ * QTextStream::readAll, and QTextCodec on its own. Each file in SCRIBE_BENCHMARK_FILES, and
+ * generated text of 10 MB, 100 MB and 1 GB (mostly ASCII, some accented and CJK text, the odd
+ * emoji), is decoded every way. Valid UTF-8 must decode to exactly the same text every way, and
+ * that text must encode back to the original bytes.
+ *
+ * 1 GB of text decodes to more than a QString can hold, so that size is streamed instead: the
+ * same STREAMED_BLOCK_SIZE of generated text is decoded over and over, every way (readAll
+ * included) a block at a time, until 1 GB has gone through.
+ */
+class BenchDecode : public QObject
+{
+    Q_OBJECT
+
+public:
+    const static int STREAMED_BLOCK_SIZE = 64 * 1024 * 1024;
+
+private slots:
+    void initTestCase();
+    void cleanup();
+    void decode_data();
+    void decode();
+    void roundTrips_data();
+    void roundTrips();
+
+private:
+    void addCorpusColumn();
+    const QByteArray &corpus(const QString &name, int &repeats);
+    static QString decodeWith(const QString &decoder, const QByteArray &bytes);
+    static QString decodeInChunks(const QByteArray &bytes);
+    static QByteArray generateText(int size);
+
+    Utf8Decoder::AsciiPath defaultPath;
+
+    // Only one corpus is kept around at a time; the rows are grouped by corpus
+    QString loadedCorpus;
+    QByteArray corpusBytes;
+    QString expectedText;
+};
+
+#endif // BENCH_DECODE_H
@@ -0,0 +1,210 @@
+#include "bench_find.h"
+#include "benchmarkreport.h"
+#include "textsearcher.h"
+#include "filesearch.h"
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFile>
+
+
+void BenchFind::findAll_data()
+{
+    addRows();
+}
+
+
+/* Times Find All over one corpus, not counting the time it takes to set up the document's snapshot.
+ */
+void BenchFind::findAll()
+{
+    QFETCH(QString, corpusName);
+
+    const QString &text = corpus(corpusName);
+    TextSearcher searcher(query, false, false);
+    QVector<int> matches;
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        matches = searcher.findAll(text);
+        iterations++;
+    }
+
+    QJsonObject result;
+    result["corpus"] = QFileInfo(corpusName).fileName();
+    result["query"] = query;
+    result["bytes"] = text.toUtf8().size();
+    result["matches"] = matches.size();
+    result["ms"] = timer.nsecsElapsed() / 1e6 / qMax(iterations, 1);
+    BenchmarkReport::record(result);
+}
+
+
+void BenchFind::documentFind_data()
+{
+    addRows();
+}
+
+
+/* Times stepping through every match with QTextDocument::find, not counting the time it takes
+ * to set up the document.
+ */
+void BenchFind::documentFind()
+{
+    QFETCH(QString, corpusName);
+
+    const QString &text = corpus(corpusName);
+    QTextDocument document;
+    document.setPlainText(text);
+    int numMatches = 0;
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        QTextCursor cursor(&document);
+        numMatches = 0;
+
+        while (!(cursor = document.find(query, cursor)).isNull())
+        {
+            numMatches++;
+        }
+
+        iterations++;
+    }
+
+    double milliseconds = timer.nsecsElapsed() / 1e6 / qMax(iterations, 1);
+
+    QJsonObject result;
+    result["corpus"] = QFileInfo(corpusName).fileName();
+    result["query"] = query;
+    result["bytes"] = text.toUtf8().size();
+    result["matches"] = numMatches;
+    result["ms"] = milliseconds;
+    BenchmarkReport::record(result);
+}
+
+
+/* Searches every file under SCRIBE_BENCHMARK_FIND_ROOT for the query, as Find in Files does.
+ */
+void BenchFind::findInFiles()
+{
+    QString root = BenchmarkReport::setting("SCRIBE_BENCHMARK_FIND_ROOT");
+
+    if (root.isEmpty())
+    {
+        QSKIP("SCRIBE_BENCHMARK_FIND_ROOT isn't set");
+    }
+
+    QVERIFY2(QFileInfo(root).isDir(), qPrintable("Cannot search in " + root));
+
+    QBENCHMARK
+    {
+        FileSearch search(root, query, true, false, false, QStringList(), {".git", ".svn", ".hg"});
+        QEventLoop loop;
+
+        // Only the counts are reported, so the hits are left to pile up until the end
+        connect(&search, SIGNAL(done()), &loop, SLOT(quit()));
+
+        search.start();
+        loop.exec();
+
+        double megabytes = search.getBytesSearched() / (1024.0 * 1024.0);
+        qint64 elapsed = qMax(search.getElapsedTime(), qint64(1));
+
+        QJsonObject result;
+        result["query"] = query;
+        result["root"] = root;
+        result["files"] = search.getNumFilesSearched();
+        result["skippedFiles"] = search.getNumSkippedFiles();
+        result["megabytes"] = megabytes;
+        result["matches"] = search.getNumMatches();
+        result["threads"] = search.getNumThreads();
+        result["ms"] = elapsed;
+        result["megabytesPerSecond"] = megabytes * 1000 / elapsed;
+        BenchmarkReport::record(result);
+    }
+}
+
+
+/* Adds a row for every generated corpus, then one for every file in SCRIBE_BENCHMARK_FILES.
+ */
+void BenchFind::addRows()
+{
+    QTest::addColumn<QString>("corpusName");
+
+    query = BenchmarkReport::setting("SCRIBE_BENCHMARK_QUERY", "needle");
+
+    for (int size : {1024 * 1024, 10 * 1024 * 1024, 100 * 1024 * 1024})
+    {
+        QString name = QString("generated-%1").arg(size);
+        QTest::newRow(qPrintable(name)) << name;
+    }
+
+    for (const QString &fileName : BenchmarkReport::corpusFiles())
+    {
+        QTest::newRow(qPrintable(QFileInfo(fileName).fileName())) << fileName;
+    }
+}
+
+
+/* Returns the text of the corpus with the given name: either generated text of a given size
+ * ("generated-<characters>") or a file.
+ */
+const QString &BenchFind::corpus(const QString &name)
+{
+    if (name == loadedCorpus)
+    {
+        return corpusText;
+    }
+
+    loadedCorpus = name;
+    corpusText.clear();
+
+    if (name.startsWith("generated-"))
+    {
+        corpusText = generateText(name.mid(QString("generated-").length()).toInt(), query);
+    }
+    else
+    {
+        QFile file(name);
+
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            corpusText = QString::fromUtf8(file.readAll());
+        }
+    }
+
+    return corpusText;
+}
+
+
+/* Returns made-up text of roughly the given number of characters, with the query in it now and then.
+ */
+QString BenchFind::generateText(int size, const QString &query)
+{
+    const QString line = "The quick brown fox jumps over the lazy dog, then naps in the shade for a while.\n";
+    QString text;
+    text.reserve(size + line.size() + query.size());
+
+    for (int i = 0; text.size() < size; i++)
+    {
+        text += line;
+
+        if (i % 10 == 0)
+        {
+            text += query + "\n";
+        }
+    }
+
+    return text;
+}
@@ -0,0 +1,39 @@
+#ifndef BENCH_FIND_H
+#define BENCH_FIND_H
+#include <QObject>
+#include <QString>
+
+
+/* Compares Find All (see TextSearcher) with finding every match through repeated calls to
+ * QTextDocument::find, the way Find Next and Replace All step through a document. Each file in
+ * SCRIBE_BENCHMARK_FILES, and generated text of 1, 10 and 100 MB, is searched both ways for
+ * SCRIBE_BENCHMARK_QUERY. Needs fonts for QTextDocument, so run with "-platform offscreen"
+ * where there's no display.
+ *
+ * findInFiles times a Find in Files (see FileSearch) of everything under SCRIBE_BENCHMARK_FIND_ROOT,
+ * for comparison with the likes of "rg -c query folder".
+ */
+class BenchFind : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findAll_data();
+    void findAll();
+    void documentFind_data();
+    void documentFind();
+    void findInFiles();
+
+private:
+    void addRows();
+    const QString &corpus(const QString &name);
+    static QString generateText(int size, const QString &query);
+
+    QString query;
+
+    // Only one corpus is kept around at a time; the rows are grouped by corpus
+    QString loadedCorpus;
+    QString corpusText;
+};
+
+#endif // BENCH_FIND_H
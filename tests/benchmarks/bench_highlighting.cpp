@@ -0,0 +1,240 @@
+#include "bench_highlighting.h"
+#include "benchmarkreport.h"
+#include "allocationcounter.h"
+#include "highlighters/highlighter.h"
+#include "highlighters/grammarregistry.h"
+#include <QTest>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+
+
+void BenchHighlighting::highlight_data()
+{
+    addRows();
+}
+
+
+void BenchHighlighting::highlight()
+{
+    QFETCH(QString, language);
+    QFETCH(QString, corpusName);
+
+    QSharedPointer<const Grammar> grammar = GrammarRegistry::instance().grammarFor(language);
+    const QVector<QString> &lines = corpus(corpusName);
+
+    if (lines.isEmpty())
+    {
+        QSKIP("The corpus is empty or can't be read");
+    }
+    QVector<Token> tokens;
+    int state = Lexer::Normal;
+
+    // Counted over a pass of its own, so that QBENCHMARK's bookkeeping isn't counted along with it
+    qint64 allocationsBefore = AllocationCounter::count();
+    qint64 numRanges = 0;
+
+    for (const QString &line : lines)
+    {
+        state = grammar->lexer.tokenize(line, state, tokens);
+        numRanges += Highlighter::highlightedLineFrom(tokens, state).ranges.size();
+    }
+
+    allocationsPerBlock = AllocationCounter::isAvailable() ? static_cast<double>(AllocationCounter::count() - allocationsBefore) / lines.size() : -1;
+    rangesPerBlock = static_cast<double>(numRanges) / lines.size();
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        state = Lexer::Normal;
+
+        for (const QString &line : lines)
+        {
+            state = grammar->lexer.tokenize(line, state, tokens);
+            numRanges += Highlighter::highlightedLineFrom(tokens, state).ranges.size();
+        }
+
+        iterations++;
+    }
+
+    recordResult(language, corpusName, timer.nsecsElapsed(), iterations);
+}
+
+
+void BenchHighlighting::state_data()
+{
+    addRows();
+}
+
+
+void BenchHighlighting::state()
+{
+    QFETCH(QString, language);
+    QFETCH(QString, corpusName);
+
+    QSharedPointer<const Grammar> grammar = GrammarRegistry::instance().grammarFor(language);
+    const QVector<QString> &lines = corpus(corpusName);
+
+    if (lines.isEmpty())
+    {
+        QSKIP("The corpus is empty or can't be read");
+    }
+    int state = Lexer::Normal;
+    allocationsPerBlock = -1;
+    rangesPerBlock = -1;
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        state = Lexer::Normal;
+
+        for (const QString &line : lines)
+        {
+            state = grammar->lexer.endState(line, state);
+        }
+
+        iterations++;
+    }
+
+    recordResult(language, corpusName, timer.nsecsElapsed(), iterations);
+}
+
+
+/* Adds a row for every language and generated corpus, then one for every file in SCRIBE_BENCHMARK_FILES
+ * in a known language. Rows are grouped by corpus, so that each corpus only has to be built once.
+ */
+void BenchHighlighting::addRows()
+{
+    QTest::addColumn<QString>("language");
+    QTest::addColumn<QString>("corpusName");
+
+    GrammarRegistry &registry = GrammarRegistry::instance();
+
+    for (qint64 size : {1024, 64 * 1024, 1024 * 1024, 100 * 1024 * 1024})
+    {
+        QString name = QString("generated-%1").arg(size);
+
+        for (const QString &language : registry.getLanguages())
+        {
+            QTest::newRow(qPrintable(language + " " + name)) << language << name;
+        }
+    }
+
+    for (const QString &fileName : BenchmarkReport::corpusFiles())
+    {
+        QString language = registry.languageOf(fileName);
+
+        if (!language.isEmpty())
+        {
+            QTest::newRow(qPrintable(language + " " + fileName)) << language << fileName;
+        }
+    }
+}
+
+
+/* Returns the lines of the corpus with the given name: either generated text of a given size
+ * ("generated-<bytes>") or a file.
+ */
+const QVector<QString> &BenchHighlighting::corpus(const QString &name)
+{
+    if (name == loadedCorpus)
+    {
+        return corpusLines;
+    }
+
+    loadedCorpus = name;
+    corpusLines.clear();
+
+    if (name.startsWith("generated-"))
+    {
+        corpusLines = generateCorpus(name.mid(QString("generated-").length()).toLongLong());
+    }
+    else
+    {
+        QFile file(name);
+
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            corpusLines = QString::fromUtf8(file.readAll()).split('\n').toVector();
+        }
+    }
+
+    corpusBytes = 0;
+    for (const QString &line : corpusLines)
+    {
+        corpusBytes += line.toUtf8().size() + 1;
+    }
+
+    return corpusLines;
+}
+
+
+/* Returns lines of made-up source code adding up to roughly the given number of bytes. The lines
+ * mix every kind of token and both comment styles, so every language has something to highlight.
+ */
+QVector<QString> BenchHighlighting::generateCorpus(qint64 size)
+{
+    const QStringList sample = {
+        "#include <vector>",
+        "",
+        "/* Returns the number of words on each line of the given file, which",
+        " * must be readable (see File.open). */",
+        "static int countWords(const String &fileName, int *counts) {",
+        "    File file = File.open(fileName, \"r\");",
+        "    int total = 0; // the words seen so far",
+        "    for (int i = 0; i < file.lineCount(); i++) {",
+        "        counts[i] = words(file.line(i), ' ');",
+        "        total += counts[i] > 0 ? counts[i] : 0;",
+        "    }",
+        "    # lines like this one are comments in Python, shell and YAML",
+        "    return total == 0 ? None : Result(total, \"words\", 'w');",
+        "}"
+    };
+
+    QVector<QString> lines;
+    qint64 bytes = 0;
+
+    while (bytes < size)
+    {
+        const QString &line = sample[lines.size() % sample.size()];
+        lines.append(line);
+        bytes += line.size() + 1;
+    }
+
+    return lines;
+}
+
+
+/* Records the throughput of the pass that just ran, given how long its QBENCHMARK loop took in all.
+ */
+void BenchHighlighting::recordResult(const QString &language, const QString &corpusName, qint64 nanoseconds, int iterations)
+{
+    double nanosecondsPerPass = static_cast<double>(nanoseconds) / qMax(iterations, 1);
+
+    QJsonObject result;
+    result["language"] = language;
+    result["corpus"] = QFileInfo(corpusName).fileName();
+    result["blocks"] = corpusLines.size();
+    result["bytes"] = corpusBytes;
+    result["iterations"] = iterations;
+    result["blocksPerSecond"] = corpusLines.size() / qMax(nanosecondsPerPass / 1e9, 1e-9);
+    result["nsPerByte"] = nanosecondsPerPass / qMax(corpusBytes, qint64(1));
+
+    if (allocationsPerBlock >= 0)
+    {
+        result["allocationsPerBlock"] = allocationsPerBlock;
+    }
+
+    if (rangesPerBlock >= 0)
+    {
+        result["rangesPerBlock"] = rangesPerBlock;
+    }
+
+    BenchmarkReport::record(result);
+}
@@ -0,0 +1,44 @@
+#ifndef BENCH_HIGHLIGHTING_H
+#define BENCH_HIGHLIGHTING_H
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+
+/* Measures how fast every language is highlighted, without showing a window. Each language
+ * highlights generated source code from 1 KB to 100 MB in size, and the language of each file
+ * in SCRIBE_BENCHMARK_FILES (judging by its extension) highlights that file.
+ *
+ * Two passes are timed over each corpus, carrying the state from line to line just like a
+ * Highlighter does: highlight lexes every line and packs its styled ranges (what happens to a line
+ * the token cache hasn't seen), and state only works out the state every line ends in (what lazy
+ * highlighting does for the lines it skips). Blocks per second, ns per byte and, for highlight,
+ * allocations and styled ranges per block go in the report (see BenchmarkReport).
+ */
+class BenchHighlighting : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void highlight_data();
+    void highlight();
+    void state_data();
+    void state();
+
+private:
+    void addRows();
+    const QVector<QString> &corpus(const QString &name);
+    void recordResult(const QString &language, const QString &corpusName, qint64 nanoseconds, int iterations);
+    static QVector<QString> generateCorpus(qint64 size);
+
+    // The largest corpus alone takes a few hundred MB, so only one is kept around at a time
+    QString loadedCorpus;
+    QVector<QString> corpusLines;
+    qint64 corpusBytes = 0;
+
+    // See highlight; only that pass counts them
+    double allocationsPerBlock = -1;
+    double rangesPerBlock = -1;
+};
+
+#endif // BENCH_HIGHLIGHTING_H
@@ -0,0 +1,74 @@
+#include "benchmarkreport.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QMap>
+#include <QFile>
+#include <QDir>
+#include <QTest>
+#include <QtDebug>
+
+
+// Results by "function/data tag", so a function run again to calibrate replaces its earlier result
+static QMap<QString, QJsonObject> results;
+
+
+/* Records the given result for the benchmark function and data row running now.
+ */
+void BenchmarkReport::record(QJsonObject result)
+{
+    QString function = QTest::currentTestFunction();
+    QString dataTag = QTest::currentDataTag();
+
+    result["benchmark"] = function;
+    result["row"] = dataTag;
+    results.insert(function + "/" + dataTag, result);
+}
+
+
+/* Writes every result recorded so far to the file named by SCRIBE_BENCHMARK_JSON, if it's set.
+ * Returns false if the file couldn't be written.
+ */
+bool BenchmarkReport::write()
+{
+    QString path = setting("SCRIBE_BENCHMARK_JSON");
+
+    if (path.isEmpty())
+    {
+        return true;
+    }
+
+    QJsonArray array;
+    for (const QJsonObject &result : results)
+    {
+        array.append(result);
+    }
+
+    QJsonObject report;
+    report["qtVersion"] = qVersion();
+    report["results"] = array;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(QJsonDocument(report).toJson()) == -1)
+    {
+        qWarning() << "Cannot write the benchmark report to" << path << ":" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+
+/* Returns the real-world files listed in SCRIBE_BENCHMARK_FILES, if any.
+ */
+QStringList BenchmarkReport::corpusFiles()
+{
+    return setting("SCRIBE_BENCHMARK_FILES").split(QDir::listSeparator(), QString::SkipEmptyParts);
+}
+
+
+/* Returns the value of the given environment variable, or the given default if it isn't set.
+ */
+QString BenchmarkReport::setting(const char *name, const QString &defaultValue)
+{
+    return qEnvironmentVariableIsSet(name) ? qEnvironmentVariable(name) : defaultValue;
+}
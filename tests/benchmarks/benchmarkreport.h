@@ -0,0 +1,24 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+#include <QJsonObject>
+#include <QStringList>
+
+
+/* Collects what the benchmarks measure beyond the time per iteration QtTest reports (throughput,
+ * allocations, match counts...) and writes it out as JSON, so that two builds can be diffed. One
+ * result is kept per benchmark function and data row; QBENCHMARK may run a function more than
+ * once to calibrate, and only the last run's result counts.
+ *
+ * Also reads the settings a run can be given through the environment (see benchmarks.pro).
+ */
+class BenchmarkReport
+{
+public:
+    static void record(QJsonObject result);
+    static bool write();
+
+    static QStringList corpusFiles();
+    static QString setting(const char *name, const QString &defaultValue = QString());
+};
+
+#endif // BENCHMARKREPORT_H
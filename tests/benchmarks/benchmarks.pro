@@ -0,0 +1,34 @@
+# Benchmarks (QBENCHMARK), built against the same sources as the app (see src/Scribe.pri).
+# Build and run with: qmake && make && ./bench_scribe -platform offscreen
+#
+# QtTest's own options pick the output format (e.g. "-o results.csv,csv"). Set these to configure a run:
+#   SCRIBE_BENCHMARK_JSON:       where to write the derived figures (blocks/sec, ns/byte, allocations per block...) as JSON
+#   SCRIBE_BENCHMARK_FILES:      real-world files to benchmark along with the generated corpora (separated like PATH)
+#   SCRIBE_BENCHMARK_QUERY:      what to find (needle by default)
+#   SCRIBE_BENCHMARK_FIND_ROOT:  a folder to time Find in Files in; skipped if unset
+
+QT       += core gui printsupport widgets testlib
+
+TARGET = bench_scribe
+TEMPLATE = app
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../src/Scribe.pri)
+
+SOURCES += \
+    main.cpp \
+    benchmarkreport.cpp \
+    allocationcounter.cpp \
+    bench_highlighting.cpp \
+    bench_decode.cpp \
+    bench_find.cpp
+
+HEADERS += \
+    benchmarkreport.h \
+    allocationcounter.h \
+    bench_highlighting.h \
+    bench_decode.h \
+    bench_find.h
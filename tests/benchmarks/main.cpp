@@ -0,0 +1,35 @@
+#include "bench_highlighting.h"
+#include "bench_decode.h"
+#include "bench_find.h"
+#include "benchmarkreport.h"
+#include <QApplication>
+#include <QTest>
+
+
+/* Runs every benchmark class in turn, then writes the JSON report (see BenchmarkReport).
+ * Returns the number of classes with failures.
+ */
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QApplication::setOrganizationName("Aleksandr Hovhannisyan");
+    QApplication::setApplicationName("Scribe Text Editor Benchmarks");
+
+    int failures = 0;
+
+    BenchHighlighting highlighting;
+    failures += QTest::qExec(&highlighting, argc, argv) != 0;
+
+    BenchDecode decode;
+    failures += QTest::qExec(&decode, argc, argv) != 0;
+
+    BenchFind find;
+    failures += QTest::qExec(&find, argc, argv) != 0;
+
+    if (!BenchmarkReport::write())
+    {
+        failures++;
+    }
+
+    return failures;
+}
@@ -0,0 +1,56 @@
+#include "tst_metricstracker.h"
+#include "tst_filesaver.h"
+#include "tst_byteoffsetindex.h"
+#include "tst_bracketmatcher.h"
+#include "tst_highlighter.h"
+#include "tst_keywordtable.h"
+#include "tst_regexsearcher.h"
+#include "tst_textsearcher.h"
+#include "tst_tabsearch.h"
+#include "tst_filesearch.h"
+#include <QApplication>
+#include <QTest>
+
+
+/* Runs every test class in turn. Returns the number of classes with failures.
+ */
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QApplication::setOrganizationName("Aleksandr Hovhannisyan");
+    QApplication::setApplicationName("Scribe Text Editor Tests");
+
+    int failures = 0;
+
+    TestMetricsTracker metricsTracker;
+    failures += QTest::qExec(&metricsTracker, argc, argv) != 0;
+
+    TestFileSaver fileSaver;
+    failures += QTest::qExec(&fileSaver, argc, argv) != 0;
+
+    TestByteOffsetIndex byteOffsetIndex;
+    failures += QTest::qExec(&byteOffsetIndex, argc, argv) != 0;
+
+    TestBracketMatcher bracketMatcher;
+    failures += QTest::qExec(&bracketMatcher, argc, argv) != 0;
+
+    TestHighlighter highlighter;
+    failures += QTest::qExec(&highlighter, argc, argv) != 0;
+
+    TestKeywordTable keywordTable;
+    failures += QTest::qExec(&keywordTable, argc, argv) != 0;
+
+    TestRegexSearcher regexSearcher;
+    failures += QTest::qExec(&regexSearcher, argc, argv) != 0;
+
+    TestTextSearcher textSearcher;
+    failures += QTest::qExec(&textSearcher, argc, argv) != 0;
+
+    TestTabSearch tabSearch;
+    failures += QTest::qExec(&tabSearch, argc, argv) != 0;
+
+    TestFileSearch fileSearch;
+    failures += QTest::qExec(&fileSearch, argc, argv) != 0;
+
+    return failures;
+}
@@ -0,0 +1,38 @@
+# Unit tests, built against the same sources as the app (see src/Scribe.pri).
+# Build and run with: qmake && make && make check
+
+QT       += core gui printsupport widgets testlib
+
+TARGET = tst_scribe
+TEMPLATE = app
+CONFIG += c++11 testcase console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../src/Scribe.pri)
+
+SOURCES += \
+    main.cpp \
+    tst_metricstracker.cpp \
+    tst_filesaver.cpp \
+    tst_byteoffsetindex.cpp \
+    tst_bracketmatcher.cpp \
+    tst_highlighter.cpp \
+    tst_keywordtable.cpp \
+    tst_regexsearcher.cpp \
+    tst_textsearcher.cpp \
+    tst_tabsearch.cpp \
+    tst_filesearch.cpp
+
+HEADERS += \
+    tst_metricstracker.h \
+    tst_filesaver.h \
+    tst_byteoffsetindex.h \
+    tst_bracketmatcher.h \
+    tst_highlighter.h \
+    tst_keywordtable.h \
+    tst_regexsearcher.h \
+    tst_textsearcher.h \
+    tst_tabsearch.h \
+    tst_filesearch.h
@@ -0,0 +1,75 @@
+#include "tst_bracketmatcher.h"
+#include "bracketmatcher.h"
+#include "blockdata.h"
+#include <QTest>
+#include <QTextBlock>
+
+
+/* Summarizes the brackets on the first numLines lines of the document, as the Highlighter would
+ * (every bracket counts, since there are no strings or comments here), and leaves the rest alone.
+ */
+void TestBracketMatcher::summarizeLines(QTextDocument *document, int numLines)
+{
+    QTextBlock block = document->begin();
+
+    for (int i = 0; i < numLines && block.isValid(); i++, block = block.next())
+    {
+        QVector<int> positions;
+        QString text = block.text();
+
+        for (int j = 0; j < text.length(); j++)
+        {
+            if (BracketMatcher::isBracket(text.at(j)))
+            {
+                positions.append(j);
+            }
+        }
+
+        BracketMatcher::summarize(block, text, positions);
+        BlockData::of(block)->highlightedState = 0;
+    }
+}
+
+
+void TestBracketMatcher::isUnclosed_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("numSummarized");
+    QTest::addColumn<bool>("unclosed");
+
+    QTest::newRow("closed, summarized") << "f() {\n  g();\n}\n" << 4 << false;
+    QTest::newRow("unclosed, summarized") << "f() {\n  g();\n" << 3 << true;
+    QTest::newRow("closed below the summarized lines") << "f() {\n  g();\n}\n" << 1 << false;
+    QTest::newRow("unclosed below the summarized lines") << "f() {\n  g(\n  );\n" << 1 << true;
+    QTest::newRow("nested below the summarized lines") << "f() {\n  if (x) {\n  }\n" << 1 << true;
+}
+
+
+/* A code block start that's closed on a line the Highlighter hasn't summarized yet (as below the
+ * watermark in lazy mode) must not count as unclosed, or Enter would insert a second end delimiter.
+ */
+void TestBracketMatcher::isUnclosed()
+{
+    QFETCH(QString, text);
+    QFETCH(int, numSummarized);
+    QFETCH(bool, unclosed);
+
+    QTextDocument document(text);
+    summarizeLines(&document, numSummarized);
+
+    QCOMPARE(BracketMatcher::isUnclosed(document.begin(), 4), unclosed);
+}
+
+
+/* Plain matching, for the match highlight, only goes by summaries.
+ */
+void TestBracketMatcher::findMatchSkipsUnsummarized()
+{
+    QTextDocument document("{\n(\n)\n}");
+    summarizeLines(&document, 4);
+    QCOMPARE(BracketMatcher::findMatch(document.begin(), 0), document.findBlockByNumber(3).position());
+
+    BlockData::of(document.findBlockByNumber(3))->highlightedState = BlockData::UNCOUNTED;
+    QCOMPARE(BracketMatcher::findMatch(document.begin(), 0), static_cast<int>(BracketMatcher::NOT_FOUND));
+    QVERIFY(!BracketMatcher::isUnclosed(document.begin(), 0));
+}
@@ -0,0 +1,22 @@
+#ifndef TST_BRACKETMATCHER_H
+#define TST_BRACKETMATCHER_H
+#include <QObject>
+#include <QTextDocument>
+
+
+/* Checks bracket matching over summarized lines and lines the Highlighter hasn't reached.
+ */
+class TestBracketMatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void isUnclosed_data();
+    void isUnclosed();
+    void findMatchSkipsUnsummarized();
+
+private:
+    static void summarizeLines(QTextDocument *document, int numLines);
+};
+
+#endif // TST_BRACKETMATCHER_H
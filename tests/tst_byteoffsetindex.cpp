@@ -0,0 +1,109 @@
+#include "tst_byteoffsetindex.h"
+#include "byteoffsetindex.h"
+#include "textencoding.h"
+#include "fileloader.h"
+#include <QTest>
+#include <QTextDocument>
+#include <QTemporaryDir>
+#include <QFile>
+
+
+void TestByteOffsetIndex::positionOf_data()
+{
+    QTest::addColumn<QByteArray>("codecName");
+    QTest::addColumn<QString>("lineEnding");
+
+    QTest::newRow("UTF-8, \\n") << QByteArray("UTF-8") << "\n";
+    QTest::newRow("UTF-8, \\r\\n") << QByteArray("UTF-8") << "\r\n";
+    QTest::newRow("UTF-16LE, \\r\\n") << QByteArray("UTF-16LE") << "\r\n";
+    QTest::newRow("ISO-8859-1, \\r") << QByteArray("ISO-8859-1") << "\r";
+}
+
+
+/* Encodes every line of a document the way it would be saved and checks that the byte offset
+ * of each of its characters maps back to that character, across more than one checkpoint.
+ */
+void TestByteOffsetIndex::positionOf()
+{
+    QFETCH(QByteArray, codecName);
+    QFETCH(QString, lineEnding);
+
+    QStringList lines;
+    for (int i = 0; i < 3 * ByteOffsetIndex::STRIDE; i++)
+    {
+        lines.append(QString("line %1 caf").arg(i) + QChar(0xE9));
+    }
+
+    QTextDocument document(lines.join('\n'));
+    TextEncoding encoding;
+    encoding.codecName = codecName;
+    encoding.lineEnding = lineEnding;
+    ByteOffsetIndex *index = new ByteOffsetIndex(&document, encoding);
+
+    QTextCodec *codec = encoding.codec();
+    qint64 offset = 0;
+    int position = 0;
+
+    for (const QString &line : lines)
+    {
+        for (int i = 0; i < line.length(); i++)
+        {
+            QCOMPARE(index->positionOf(offset), position + i);
+            offset += codec->fromUnicode(line.mid(i, 1)).size();
+        }
+
+        offset += codec->fromUnicode(lineEnding).size();
+        position += line.length() + 1;
+    }
+
+    QCOMPARE(index->positionOf(offset + 1), -1);
+}
+
+
+/* Loads a \r\n file with multi-byte characters and checks that the checkpoints the loader recorded
+ * are the offsets at which their lines start, and that lookups find the same lines with them.
+ */
+void TestByteOffsetIndex::loadedCheckpoints()
+{
+    QStringList lines;
+    for (int i = 0; i < 3 * ByteOffsetIndex::STRIDE + 5; i++)
+    {
+        lines.append(QString("line %1 caf").arg(i) + QChar(0xE9));
+    }
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString filePath = directory.filePath("loaded.txt");
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(lines.join("\r\n").toUtf8());
+    file.close();
+
+    FileLoader loader(filePath);
+    loader.start();
+    loader.wait();
+
+    QVector<qint64> checkpoints = loader.blockCheckpoints();
+    QCOMPARE(checkpoints.size(), 4);
+
+    qint64 offset = 0;
+    for (int line = 0; line < lines.size(); line++)
+    {
+        if (line % ByteOffsetIndex::STRIDE == 0)
+        {
+            QCOMPARE(checkpoints[line / ByteOffsetIndex::STRIDE], offset);
+        }
+
+        offset += lines[line].toUtf8().size() + 2;
+    }
+
+    QTextDocument document(lines.join('\n'));
+    ByteOffsetIndex *index = new ByteOffsetIndex(&document, loader.detectedEncoding());
+    index->adoptCheckpoints(checkpoints);
+
+    for (int i = 0; i < checkpoints.size(); i++)
+    {
+        QCOMPARE(index->positionOf(checkpoints[i]), document.findBlockByNumber(i * ByteOffsetIndex::STRIDE).position());
+    }
+}
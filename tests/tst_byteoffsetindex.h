@@ -0,0 +1,18 @@
+#ifndef TST_BYTEOFFSETINDEX_H
+#define TST_BYTEOFFSETINDEX_H
+#include <QObject>
+
+
+/* Checks that byte offsets into a file map to the right document positions.
+ */
+class TestByteOffsetIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void positionOf_data();
+    void positionOf();
+    void loadedCheckpoints();
+};
+
+#endif // TST_BYTEOFFSETINDEX_H
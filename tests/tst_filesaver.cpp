@@ -0,0 +1,72 @@
+#include "tst_filesaver.h"
+#include "filesaver.h"
+#include "textencoding.h"
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QScopedPointer>
+
+
+void TestFileSaver::detectLineEnding_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("lineEnding");
+
+    QTest::newRow("none") << "no breaks" << QString();
+    QTest::newRow("unix") << "one\ntwo\r\n" << "\n";
+    QTest::newRow("windows") << "one\r\ntwo\n" << "\r\n";
+    QTest::newRow("classic mac") << "one\rtwo" << "\r";
+    QTest::newRow("trailing carriage return") << "one\r" << QString();
+}
+
+
+void TestFileSaver::detectLineEnding()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, lineEnding);
+
+    QCOMPARE(TextEncoding::detectLineEnding(text), lineEnding);
+}
+
+
+void TestFileSaver::savesLineEnding_data()
+{
+    QTest::addColumn<QByteArray>("codecName");
+    QTest::addColumn<QString>("lineEnding");
+
+    QTest::newRow("UTF-8, \\n") << QByteArray("UTF-8") << "\n";
+    QTest::newRow("UTF-8, \\r\\n") << QByteArray("UTF-8") << "\r\n";
+    QTest::newRow("UTF-16LE, \\n") << QByteArray("UTF-16LE") << "\n";
+    QTest::newRow("UTF-16LE, \\r\\n") << QByteArray("UTF-16LE") << "\r\n";
+    QTest::newRow("UTF-16BE, \\r\\n") << QByteArray("UTF-16BE") << "\r\n";
+}
+
+
+/* Saves lines with characters that have a 0x0A byte in UTF-16 (which Text mode used to corrupt)
+ * and checks that the file holds exactly the encoded lines and line endings, nothing more.
+ */
+void TestFileSaver::savesLineEnding()
+{
+    QFETCH(QByteArray, codecName);
+    QFETCH(QString, lineEnding);
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString filePath = directory.filePath("saved.txt");
+
+    TextEncoding encoding;
+    encoding.codecName = codecName;
+    encoding.lineEnding = lineEnding;
+
+    QStringList lines = {QString("plain"), QString(QChar(0x010A)) + QChar(0x0A05), QString(), "last"};
+    FileSaver saver(lines, filePath, encoding);
+    saver.start();
+    saver.wait();
+    QVERIFY2(saver.succeeded(), qPrintable(saver.errorString()));
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    QScopedPointer<QTextEncoder> encoder(encoding.codec()->makeEncoder(QTextCodec::IgnoreHeader));
+    QCOMPARE(file.readAll(), encoder->fromUnicode(lines.join(lineEnding)));
+}
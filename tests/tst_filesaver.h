@@ -0,0 +1,19 @@
+#ifndef TST_FILESAVER_H
+#define TST_FILESAVER_H
+#include <QObject>
+
+
+/* Checks that files are written back in the encoding and line ending they were read in.
+ */
+class TestFileSaver : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void detectLineEnding_data();
+    void detectLineEnding();
+    void savesLineEnding_data();
+    void savesLineEnding();
+};
+
+#endif // TST_FILESAVER_H
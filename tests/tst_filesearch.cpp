@@ -0,0 +1,173 @@
+#include "tst_filesearch.h"
+#include "filesearch.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QTextCodec>
+
+
+void TestFileSearch::globMatches_data()
+{
+    QTest::addColumn<QString>("glob");
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("matches");
+
+    QTest::newRow("extension") << "*.cpp" << "main.cpp" << true;
+    QTest::newRow("other extension") << "*.cpp" << "main.h" << false;
+    QTest::newRow("question mark") << "file?.txt" << "file1.txt" << true;
+    QTest::newRow("question mark needs a character") << "file?.txt" << "file.txt" << false;
+    QTest::newRow("exact") << ".git" << ".git" << true;
+    QTest::newRow("star matches nothing") << "a*b" << "ab" << true;
+    QTest::newRow("case doesn't matter") << "*.TXT" << "notes.txt" << true;
+}
+
+
+void TestFileSearch::globMatches()
+{
+    QFETCH(QString, glob);
+    QFETCH(QString, name);
+    QFETCH(bool, matches);
+
+    QCOMPARE(FileSearch::globMatches(glob, name), matches);
+}
+
+
+void TestFileSearch::listsHitsWithContext_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<bool>("caseSensitive");
+    QTest::addColumn<bool>("regex");
+    QTest::addColumn<QByteArray>("codecName");
+
+    // A plain, case-sensitive query in UTF-8 is searched for in the raw bytes; the rest in decoded text
+    QTest::newRow("raw bytes") << "needle" << true << false << QByteArray("UTF-8");
+    QTest::newRow("decoded, case-insensitive") << "NEEDLE" << false << false << QByteArray("UTF-8");
+    QTest::newRow("decoded, regular expression") << "ne+dle" << true << true << QByteArray("UTF-8");
+    QTest::newRow("decoded, UTF-16") << "needle" << true << false << QByteArray("UTF-16");
+}
+
+
+/* Matches on lines 5, 6 and 10 (twice) of a file of 12 lines are listed with CONTEXT_LINES lines
+ * around them, without repeating the lines the contexts share. Files that are excluded aren't searched.
+ */
+void TestFileSearch::listsHitsWithContext()
+{
+    QFETCH(QString, query);
+    QFETCH(bool, caseSensitive);
+    QFETCH(bool, regex);
+    QFETCH(QByteArray, codecName);
+
+    QStringList lines;
+    for (int i = 1; i <= 12; i++)
+    {
+        lines.append(QString("line %1").arg(i));
+    }
+
+    lines[4] = "line 5 needle";
+    lines[5] = "needle at the start";
+    lines[9] = "line 10 needle needle";
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    QFile file(directory.filePath("hits.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QTextCodec::codecForName(codecName)->fromUnicode(lines.join('\n')));
+    file.close();
+
+    QFile excluded(directory.filePath("excluded.log"));
+    QVERIFY(excluded.open(QIODevice::WriteOnly));
+    excluded.write("needle\n");
+    excluded.close();
+
+    FileSearch search(directory.path(), query, caseSensitive, false, regex, QStringList(), {"*.log"});
+    QSignalSpy done(&search, SIGNAL(done()));
+    search.start();
+    QTRY_COMPARE(done.count(), 1);
+
+    QVector<FileHits> hits = search.takeHits();
+    QCOMPARE(hits.size(), 1);
+    QVERIFY(hits[0].path.endsWith("hits.txt"));
+    QCOMPARE(hits[0].numMatches, 4);
+
+    const QVector<int> numbers = {3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    const QVector<int> columns = {0, 0, 8, 1, 0, 0, 0, 9, 0, 0};
+    QCOMPARE(hits[0].lines.size(), numbers.size());
+
+    for (int i = 0; i < numbers.size(); i++)
+    {
+        QCOMPARE(hits[0].lines[i].number, numbers[i]);
+        QCOMPARE(hits[0].lines[i].column, columns[i]);
+        QCOMPARE(hits[0].lines[i].text, lines[numbers[i] - 1]);
+    }
+}
+
+
+void TestFileSearch::searchesAcrossChunks_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<bool>("caseSensitive");
+    QTest::addColumn<bool>("regex");
+
+    QTest::newRow("raw bytes") << "needle" << true << false;
+    QTest::newRow("decoded, case-insensitive") << "NEEDLE" << false << false;
+    QTest::newRow("decoded, regular expression") << "ne+dle" << true << true;
+}
+
+
+/* Lines of 64 bytes put the end of the first CHUNK_SIZE bytes right after line 262144. Matches on
+ * either side of it have the same numbers, columns and context as anywhere else, and so does one
+ * in the last chunk.
+ */
+void TestFileSearch::searchesAcrossChunks()
+{
+    QFETCH(QString, query);
+    QFETCH(bool, caseSensitive);
+    QFETCH(bool, regex);
+
+    const int linesPerChunk = FileSearch::CHUNK_SIZE / 64;
+    const int numLines = 2 * linesPerChunk + linesPerChunk / 2;
+    const QVector<int> matchedLines = {linesPerChunk - 1, linesPerChunk + 1, numLines - 1};
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    QFile file(directory.filePath("large.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    for (int i = 1; i <= numLines; i++)
+    {
+        QString line = QString("line %1").arg(i) + (matchedLines.contains(i) ? " needle" : "");
+        file.write(line.leftJustified(63, '.').toUtf8() + (i < numLines ? "\n" : ""));
+    }
+
+    file.close();
+
+    FileSearch search(directory.path(), query, caseSensitive, false, regex, QStringList(), QStringList());
+    QSignalSpy done(&search, SIGNAL(done()));
+    search.start();
+    QTRY_COMPARE_WITH_TIMEOUT(done.count(), 1, 30000);
+
+    QVector<FileHits> hits = search.takeHits();
+    QCOMPARE(hits.size(), 1);
+    QCOMPARE(hits[0].numMatches, matchedLines.size());
+
+    QVector<int> numbers;
+    for (int i = linesPerChunk - 3; i <= linesPerChunk + 3; i++)
+    {
+        numbers.append(i);
+    }
+    numbers << numLines - 3 << numLines - 2 << numLines - 1 << numLines;
+    QCOMPARE(hits[0].lines.size(), numbers.size());
+
+    for (int i = 0; i < numbers.size(); i++)
+    {
+        int number = numbers[i];
+        bool matched = matchedLines.contains(number);
+
+        QCOMPARE(hits[0].lines[i].number, number);
+        QCOMPARE(hits[0].lines[i].column, matched ? QString("line %1 ").arg(number).length() + 1 : 0);
+        QVERIFY(hits[0].lines[i].text.startsWith(QString("line %1").arg(number) + (matched ? " needle." : ".")));
+    }
+}
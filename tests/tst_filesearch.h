@@ -0,0 +1,21 @@
+#ifndef TST_FILESEARCH_H
+#define TST_FILESEARCH_H
+#include <QObject>
+
+
+/* Checks the hits Find in Files lists for a file, context lines and all, on each of its search paths.
+ */
+class TestFileSearch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void globMatches_data();
+    void globMatches();
+    void listsHitsWithContext_data();
+    void listsHitsWithContext();
+    void searchesAcrossChunks_data();
+    void searchesAcrossChunks();
+};
+
+#endif // TST_FILESEARCH_H
@@ -0,0 +1,54 @@
+#include "tst_highlighter.h"
+#include "highlighters/highlighter.h"
+#include "highlighters/grammarregistry.h"
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+
+
+void TestHighlighter::relexesAffectedLinesOnly_data()
+{
+    QTest::addColumn<QString>("opening");
+    QTest::addColumn<QString>("closing");
+
+    QTest::newRow("block comment") << "/* " << "*/ int closed = 0;";
+    QTest::newRow("raw string") << "auto s = R\"x(" << ")x\"; int closed = 0;";
+}
+
+
+/* Opens a multi-line construct on line FIRST of a highlighted document whose line LAST already
+ * has what closes it. The edited line is re-lexed right away, then the lines after it while the
+ * GUI is idle, up to and including the closing line (which ends in the same state as before) and
+ * not one line further.
+ */
+void TestHighlighter::relexesAffectedLinesOnly()
+{
+    QFETCH(QString, opening);
+    QFETCH(QString, closing);
+
+    const int FIRST = 5;
+    const int LAST = 20;
+
+    QStringList lines;
+    for (int i = 0; i < 40; i++)
+    {
+        lines.append(i == LAST ? closing : QString("int value%1 = compute(%1); // line %1").arg(i));
+    }
+
+    QTextDocument document(lines.join('\n'));
+    Highlighter *highlighter = new Highlighter(GrammarRegistry::instance().grammarFor("C++"), &document);
+    highlighter->setVisibleBlocks(0, 39);
+    QTRY_VERIFY(document.lastBlock().userState() != Highlighter::NOT_HIGHLIGHTED);
+
+    int relexedBefore = highlighter->getNumRelexedBlocks();
+    QTextCursor cursor(document.findBlockByNumber(FIRST));
+    cursor.insertText(opening);
+
+    QCOMPARE(highlighter->getNumRelexedBlocks() - relexedBefore, 1);
+    QTRY_COMPARE(highlighter->getNumRelexedBlocks() - relexedBefore, LAST - FIRST + 1);
+
+    // Nothing past the closing line may be touched, even once the GUI has been idle for a while
+    QTest::qWait(2 * Highlighter::RESTART_DELAY);
+    QCOMPARE(highlighter->getNumRelexedBlocks() - relexedBefore, LAST - FIRST + 1);
+    QCOMPARE(document.findBlockByNumber(LAST + 1).userState(), document.findBlockByNumber(0).userState());
+}
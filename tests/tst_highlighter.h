@@ -0,0 +1,17 @@
+#ifndef TST_HIGHLIGHTER_H
+#define TST_HIGHLIGHTER_H
+#include <QObject>
+
+
+/* Checks that an edit that changes the state lines start in re-lexes exactly the lines it affects.
+ */
+class TestHighlighter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void relexesAffectedLinesOnly_data();
+    void relexesAffectedLinesOnly();
+};
+
+#endif // TST_HIGHLIGHTER_H
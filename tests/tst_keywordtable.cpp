@@ -0,0 +1,81 @@
+#include "tst_keywordtable.h"
+#include "highlighters/keywordtable.h"
+#include <QTest>
+
+
+/* Returns true if the given table contains the given word.
+ */
+bool TestKeywordTable::lookUp(const KeywordTable &table, const QString &word)
+{
+    return table.contains(word.constData(), word.length());
+}
+
+
+void TestKeywordTable::contains()
+{
+    KeywordTable table({"select", "from", "where"});
+
+    QVERIFY(lookUp(table, "select"));
+    QVERIFY(lookUp(table, "where"));
+    QVERIFY(!lookUp(table, "SELECT"));
+    QVERIFY(!lookUp(table, "selects"));
+    QVERIFY(!lookUp(table, "x"));
+}
+
+
+void TestKeywordTable::containsIgnoringCase()
+{
+    KeywordTable table({"SELECT", "FROM", "WHERE"}, true);
+
+    QVERIFY(lookUp(table, "select"));
+    QVERIFY(lookUp(table, "SELECT"));
+    QVERIFY(lookUp(table, "SeLeCt"));
+    QVERIFY(lookUp(table, "where"));
+    QVERIFY(!lookUp(table, "selects"));
+    QCOMPARE(table.getKeywords().size(), 3);
+}
+
+
+void TestKeywordTable::roundTrips()
+{
+    KeywordTable written({"SELECT", "FROM", "WHERE"}, true);
+
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << written;
+
+    KeywordTable read;
+    QDataStream in(bytes);
+    in >> read;
+
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QVERIFY(read.isCaseInsensitive());
+    QVERIFY(lookUp(read, "From"));
+}
+
+
+/* Writes a table whose slots point past its keywords and checks that reading it fails instead.
+ */
+void TestKeywordTable::rejectsCorruptTable()
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << QStringList({"select"}) << false << QVector<qint16>({5, -1}) << uint(0) << uint(1) << 6 << 6;
+
+    KeywordTable read;
+    QDataStream in(bytes);
+    in >> read;
+
+    QCOMPARE(in.status(), QDataStream::ReadCorruptData);
+    QVERIFY(read.getKeywords().isEmpty());
+    QVERIFY(!lookUp(read, "select"));
+
+    // The table must also be exactly as big as the mask says, or a lookup could land past its end
+    QByteArray shortTable;
+    QDataStream shortOut(&shortTable, QIODevice::WriteOnly);
+    shortOut << QStringList({"select"}) << false << QVector<qint16>({0}) << uint(0) << uint(7) << 6 << 6;
+
+    QDataStream shortIn(shortTable);
+    shortIn >> read;
+    QCOMPARE(shortIn.status(), QDataStream::ReadCorruptData);
+}
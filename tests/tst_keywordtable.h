@@ -0,0 +1,24 @@
+#ifndef TST_KEYWORDTABLE_H
+#define TST_KEYWORDTABLE_H
+#include "highlighters/keywordtable.h"
+#include <QObject>
+#include <QString>
+
+
+/* Checks keyword lookups, with and without case, and that a corrupt table is never read back.
+ */
+class TestKeywordTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void contains();
+    void containsIgnoringCase();
+    void roundTrips();
+    void rejectsCorruptTable();
+
+private:
+    static bool lookUp(const KeywordTable &table, const QString &word);
+};
+
+#endif // TST_KEYWORDTABLE_H
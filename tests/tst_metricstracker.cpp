@@ -0,0 +1,213 @@
+#include "tst_metricstracker.h"
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocumentFragment>
+#include <random>
+
+
+/* Counts the document's words from scratch, one line of its plain text at a time.
+ */
+int TestMetricsTracker::fullWordCount(QTextDocument *document)
+{
+    int words = 0;
+
+    for (const QString &line : document->toPlainText().split('\n'))
+    {
+        words += MetricsTracker::countWordsIn(line);
+    }
+
+    return words;
+}
+
+
+/* Fails the current test unless the tracker's totals equal a full recount.
+ */
+void TestMetricsTracker::verifyTotals(QTextDocument *document, const MetricsTracker *tracker)
+{
+    QCOMPARE(tracker->wordCount(), fullWordCount(document));
+    QCOMPARE(tracker->charCount(), document->toPlainText().length());
+}
+
+
+void TestMetricsTracker::countWordsIn_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("words");
+
+    QTest::newRow("empty") << "" << 0;
+    QTest::newRow("spaces") << "   \t " << 0;
+    QTest::newRow("one") << "word" << 1;
+    QTest::newRow("padded") << "  two words  " << 2;
+    QTest::newRow("punctuation only") << "-- ... ;" << 0;
+    QTest::newRow("punctuation inside") << "don't stop-now" << 2;
+    QTest::newRow("digits") << "route 66" << 2;
+    QTest::newRow("no-break space") << QString("one") + QChar(QChar::Nbsp) + "two" << 2;
+}
+
+
+void TestMetricsTracker::countWordsIn()
+{
+    QFETCH(QString, text);
+    QFETCH(int, words);
+
+    QCOMPARE(MetricsTracker::countWordsIn(text), words);
+}
+
+
+void TestMetricsTracker::insertsAndDeletes()
+{
+    QTextDocument document("alpha beta\ngamma");
+    MetricsTracker *tracker = new MetricsTracker(&document);
+    QTextCursor cursor(&document);
+    verifyTotals(&document, tracker);
+
+    cursor.setPosition(5);
+    cursor.insertText(" inserted");
+    verifyTotals(&document, tracker);
+
+    // Deleting the space joins two words into one
+    cursor.setPosition(5);
+    cursor.deleteChar();
+    verifyTotals(&document, tracker);
+
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(" delta");
+    verifyTotals(&document, tracker);
+
+    cursor.setPosition(0);
+    cursor.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    verifyTotals(&document, tracker);
+}
+
+
+void TestMetricsTracker::splitsAndMerges()
+{
+    QTextDocument document("one two three\nfour five\nsix");
+    MetricsTracker *tracker = new MetricsTracker(&document);
+    QTextCursor cursor(&document);
+
+    // Splitting a word in two across lines
+    cursor.setPosition(5);
+    cursor.insertBlock();
+    verifyTotals(&document, tracker);
+
+    cursor.insertText("a\nb\n\nc");
+    verifyTotals(&document, tracker);
+
+    // Merging lines back together, including removing whole lines at once
+    cursor.setPosition(2);
+    cursor.setPosition(document.characterCount() - 3, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    verifyTotals(&document, tracker);
+
+    cursor.movePosition(QTextCursor::End);
+    cursor.deletePreviousChar();
+    verifyTotals(&document, tracker);
+}
+
+
+void TestMetricsTracker::undoAndRedo()
+{
+    QTextDocument document("first line\nsecond line");
+    MetricsTracker *tracker = new MetricsTracker(&document);
+    QTextCursor cursor(&document);
+
+    cursor.setPosition(6);
+    cursor.insertText("new\nlines\nhere ");
+    cursor.setPosition(0);
+    cursor.setPosition(8, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    verifyTotals(&document, tracker);
+
+    while (document.isUndoAvailable())
+    {
+        document.undo();
+        verifyTotals(&document, tracker);
+    }
+
+    QCOMPARE(document.toPlainText(), QString("first line\nsecond line"));
+
+    while (document.isRedoAvailable())
+    {
+        document.redo();
+        verifyTotals(&document, tracker);
+    }
+}
+
+
+void TestMetricsTracker::paste()
+{
+    QTextDocument document("paste here: ");
+    MetricsTracker *tracker = new MetricsTracker(&document);
+    QTextCursor cursor(&document);
+
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertFragment(QTextDocumentFragment::fromPlainText("several\nlines of\n\npasted text"));
+    verifyTotals(&document, tracker);
+
+    // Pasting over a selection that spans lines
+    cursor.setPosition(3);
+    cursor.setPosition(20, QTextCursor::KeepAnchor);
+    cursor.insertFragment(QTextDocumentFragment::fromPlainText("x y\nz"));
+    verifyTotals(&document, tracker);
+
+    document.undo();
+    verifyTotals(&document, tracker);
+}
+
+
+/* Applies a long, repeatable run of random edits of every kind, checking the totals after each.
+ */
+void TestMetricsTracker::randomEdits()
+{
+    const QStringList pieces = {"a", "word", " ", "  ", "\n", "two words", "x\ny", "\n\n", "-", "42", "end.\n"};
+
+    QTextDocument document;
+    MetricsTracker *tracker = new MetricsTracker(&document);
+    QTextCursor cursor(&document);
+    std::mt19937 random(2019);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        int length = document.characterCount() - 1;
+        int position = static_cast<int>(random() % static_cast<unsigned>(length + 1));
+
+        switch (random() % 5)
+        {
+            case 0:
+            case 1:
+                cursor.setPosition(position);
+                cursor.insertText(pieces[static_cast<int>(random() % static_cast<unsigned>(pieces.size()))]);
+                break;
+
+            case 2:
+            {
+                int end = qMin(length, position + static_cast<int>(random() % 12));
+                cursor.setPosition(position);
+                cursor.setPosition(end, QTextCursor::KeepAnchor);
+                cursor.removeSelectedText();
+                break;
+            }
+
+            case 3:
+                cursor.setPosition(position);
+                cursor.insertFragment(QTextDocumentFragment::fromPlainText("pasted\nfragment of text\n"));
+                break;
+
+            case 4:
+                if (document.isUndoAvailable())
+                {
+                    document.undo();
+                }
+                break;
+        }
+
+        verifyTotals(&document, tracker);
+
+        if (QTest::currentTestFailed())
+        {
+            QFAIL(qPrintable(QString("Totals diverged after edit %1").arg(i)));
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef TST_METRICSTRACKER_H
+#define TST_METRICSTRACKER_H
+#include "metricstracker.h"
+#include <QObject>
+#include <QTextDocument>
+
+
+/* Checks that MetricsTracker's running totals always equal a full recount of the document,
+ * whatever edits it goes through.
+ */
+class TestMetricsTracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void countWordsIn_data();
+    void countWordsIn();
+    void insertsAndDeletes();
+    void splitsAndMerges();
+    void undoAndRedo();
+    void paste();
+    void randomEdits();
+
+private:
+    static int fullWordCount(QTextDocument *document);
+    static void verifyTotals(QTextDocument *document, const MetricsTracker *tracker);
+};
+
+#endif // TST_METRICSTRACKER_H
@@ -0,0 +1,177 @@
+#include "tst_regexsearcher.h"
+#include "regexsearcher.h"
+#include <QTest>
+#include <QElapsedTimer>
+#include <random>
+
+
+void TestRegexSearcher::replacementFor_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QString>("replacement");
+    QTest::addColumn<QString>("expanded");
+
+    QTest::newRow("literal") << "key=(\\w+)" << "x" << "x";
+    QTest::newRow("whole match") << "key=(\\w+)" << "[\\0]" << "[key=value]";
+    QTest::newRow("numbered group") << "(\\w+)=(\\w+)" << "\\2=\\1" << "value=key";
+    QTest::newRow("named group") << "(?<name>\\w+)=(?<val>\\w+)" << "\\g<val>:\\g<name>" << "value:key";
+    QTest::newRow("group by number in brackets") << "(\\w+)=(\\w+)" << "\\g<2>" << "value";
+    QTest::newRow("two digit group") << "(\\w+)=(\\w+)" << "\\10" << "";
+    QTest::newRow("escapes") << "(\\w+)=" << "\\1\\t\\\\\\n" << "key\t\\\n";
+    QTest::newRow("unknown escape kept") << "(\\w+)=" << "\\q\\1" << "\\qkey";
+    QTest::newRow("trailing backslash kept") << "(\\w+)=" << "\\1\\" << "key\\";
+    QTest::newRow("unterminated name kept") << "(\\w+)=" << "\\g<1" << "\\g<1";
+}
+
+
+void TestRegexSearcher::replacementFor()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QString, replacement);
+    QFETCH(QString, expanded);
+
+    RegexSearcher searcher(pattern, true, false);
+    QVERIFY(searcher.isValid());
+    searcher.setReplacement(replacement);
+
+    QRegularExpressionMatch match = searcher.getExpression().match("key=value");
+    QVERIFY(match.hasMatch());
+    QCOMPARE(searcher.replacementFor(match), expanded);
+}
+
+
+void TestRegexSearcher::findInLine_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("caseSensitive");
+    QTest::addColumn<bool>("wholeWords");
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<QVector<int>>("starts");
+    QTest::addColumn<QVector<int>>("lengths");
+
+    QTest::newRow("several") << "a+" << true << false << "a aa baaa" << QVector<int>({100, 102, 106}) << QVector<int>({1, 2, 3});
+    QTest::newRow("case insensitive") << "ab" << false << false << "AB ab aB" << QVector<int>({100, 103, 106}) << QVector<int>({2, 2, 2});
+    QTest::newRow("whole words") << "cat" << true << true << "cat concat cat1 cat." << QVector<int>({100, 116}) << QVector<int>({3, 3});
+    QTest::newRow("empty matches skipped") << "x*" << true << false << "ab xx c" << QVector<int>({103}) << QVector<int>({2});
+    QTest::newRow("surrogate pair") << "b" << true << false << QString::fromUtf8("\xF0\x9F\x98\x80" "b") << QVector<int>({102}) << QVector<int>({1});
+}
+
+
+/* Matches are reported at their position in the document, which the line starts 100 characters into.
+ */
+void TestRegexSearcher::findInLine()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, caseSensitive);
+    QFETCH(bool, wholeWords);
+    QFETCH(QString, line);
+    QFETCH(QVector<int>, starts);
+    QFETCH(QVector<int>, lengths);
+
+    RegexSearcher searcher(pattern, caseSensitive, wholeWords);
+    searcher.setReplacement("<\\0>");
+    RegexMatchBatch batch;
+
+    QCOMPARE(searcher.findInLine(line, 100, batch, true, QDeadlineTimer(QDeadlineTimer::Forever)), RegexSearcher::Searched);
+    QCOMPARE(batch.starts, starts);
+    QCOMPARE(batch.lengths, lengths);
+    QCOMPARE(batch.replacements.size(), starts.size());
+
+    QRegularExpressionMatch match;
+    QCOMPARE(searcher.findFirstInLine(line, 0, match, QDeadlineTimer(QDeadlineTimer::Forever)), RegexSearcher::Searched);
+    QCOMPARE(match.hasMatch() ? match.capturedStart() + 100 : -1, starts.isEmpty() ? -1 : starts.first());
+}
+
+
+/* A pattern that backtracks catastrophically runs out of steps instead of hanging.
+ */
+void TestRegexSearcher::givesUpOnCatastrophicLines()
+{
+    RegexSearcher searcher("(a+)+$", true, false);
+    RegexMatchBatch batch;
+
+    QCOMPARE(searcher.findInLine(QString(40, 'a') + "b", 0, batch, false, QDeadlineTimer(QDeadlineTimer::Forever)), RegexSearcher::OutOfSteps);
+    QVERIFY(batch.starts.isEmpty());
+
+    // Each position of this line takes well under the step limit, but matching all of it in one call took seconds
+    RegexSearcher quadratic("(?:a|b)*\\d", true, false);
+    QElapsedTimer timer;
+    timer.start();
+    QCOMPARE(quadratic.findInLine(QString(20000, 'a'), 0, batch, false, QDeadlineTimer(QDeadlineTimer::Forever)), RegexSearcher::OutOfSteps);
+    QVERIFY2(timer.elapsed() < 1000, qPrintable(QString("took %1 ms").arg(timer.elapsed())));
+}
+
+
+/* An expired deadline stops a search before it tries anything.
+ */
+void TestRegexSearcher::stopsAtDeadline()
+{
+    RegexSearcher searcher("a", true, false);
+    RegexMatchBatch batch;
+
+    QCOMPARE(searcher.findInLine(QString(1000, 'a'), 0, batch, false, QDeadlineTimer(0)), RegexSearcher::OutOfTime);
+    QVERIFY(batch.starts.isEmpty());
+
+    QRegularExpressionMatch match;
+    QCOMPARE(searcher.findFirstInLine("a", 0, match, QDeadlineTimer(0)), RegexSearcher::OutOfTime);
+    QVERIFY(!match.hasMatch());
+}
+
+
+/* A pattern that takes a few hundred steps at every position of a 4 million character line takes seconds
+ * to search all of it, but each window of the line stays well within the step limit. The search has to
+ * stop at the deadline anyway, partway through the line.
+ */
+void TestRegexSearcher::stopsAtDeadlineWithinLine()
+{
+    RegexSearcher searcher("(?:a|b){0,200}\\d", true, false);
+    QString line(4000000, 'a');
+    RegexMatchBatch batch;
+    QElapsedTimer timer;
+
+    timer.start();
+    QCOMPARE(searcher.findInLine(line, 0, batch, false, QDeadlineTimer(100)), RegexSearcher::OutOfTime);
+    QVERIFY2(timer.elapsed() < 1000, qPrintable(QString("took %1 ms").arg(timer.elapsed())));
+
+    QRegularExpressionMatch match;
+    timer.restart();
+    QCOMPARE(searcher.findFirstInLine(line, 0, match, QDeadlineTimer(100)), RegexSearcher::OutOfTime);
+    QVERIFY2(timer.elapsed() < 1000, qPrintable(QString("took %1 ms").arg(timer.elapsed())));
+}
+
+
+/* Searching a window at a time finds the same matches as matching the whole line would, including
+ * ones that start near the end of a window or run past it, and ones next to surrogate pairs.
+ */
+void TestRegexSearcher::windowsFindEveryMatch()
+{
+    const QString alphabet = QString("ab ") + QString::fromUtf8("\xF0\x9F\x98\x80");
+    std::mt19937 random(2023);
+    QString line;
+
+    while (line.length() < 5 * RegexSearcher::WINDOW_LENGTH)
+    {
+        int index = static_cast<int>(random() % 4);
+        line += index == 3 ? alphabet.mid(3, 2) : alphabet.mid(index, 1);
+    }
+
+    for (const QString &pattern : {QString("ab+a"), QString("b\\S"), QString("(?<=a)b*"), QString("a{3,}"), QString("[^ ]{8}")})
+    {
+        RegexSearcher searcher(pattern, true, false);
+        RegexMatchBatch batch;
+        QCOMPARE(searcher.findInLine(line, 0, batch, false, QDeadlineTimer(QDeadlineTimer::Forever)), RegexSearcher::Searched);
+
+        QVector<int> starts;
+        QRegularExpressionMatchIterator matches = QRegularExpression(pattern).globalMatch(line);
+        while (matches.hasNext())
+        {
+            QRegularExpressionMatch match = matches.next();
+            if (match.capturedLength() > 0)
+            {
+                starts.append(match.capturedStart());
+            }
+        }
+
+        QCOMPARE(batch.starts, starts);
+    }
+}
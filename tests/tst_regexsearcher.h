@@ -0,0 +1,23 @@
+#ifndef TST_REGEXSEARCHER_H
+#define TST_REGEXSEARCHER_H
+#include <QObject>
+
+
+/* Checks how regular expressions are matched line by line and how replacements are expanded.
+ */
+class TestRegexSearcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replacementFor_data();
+    void replacementFor();
+    void findInLine_data();
+    void findInLine();
+    void givesUpOnCatastrophicLines();
+    void stopsAtDeadline();
+    void stopsAtDeadlineWithinLine();
+    void windowsFindEveryMatch();
+};
+
+#endif // TST_REGEXSEARCHER_H
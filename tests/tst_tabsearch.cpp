@@ -0,0 +1,119 @@
+#include "tst_tabsearch.h"
+#include "tabsearch.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+
+/* There are more tabs than threads, so most of them are only snapshotted once others are done.
+ */
+void TestTabSearch::searchesEveryTab()
+{
+    QVector<Editor*> tabs;
+    int numTabs = 2 * QThread::idealThreadCount() + 1;
+
+    for (int i = 0; i < numTabs; i++)
+    {
+        tabs.append(new Editor());
+        tabs.last()->setPlainText(QString("match\n").repeated(i) + "no hit here");
+    }
+
+    TabSearch search(tabs, "match", QString(), true, true, false, false);
+    QSignalSpy searched(&search, SIGNAL(tabSearched(int)));
+    QSignalSpy done(&search, SIGNAL(done()));
+    search.start();
+
+    QTRY_COMPARE(done.count(), 1);
+    QCOMPARE(searched.count(), numTabs);
+
+    for (int i = 0; i < numTabs; i++)
+    {
+        QCOMPARE(search.matchesIn(i).starts.size(), i);
+        QCOMPARE(search.matchesIn(i).listed.size(), i);
+        QVERIFY(!search.matchesIn(i).replaced);
+    }
+
+    qDeleteAll(tabs);
+}
+
+
+/* Each tab's matches are replaced (groups and all) in one edit of its own, undone on its own.
+ */
+void TestTabSearch::replacesEachTabInOneStep()
+{
+    const QStringList texts = {"alice@home, bob@work", "nobody", "carol@lab\ndave@sea"};
+    QVector<Editor*> tabs;
+
+    for (const QString &text : texts)
+    {
+        tabs.append(new Editor());
+        tabs.last()->setPlainText(text);
+    }
+
+    TabSearch search(tabs, "(\\w+)@(\\w+)", "\\2:\\1", true, false, true, true);
+    QSignalSpy done(&search, SIGNAL(done()));
+    search.start();
+    QTRY_COMPARE(done.count(), 1);
+
+    QCOMPARE(tabs[0]->toPlainText(), QString("home:alice, work:bob"));
+    QCOMPARE(tabs[1]->toPlainText(), QString("nobody"));
+    QCOMPARE(tabs[2]->toPlainText(), QString("lab:carol\nsea:dave"));
+    QVERIFY(search.matchesIn(0).replaced);
+    QVERIFY(!search.matchesIn(1).replaced);
+
+    tabs[2]->document()->undo();
+    QCOMPARE(tabs[2]->toPlainText(), texts[2]);
+    QCOMPARE(tabs[0]->toPlainText(), QString("home:alice, work:bob"));
+
+    qDeleteAll(tabs);
+}
+
+
+/* A tab closed before its turn comes is reported without being searched.
+ */
+void TestTabSearch::skipsClosedTabs()
+{
+    QVector<Editor*> tabs;
+
+    for (int i = 0; i < 2 * QThread::idealThreadCount() + 2; i++)
+    {
+        tabs.append(new Editor());
+        tabs.last()->setPlainText("match");
+    }
+
+    TabSearch search(tabs, "match", QString(), true, false, false, false);
+    QSignalSpy done(&search, SIGNAL(done()));
+    delete tabs.takeLast();
+    search.start();
+
+    QTRY_COMPARE(done.count(), 1);
+    QCOMPARE(search.matchesIn(search.numTabs() - 1).starts.size(), 0);
+    QCOMPARE(search.matchesIn(0).starts.size(), 1);
+
+    qDeleteAll(tabs);
+}
+
+
+/* Deleting a search while a tab's long line is still being searched returns right away, and the
+ * task that's left to finish in the background doesn't report to the deleted search.
+ */
+void TestTabSearch::cancelingDoesNotWait()
+{
+    Editor *tab = new Editor();
+    tab->setPlainText(QString(4000000, 'a'));
+
+    TabSearch *search = new TabSearch({tab}, "(?:a|b){0,200}\\d", QString(), true, false, true, false);
+    search->start();
+
+    QElapsedTimer timer;
+    timer.start();
+    delete search;
+    QVERIFY2(timer.elapsed() < TabSearch::LINE_TIMEOUT / 2, qPrintable(QString("took %1 ms").arg(timer.elapsed())));
+
+    QVERIFY(QThreadPool::globalInstance()->waitForDone(2 * TabSearch::LINE_TIMEOUT));
+    QCoreApplication::processEvents();
+
+    delete tab;
+}
@@ -0,0 +1,19 @@
+#ifndef TST_TABSEARCH_H
+#define TST_TABSEARCH_H
+#include <QObject>
+
+
+/* Checks searching and replacing in every open tab at once.
+ */
+class TestTabSearch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void searchesEveryTab();
+    void replacesEachTabInOneStep();
+    void skipsClosedTabs();
+    void cancelingDoesNotWait();
+};
+
+#endif // TST_TABSEARCH_H
@@ -0,0 +1,201 @@
+#include "tst_textsearcher.h"
+#include "textsearcher.h"
+#include "editor.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <random>
+
+
+/* Returns the positions of the non-overlapping matches of the query in the text, found the slow way.
+ */
+QVector<int> TestTextSearcher::naiveFindAll(const QString &text, const QString &query, Qt::CaseSensitivity caseSensitivity)
+{
+    QVector<int> matches;
+
+    for (int i = text.indexOf(query, 0, caseSensitivity); i != -1; i = text.indexOf(query, i + query.length(), caseSensitivity))
+    {
+        matches.append(i);
+    }
+
+    return matches;
+}
+
+
+/* Returns text of the given length made of characters drawn at random from the alphabet.
+ */
+QString TestTextSearcher::randomText(int length, const QString &alphabet, unsigned seed)
+{
+    std::mt19937 random(seed);
+    QString text;
+
+    for (int i = 0; i < length; i++)
+    {
+        text += alphabet.at(static_cast<int>(random() % static_cast<unsigned>(alphabet.length())));
+    }
+
+    return text;
+}
+
+
+void TestTextSearcher::findAll_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<bool>("caseSensitive");
+    QTest::addColumn<bool>("wholeWords");
+    QTest::addColumn<QVector<int>>("matches");
+
+    QTest::newRow("empty query") << "abc" << "" << true << false << QVector<int>();
+    QTest::newRow("longer than text") << "ab" << "abc" << true << false << QVector<int>();
+    QTest::newRow("one character") << "a.b.c" << "." << true << false << QVector<int>({1, 3});
+    QTest::newRow("not overlapping") << "aaaaa" << "aa" << true << false << QVector<int>({0, 2});
+    QTest::newRow("at both ends") << "abxxab" << "ab" << true << false << QVector<int>({0, 4});
+    QTest::newRow("case sensitive") << "Word word WORD" << "word" << true << false << QVector<int>({5});
+    QTest::newRow("case insensitive") << "Word word WORD" << "word" << false << false << QVector<int>({0, 5, 10});
+    QTest::newRow("whole words") << "cat concat cat1 (cat)" << "cat" << true << true << QVector<int>({0, 17});
+    QTest::newRow("whole word, one character") << "a ab a" << "a" << true << true << QVector<int>({0, 5});
+    QTest::newRow("shared low byte") << QString("x") + QChar(0x0162) + "bb" << "bb" << true << false << QVector<int>({2});
+    QTest::newRow("surrogate pair") << QString::fromUtf8("\xF0\x9F\x98\x80!\xF0\x9F\x98\x80") << QString::fromUtf8("\xF0\x9F\x98\x80") << true << false << QVector<int>({0, 3});
+}
+
+
+void TestTextSearcher::findAll()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, query);
+    QFETCH(bool, caseSensitive);
+    QFETCH(bool, wholeWords);
+    QFETCH(QVector<int>, matches);
+
+    QCOMPARE(TextSearcher(query, caseSensitive, wholeWords).findAll(text), matches);
+}
+
+
+/* Searches a long run of random text over a small alphabet, where windows often almost match,
+ * for queries of every length, and checks the matches against QString::indexOf.
+ */
+void TestTextSearcher::findAllMatchesIndexOf()
+{
+    std::mt19937 random(2019);
+    QString text = randomText(20000, "abAB \n", 2019);
+
+    for (int length = 1; length <= 6; length++)
+    {
+        QString query = text.mid(static_cast<int>(random() % 1000), length);
+
+        QCOMPARE(TextSearcher(query, true, false).findAll(text), naiveFindAll(text, query, Qt::CaseSensitive));
+        QCOMPARE(TextSearcher(query, false, false).findAll(text), naiveFindAll(text, query, Qt::CaseInsensitive));
+    }
+}
+
+
+void TestTextSearcher::filterPathsAgree_data()
+{
+    QTest::addColumn<int>("path");
+
+    QTest::newRow("scalar") << static_cast<int>(TextSearcher::ScalarFilter);
+    QTest::newRow("SSE2") << static_cast<int>(TextSearcher::Sse2Filter);
+    QTest::newRow("AVX2") << static_cast<int>(TextSearcher::Avx2Filter);
+}
+
+
+/* Every way of finding candidates finds the same matches, including ones in the last few
+ * windows, which the SIMD paths leave to the scalar one.
+ */
+void TestTextSearcher::filterPathsAgree()
+{
+    QFETCH(int, path);
+
+    TextSearcher::FilterPath defaultPath = TextSearcher::filterPath();
+    if (!TextSearcher::useFilterPath(static_cast<TextSearcher::FilterPath>(path)))
+    {
+        QSKIP("This path isn't available on this build or CPU");
+    }
+
+    std::mt19937 random(2021);
+    for (int size = 0; size < 70; size++)
+    {
+        QString text = randomText(size, "ab", static_cast<unsigned>(size));
+
+        for (int length = 2; length <= 5; length++)
+        {
+            QString query = randomText(length, "ab", random());
+            QCOMPARE(TextSearcher(query, true, false).findAll(text), naiveFindAll(text, query, Qt::CaseSensitive));
+        }
+    }
+
+    QString text = randomText(20000, "abAB \n", 2021);
+    for (int length = 2; length <= 8; length++)
+    {
+        QString query = text.mid(static_cast<int>(random() % 1000), length);
+        QCOMPARE(TextSearcher(query, false, false).findAll(text), naiveFindAll(text, query, Qt::CaseInsensitive));
+    }
+
+    TextSearcher::useFilterPath(defaultPath);
+}
+
+
+void TestTextSearcher::nearMissesFallBackToTwoWay_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("query");
+
+    QString as = QString(100000, 'a');
+    QTest::newRow("no match") << as << QString(500, 'a') + "ba";
+    QTest::newRow("match at the end") << as + "b" << QString(500, 'a') + "b";
+    QTest::newRow("periodic query") << as + "b" + as << QString(300, 'a');
+    QTest::newRow("periodic, broken runs") << QString("aab").repeated(30000) << QString("aab").repeated(50) + "aa";
+}
+
+
+/* Text that keeps almost matching takes Horspool time proportional to its length times the query's,
+ * so the search falls back to Two-Way. The matches have to be the same either way.
+ */
+void TestTextSearcher::nearMissesFallBackToTwoWay()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, query);
+
+    QCOMPARE(TextSearcher(query, true, false).findAll(text), naiveFindAll(text, query, Qt::CaseSensitive));
+
+    // Only the copy of the query after the space is a whole word, and the ones before it are turned down in Two-Way
+    QCOMPARE(TextSearcher(query, true, true).findAll(text + " " + query), QVector<int>({text.length() + 1}));
+}
+
+
+/* Replace All changes the document in one edit block: the document reports a single change,
+ * and one undo puts back every match.
+ */
+void TestTextSearcher::replaceAllIsOneEdit()
+{
+    const QString original = "one cat\ncat cat cat\nno match here\n\ncat";
+
+    Editor editor;
+    editor.setPlainText(original);
+    int undoStepsBefore = editor.document()->availableUndoSteps();
+    QSignalSpy changes(editor.document(), SIGNAL(contentsChange(int, int, int)));
+
+    editor.replaceAll("cat", "tiger", true, false);
+
+    QCOMPARE(editor.toPlainText(), QString("one tiger\ntiger tiger tiger\nno match here\n\ntiger"));
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(editor.document()->availableUndoSteps(), undoStepsBefore + 1);
+
+    editor.document()->undo();
+    QCOMPARE(editor.toPlainText(), original);
+}
+
+
+/* Matches of different lengths, with different replacements, several to a line.
+ */
+void TestTextSearcher::replaceMatches()
+{
+    Editor editor;
+    editor.setPlainText("a=1, bb=22\nccc=333");
+
+    editor.replaceMatches({0, 5, 11}, {3, 5, 7}, {"x", "", "yes"});
+    QCOMPARE(editor.toPlainText(), QString("x, \nyes"));
+
+    editor.document()->undo();
+    QCOMPARE(editor.toPlainText(), QString("a=1, bb=22\nccc=333"));
+}
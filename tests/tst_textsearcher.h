@@ -0,0 +1,30 @@
+#ifndef TST_TEXTSEARCHER_H
+#define TST_TEXTSEARCHER_H
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+
+/* Checks TextSearcher's matches, and that Replace All changes the document in one undoable edit.
+ */
+class TestTextSearcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findAll_data();
+    void findAll();
+    void findAllMatchesIndexOf();
+    void filterPathsAgree_data();
+    void filterPathsAgree();
+    void nearMissesFallBackToTwoWay_data();
+    void nearMissesFallBackToTwoWay();
+    void replaceAllIsOneEdit();
+    void replaceMatches();
+
+private:
+    static QString randomText(int length, const QString &alphabet, unsigned seed);
+    static QVector<int> naiveFindAll(const QString &text, const QString &query, Qt::CaseSensitivity caseSensitivity);
+};
+
+#endif // TST_TEXTSEARCHER_H